@@ -1,4 +1,2 @@
 make
-cd bin || exit
-./space_invaders_arcade.exe
-cd ..
\ No newline at end of file
+./bin/space_invaders_arcade.exe
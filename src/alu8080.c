@@ -0,0 +1,220 @@
+/***********************************************************************************
+ *
+ * Source for the table-driven 8080 ALU
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "alu8080.h"
+#include "shell8080.h"
+#include "instructions.h"
+#include "opcodeSpec.h"
+
+// Parity of every byte, 1 for an odd number of set bits
+#define PARITY_2(n) (n), (n)^1, (n)^1, (n)
+#define PARITY_4(n) PARITY_2(n), PARITY_2((n)^1), PARITY_2((n)^1), PARITY_2(n)
+#define PARITY_6(n) PARITY_4(n), PARITY_4((n)^1), PARITY_4((n)^1), PARITY_4(n)
+const uint8_t oddParityTable[256] = {PARITY_6(0), PARITY_6(1), PARITY_6(1), PARITY_6(0)};
+
+void (*const aluOperations[8])(uint8_t data, State8080 *state) = {
+    aluAdd, aluAddWithCarry, aluSubtract, aluSubtractWithBorrow, aluAnd, aluXor, aluOr, aluCompare
+};
+
+void setResultFlags(uint8_t result, State8080 *state);
+uint8_t subtractFromAccumulator(uint8_t subtrahend, State8080 *state);
+
+void aluAdd(uint8_t data, State8080 *state)
+{
+    uint16_t sum = (uint16_t)(state->a) + data;
+    state->flags.auxiliaryCarry = ((state->a & 0x0f) + (data & 0x0f)) > 0x0f;
+    state->flags.carry = sum > 0xff;
+    state->a = (uint8_t)sum;
+    setResultFlags(state->a, state);
+}
+
+void aluAddWithCarry(uint8_t data, State8080 *state)
+{
+    // Auxiliary carry only looks at the low nibble of data+CY, which is 0 when data is 0xff and CY is set
+    uint8_t addend = data + state->flags.carry;
+    uint16_t sum = (uint16_t)(state->a) + data + state->flags.carry;
+    state->flags.auxiliaryCarry = ((state->a & 0x0f) + (addend & 0x0f)) > 0x0f;
+    state->flags.carry = sum > 0xff;
+    state->a = (uint8_t)sum;
+    setResultFlags(state->a, state);
+}
+
+void aluSubtract(uint8_t data, State8080 *state)
+{
+    state->a = subtractFromAccumulator(data, state);
+}
+
+void aluSubtractWithBorrow(uint8_t data, State8080 *state)
+{
+    // data+CY wraps to 0 when data is 0xff and CY is set, leaving A unchanged and clearing CY
+    state->a = subtractFromAccumulator((uint8_t)(data + state->flags.carry), state);
+}
+
+void aluAnd(uint8_t data, State8080 *state)
+{
+    state->a &= data;
+    state->flags.carry = 0;
+    state->flags.auxiliaryCarry = 0;
+    setResultFlags(state->a, state);
+}
+
+void aluXor(uint8_t data, State8080 *state)
+{
+    state->a ^= data;
+    state->flags.carry = 0;
+    state->flags.auxiliaryCarry = 0;
+    setResultFlags(state->a, state);
+}
+
+void aluOr(uint8_t data, State8080 *state)
+{
+    state->a |= data;
+    state->flags.carry = 0;
+    state->flags.auxiliaryCarry = 0;
+    setResultFlags(state->a, state);
+}
+
+void aluCompare(uint8_t data, State8080 *state)
+{
+    subtractFromAccumulator(data, state);
+}
+
+uint8_t aluOperationResult(uint8_t operation, uint8_t data, const State8080 *state)
+{
+    switch(operation){
+        case ALU_ADD:
+            return state->a + data;
+        case ALU_ADC:
+            return state->a + data + state->flags.carry;
+        case ALU_SBB:
+            return state->a - (uint8_t)(data + state->flags.carry);
+        case ALU_ANA:
+            return state->a & data;
+        case ALU_XRA:
+            return state->a ^ data;
+        case ALU_ORA:
+            return state->a | data;
+        default:
+            // SUB and CMP
+            return state->a - data;
+    }
+}
+
+uint8_t aluOperationCarry(uint8_t operation, uint8_t data, const State8080 *state)
+{
+    switch(operation){
+        case ALU_ADD:
+            return ((uint16_t)(state->a) + data) > 0xff;
+        case ALU_ADC:
+            return ((uint16_t)(state->a) + data + state->flags.carry) > 0xff;
+        case ALU_SBB:
+            return state->a < (uint8_t)(data + state->flags.carry);
+        case ALU_SUB:
+        case ALU_CMP:
+            return state->a < data;
+        default:
+            // Logical operations clear the carry
+            return 0;
+    }
+}
+
+void aluIncrement(uint8_t *reg, State8080 *state)
+{
+    state->flags.auxiliaryCarry = (*reg & 0x0f) == 0x0f;
+    *reg += 1;
+    setResultFlags(*reg, state);
+}
+
+void aluDecrement(uint8_t *reg, State8080 *state)
+{
+    // Decrementing adds 0xff, which carries out of the low nibble unless it is 0
+    state->flags.auxiliaryCarry = (*reg & 0x0f) != 0x00;
+    *reg -= 1;
+    setResultFlags(*reg, state);
+}
+
+void aluDecimalAdjust(State8080 *state)
+{
+    uint8_t a = state->a;
+    if((a & 0x0f) > 9 || state->flags.auxiliaryCarry){
+        state->flags.auxiliaryCarry = ((a & 0x0f) + 0x06) > 0x0f;
+        a += 0x06;
+    }else{
+        state->flags.auxiliaryCarry = 0;
+    }
+
+    // The carry out of the high digit is kept, the carry flag is never cleared
+    uint8_t upperNibble = a>>4;
+    if(upperNibble > 9 || state->flags.carry){
+        upperNibble += 6;
+        if(upperNibble > 0x0f){
+            state->flags.carry = 1;
+        }
+        a = (a & 0x0f) | (uint8_t)(upperNibble<<4);
+    }
+
+    state->a = a;
+    setResultFlags(a, state);
+}
+
+void executeAluInstruction(uint8_t opcode, uint8_t *operands, State8080 *state)
+{
+    uint8_t *registers[8] = {&(state->b), &(state->c), &(state->d), &(state->e), &(state->h), &(state->l), NULL, &(state->a)};
+    uint8_t operation = (opcode>>3) & 0x07;
+    uint8_t source = opcode & 0x07;
+
+    if(opcode >= 0x80 && opcode <= 0xbf && opcode != 0x8e){
+        if(source == 0x06){
+            aluOperations[operation](readMem(getValueHL(state), state), state);
+            state->pc += 1;
+        }else{
+            aluOperations[operation](*registers[source], state);
+            state->pc += 1;
+        }
+    }else if(opcode >= 0xc0 && source == 0x06){
+        aluOperations[operation](operands[0], state);
+        state->pc += 2;
+    }else if(opcode < 0x40 && source == 0x04 && operation != 0x06){
+        aluIncrement(registers[operation], state);
+        state->pc += 1;
+    }else if(opcode < 0x40 && source == 0x05 && operation != 0x06){
+        aluDecrement(registers[operation], state);
+        state->pc += 1;
+    }else if(opcode == 0x27){
+        aluDecimalAdjust(state);
+        state->pc += 1;
+    }else{
+        executeInstructionByOpcode(opcode, operands, state);
+        return;
+    }
+    state->cyclesCompleted += instructionCycles[opcode];
+}
+
+/**
+ * Sets the zero, sign and parity flags for a result
+ */
+void setResultFlags(uint8_t result, State8080 *state)
+{
+    state->flags.zero = (result == 0);
+    state->flags.sign = result>>7;
+    state->flags.parity = !oddParityTable[result];
+}
+
+/**
+ * Subtracts from the accumulator without storing the difference, setting the flags as SUB and CMP do
+ * @return - The difference
+ */
+uint8_t subtractFromAccumulator(uint8_t subtrahend, State8080 *state)
+{
+    // Auxiliary carry comes from adding the two's complement of the subtrahend, carry is set on a borrow
+    uint8_t difference = state->a - subtrahend;
+    state->flags.auxiliaryCarry = ((state->a & 0x0f) + ((uint8_t)(-subtrahend) & 0x0f)) > 0x0f;
+    state->flags.carry = state->a < subtrahend;
+    setResultFlags(difference, state);
+
+    return difference;
+}
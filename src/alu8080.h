@@ -0,0 +1,93 @@
+/***********************************************************************************
+ *
+ * Header for the table-driven 8080 ALU.
+ *
+ * A faster implementation of the arithmetic and logic instructions, used by the
+ * predecoded CPU engine. Carry and auxiliary carry are computed directly from the sums,
+ * and parity is looked up in a table rather than counted bit by bit. Results must match
+ * the instructions in instructions.c exactly, including their quirks, which is checked
+ * over every input by src/aluTest.c.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_ALU8080_H
+#define INTEL_8080_EMULATOR_ALU8080_H
+
+#include "cpuStructures.h"
+
+// ALU operations, as encoded in bits 3-5 of the opcode
+#define ALU_ADD 0
+#define ALU_ADC 1
+#define ALU_SUB 2
+#define ALU_SBB 3
+#define ALU_ANA 4
+#define ALU_XRA 5
+#define ALU_ORA 6
+#define ALU_CMP 7
+
+/**
+ * ALU operations by number, each combining a byte with the accumulator and setting the flags.
+ * The program counter and cycle count are left to the caller.
+ */
+extern void (*const aluOperations[8])(uint8_t data, State8080 *state);
+
+void aluAdd(uint8_t data, State8080 *state);
+void aluAddWithCarry(uint8_t data, State8080 *state);
+void aluSubtract(uint8_t data, State8080 *state);
+void aluSubtractWithBorrow(uint8_t data, State8080 *state);
+void aluAnd(uint8_t data, State8080 *state);
+void aluXor(uint8_t data, State8080 *state);
+void aluOr(uint8_t data, State8080 *state);
+void aluCompare(uint8_t data, State8080 *state);
+
+/**
+ * Computes what an ALU operation leaves in the accumulator, or the difference for CMP, without setting any flags.
+ * The zero flag the operation would set is whether the result is 0.
+ * @param operation - The ALU operation
+ * @param data - The byte combined with the accumulator
+ * @param state - The 8080 state, left unchanged
+ * @return - The result
+ */
+uint8_t aluOperationResult(uint8_t operation, uint8_t data, const State8080 *state);
+
+/**
+ * Computes the carry flag an ALU operation would set, without carrying it out
+ * @param operation - The ALU operation
+ * @param data - The byte combined with the accumulator
+ * @param state - The 8080 state, left unchanged
+ * @return - The carry flag
+ */
+uint8_t aluOperationCarry(uint8_t operation, uint8_t data, const State8080 *state);
+
+/**
+ * Increments a register, setting every flag but carry
+ * @param reg - The register
+ * @param state - The 8080 state
+ */
+void aluIncrement(uint8_t *reg, State8080 *state);
+
+/**
+ * Decrements a register, setting every flag but carry
+ * @param reg - The register
+ * @param state - The 8080 state
+ */
+void aluDecrement(uint8_t *reg, State8080 *state);
+
+/**
+ * Adjusts the accumulator to two binary coded decimal digits, as DAA does
+ * @param state - The 8080 state
+ */
+void aluDecimalAdjust(State8080 *state);
+
+/**
+ * Executes an instruction, as executeInstructionByOpcode does, with the ALU instructions
+ * on registers, memory and immediates going through the table-driven ALU.
+ * ADC M, INR M and DCR M are left to executeInstructionByOpcode.
+ * @param opcode - The instruction's opcode
+ * @param operands - The instruction's operand bytes
+ * @param state - The 8080 state
+ */
+void executeAluInstruction(uint8_t opcode, uint8_t *operands, State8080 *state);
+
+#endif //INTEL_8080_EMULATOR_ALU8080_H
@@ -0,0 +1,371 @@
+/***********************************************************************************
+ *
+ * Exhaustive ALU equivalence check.
+ *
+ * Every arithmetic and logic instruction is run on every combination of accumulator,
+ * operand, carry and auxiliary carry, once through the reference implementation
+ * (executeInstructionByOpcode) and once through each optimized variant, and the resulting
+ * registers, flags, program counter and cycle counts are compared. Variants computing only
+ * some flags are compared on those flags alone. Opcodes are shared out
+ * between worker threads. Any input that gives different results is printed.
+ *
+ * Usage: alu_test [--threads N]
+ * --threads N  Number of worker threads, 0 for one per CPU core (default)
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "shell8080.h"
+#include "alu8080.h"
+#include "instructions.h"
+#include "helpers.h"
+#include "romAnalysis.h"
+#include "sdl_sources/SDL.h"
+
+#define MAX_ALU_TEST_THREADS 64
+#define ALU_TEST_MEMORY_ADDRESS 0x2000  // HL points here for the memory operand forms
+#define ALU_TEST_PC 0x1000
+#define NUM_ALU_INPUTS (256*256*2*2)  // Accumulator, operand, carry and auxiliary carry
+
+/**
+ * An implementation of 8080 instructions to check against the reference
+ */
+typedef struct AluVariant{
+    const char *name;
+    void (*execute)(uint8_t opcode, uint8_t *operands, State8080 *state);
+    uint8_t flagsChecked;  /**< Flags the variant computes, as opcodeSpec.h masks */
+} AluVariant;
+
+void executeLiveFlagsInstruction(uint8_t opcode, uint8_t *operands, State8080 *state);
+
+const AluVariant aluVariants[] = {
+    {"table", executeAluInstruction, ALL_FLAGS},
+    {"liveflags", executeLiveFlagsInstruction, FLAG_ZERO | FLAG_CARRY}
+};
+
+/**
+ * Outcome of checking one opcode against one variant
+ */
+typedef struct AluCase{
+    const AluVariant *variant;
+    uint8_t opcode;
+    uint32_t numMismatches;
+    uint32_t firstMismatch;  /**< Input of the first mismatch, as packed by setAluInput */
+    State8080 expected;  /**< Reference result for the first mismatch */
+    State8080 actual;  /**< Variant result for the first mismatch */
+} AluCase;
+
+/**
+ * A worker thread and the CPUs it runs instructions on
+ */
+typedef struct AluWorker{
+    SDL_Thread *thread;
+    State8080 *reference;
+    State8080 *candidate;
+    AluCase *cases;
+    uint32_t numCases;
+    SDL_atomic_t *nextCase;  /**< Next case not yet taken by any worker */
+} AluWorker;
+
+uint32_t listAluCases(AluCase *cases);
+bool isAluOpcode(uint8_t opcode);
+int runAluWorker(void *data);
+void checkAluCase(AluWorker *worker, AluCase *aluCase);
+uint8_t *getOperandRegister(State8080 *state, uint8_t opcode);
+void setAluInput(State8080 *state, uint8_t *operandRegister, uint32_t input, uint8_t *operands);
+bool statesMatch(const State8080 *expected, const State8080 *actual, uint8_t flagsChecked);
+void printAluState(const char *name, const State8080 *state);
+
+int main(int argc, char **argv)
+{
+    unsigned int numThreads = 0;
+    for(int argNum = 1; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--threads") == 0 && argNum+1 < argc){
+            argNum++;
+            numThreads = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else{
+            logger("Usage: %s [--threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(numThreads == 0){
+        numThreads = (unsigned int)SDL_GetCPUCount();
+    }
+    if(numThreads > MAX_ALU_TEST_THREADS){
+        numThreads = MAX_ALU_TEST_THREADS;
+    }
+    if(numThreads == 0){
+        numThreads = 1;
+    }
+
+    unsigned int numVariants = sizeof(aluVariants)/sizeof(aluVariants[0]);
+    AluCase *cases = mallocSet(256*numVariants*sizeof(AluCase));
+    uint32_t numCases = listAluCases(cases);
+
+    // CPUs are created up front, as initializing a CPU is not safe to do from several threads at once
+    uint8_t *emptyRom = mallocSet(ROM_LIMIT_8080);
+    SDL_atomic_t nextCase;
+    SDL_AtomicSet(&nextCase, 0);
+    AluWorker *workers = mallocSet(numThreads*sizeof(AluWorker));
+    for(unsigned int workerNum = 0; workerNum < numThreads; workerNum++){
+        workers[workerNum].reference = initializeCPU(emptyRom);
+        workers[workerNum].candidate = initializeCPU(emptyRom);
+        workers[workerNum].cases = cases;
+        workers[workerNum].numCases = numCases;
+        workers[workerNum].nextCase = &nextCase;
+    }
+    free(emptyRom);
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int workerNum = 0; workerNum < numThreads; workerNum++){
+        workers[workerNum].thread = SDL_CreateThread(runAluWorker, "AluTest", &(workers[workerNum]));
+        if(workers[workerNum].thread == NULL){
+            // The remaining workers pick up the cases this one would have taken
+            logger("Failed to start ALU test thread! SDL Error: %s\n", SDL_GetError());
+        }
+    }
+    for(unsigned int workerNum = 0; workerNum < numThreads; workerNum++){
+        if(workers[workerNum].thread != NULL){
+            SDL_WaitThread(workers[workerNum].thread, NULL);
+        }
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter()-startTicks)/(double)SDL_GetPerformanceFrequency();
+
+    // Every case is taken exactly once, unless no thread could be started at all
+    if(SDL_AtomicGet(&nextCase) < (int)numCases){
+        runAluWorker(&(workers[0]));
+    }
+
+    uint32_t numFailedCases = 0;
+    for(uint32_t caseNum = 0; caseNum < numCases; caseNum++){
+        AluCase *aluCase = &(cases[caseNum]);
+        if(aluCase->numMismatches == 0){
+            continue;
+        }
+        numFailedCases++;
+        uint32_t input = aluCase->firstMismatch;
+        printf("FAIL %s opcode 0x%02x: %u of %u inputs differ, first with A 0x%02x operand 0x%02x CY %u AC %u\n",
+               aluCase->variant->name, aluCase->opcode, aluCase->numMismatches, NUM_ALU_INPUTS,
+               (input>>10) & 0xff, (input>>2) & 0xff, (input>>1) & 1, input & 1);
+        printAluState("reference", &(aluCase->expected));
+        printAluState(aluCase->variant->name, &(aluCase->actual));
+    }
+
+    printf("%u of %u opcode and variant pairs matched over %llu inputs in %.2f s on %u threads\n",
+           numCases-numFailedCases, numCases, (unsigned long long)numCases*NUM_ALU_INPUTS, seconds, numThreads);
+
+    for(unsigned int workerNum = 0; workerNum < numThreads; workerNum++){
+        destroyCPU(workers[workerNum].reference);
+        destroyCPU(workers[workerNum].candidate);
+    }
+    free(workers);
+    free(cases);
+
+    return (numFailedCases == 0) ? 0 : 1;
+}
+
+/**
+ * Lists every ALU opcode for every variant
+ * @param cases - Room for 256 cases per variant
+ * @return - Number of cases listed
+ */
+uint32_t listAluCases(AluCase *cases)
+{
+    unsigned int numVariants = sizeof(aluVariants)/sizeof(aluVariants[0]);
+    uint32_t numCases = 0;
+
+    for(unsigned int variantNum = 0; variantNum < numVariants; variantNum++){
+        for(unsigned int opcode = 0; opcode < 256; opcode++){
+            if(isAluOpcode((uint8_t)opcode)){
+                cases[numCases].variant = &(aluVariants[variantNum]);
+                cases[numCases].opcode = (uint8_t)opcode;
+                numCases++;
+            }
+        }
+    }
+
+    return numCases;
+}
+
+/**
+ * @return - true for arithmetic and logic instructions, on registers, memory or immediates, and DAA
+ */
+bool isAluOpcode(uint8_t opcode)
+{
+    uint8_t source = opcode & 0x07;
+
+    if(opcode >= 0x80 && opcode <= 0xbf){
+        return true;
+    }else if(opcode >= 0xc0){
+        return source == 0x06;
+    }else if(opcode < 0x40){
+        return source == 0x04 || source == 0x05 || opcode == 0x27;
+    }
+
+    return false;
+}
+
+int runAluWorker(void *data)
+{
+    AluWorker *worker = data;
+
+    while(1){
+        uint32_t caseNum = (uint32_t)SDL_AtomicAdd(worker->nextCase, 1);
+        if(caseNum >= worker->numCases){
+            break;
+        }
+        checkAluCase(worker, &(worker->cases[caseNum]));
+    }
+
+    return 0;
+}
+
+/**
+ * Runs an opcode on every input through the reference and a variant, counting the inputs they disagree on
+ */
+void checkAluCase(AluWorker *worker, AluCase *aluCase)
+{
+    State8080 *reference = worker->reference;
+    State8080 *candidate = worker->candidate;
+    uint8_t referenceOperands[2];
+    uint8_t candidateOperands[2];
+    uint8_t *referenceRegister = getOperandRegister(reference, aluCase->opcode);
+    uint8_t *candidateRegister = getOperandRegister(candidate, aluCase->opcode);
+
+    for(uint32_t input = 0; input < NUM_ALU_INPUTS; input++){
+        setAluInput(reference, referenceRegister, input, referenceOperands);
+        setAluInput(candidate, candidateRegister, input, candidateOperands);
+        executeInstructionByOpcode(aluCase->opcode, referenceOperands, reference);
+        aluCase->variant->execute(aluCase->opcode, candidateOperands, candidate);
+
+        if(!statesMatch(reference, candidate, aluCase->variant->flagsChecked) ||
+           reference->memory[ALU_TEST_MEMORY_ADDRESS] != candidate->memory[ALU_TEST_MEMORY_ADDRESS]){
+            if(aluCase->numMismatches == 0){
+                aluCase->firstMismatch = input;
+                aluCase->expected = *reference;
+                aluCase->actual = *candidate;
+            }
+            aluCase->numMismatches++;
+        }
+    }
+}
+
+/**
+ * Runs an instruction computing only the zero and carry flags, as the predecoded engine does
+ * where the others are dead. DAA, INR M, DCR M and ADC M are never run this way and go through the table.
+ */
+void executeLiveFlagsInstruction(uint8_t opcode, uint8_t *operands, State8080 *state)
+{
+    uint8_t *operandRegister = getOperandRegister(state, opcode);
+    if(opcode == 0x27 || opcode == 0x8e){
+        executeAluInstruction(opcode, operands, state);
+        return;
+    }else if(opcode < 0x40 && operandRegister != NULL){
+        *operandRegister += ((opcode & 0x07) == 0x04) ? 1 : -1;
+        state->flags.zero = (*operandRegister == 0);
+        state->pc += 1;
+        state->cyclesCompleted += instructionCycles[opcode];
+        return;
+    }else if(opcode < 0x40){
+        executeAluInstruction(opcode, operands, state);
+        return;
+    }
+
+    uint8_t operation = (opcode>>3) & 0x07;
+    uint8_t data = 0;
+    unsigned int size = 1;
+    if(opcode >= 0xc0){
+        data = operands[0];
+        size = 2;
+    }else if((opcode & 0x07) == 0x06){
+        data = readMem(getValueHL(state), state);
+    }else{
+        data = *operandRegister;
+    }
+
+    uint8_t result = aluOperationResult(operation, data, state);
+    state->flags.carry = aluOperationCarry(operation, data, state);
+    state->flags.zero = (result == 0);
+    if(operation != ALU_CMP){
+        state->a = result;
+    }
+    state->pc += size;
+    state->cyclesCompleted += instructionCycles[opcode];
+}
+
+/**
+ * @return - The register an instruction takes its operand from, or NULL for memory and immediate operands
+ */
+uint8_t *getOperandRegister(State8080 *state, uint8_t opcode)
+{
+    uint8_t *registers[8] = {&(state->b), &(state->c), &(state->d), &(state->e), &(state->h), &(state->l), NULL, &(state->a)};
+
+    if(opcode >= 0xc0){
+        return NULL;
+    }else if(opcode < 0x40){
+        // INR and DCR name their register in bits 3-5
+        return registers[(opcode>>3) & 0x07];
+    }
+
+    return registers[opcode & 0x07];
+}
+
+/**
+ * Sets up a CPU to run an instruction on one input
+ * @param state - The 8080 state
+ * @param operandRegister - Register the instruction takes its operand from, or NULL
+ * @param input - Accumulator in bits 10-17, operand in bits 2-9, carry in bit 1 and auxiliary carry in bit 0
+ * @param operands - Set to the instruction's operand bytes
+ */
+void setAluInput(State8080 *state, uint8_t *operandRegister, uint32_t input, uint8_t *operands)
+{
+    uint8_t accumulator = (uint8_t)(input>>10);
+    uint8_t operand = (uint8_t)(input>>2);
+
+    // Flags the instructions do not read are still varied, so that any they fail to set show up
+    ConditionCodes flags;
+    flags.carry = (input>>1) & 1;
+    flags.auxiliaryCarry = input & 1;
+    flags.zero = operand & 1;
+    flags.sign = (operand>>1) & 1;
+    flags.parity = accumulator & 1;
+    flags.unusedBits = (accumulator>>1) & 0x07;
+    state->flags = flags;
+    state->b = 0x12;
+    state->c = 0x34;
+    state->d = 0x56;
+    state->e = 0x78;
+    state->h = (uint8_t)(ALU_TEST_MEMORY_ADDRESS>>8);
+    state->l = (uint8_t)ALU_TEST_MEMORY_ADDRESS;
+    state->sp = 0x2400;
+    state->pc = ALU_TEST_PC;
+    state->cyclesCompleted = 0;
+    state->interruptsEnabled = 0;
+    state->memory[ALU_TEST_MEMORY_ADDRESS] = operand;
+    operands[0] = operand;
+    operands[1] = 0xff;
+
+    // The accumulator is set last, so it wins for instructions operating on A itself
+    if(operandRegister != NULL){
+        *operandRegister = operand;
+    }
+    state->a = accumulator;
+}
+
+bool statesMatch(const State8080 *expected, const State8080 *actual, uint8_t flagsChecked)
+{
+    return expected->a == actual->a && expected->b == actual->b && expected->c == actual->c &&
+           expected->d == actual->d && expected->e == actual->e && expected->h == actual->h &&
+           expected->l == actual->l && expected->sp == actual->sp && expected->pc == actual->pc &&
+           ((*(const uint8_t*)&(expected->flags) ^ *(const uint8_t*)&(actual->flags)) & flagsChecked) == 0 &&
+           expected->cyclesCompleted == actual->cyclesCompleted &&
+           expected->interruptsEnabled == actual->interruptsEnabled;
+}
+
+void printAluState(const char *name, const State8080 *state)
+{
+    printf("  %-9s  A %02x B %02x C %02x D %02x E %02x H %02x L %02x PC %04x  z%u s%u p%u cy%u ac%u  cycles %u\n",
+           name, state->a, state->b, state->c, state->d, state->e, state->h, state->l, state->pc,
+           state->flags.zero, state->flags.sign, state->flags.parity, state->flags.carry, state->flags.auxiliaryCarry,
+           state->cyclesCompleted);
+}
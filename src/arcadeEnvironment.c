@@ -6,37 +6,190 @@
 ***********************************************************************************/
 
 #include "arcadeEnvironment.h"
+#include "rewindBuffer.h"
+#include "movie.h"
+#include "instructionTrace.h"
+#include "logWriter.h"
+#include "hotnessProfile.h"
+#include "opcodeSpec.h"
 
-ArcadeState *initializeArcade()
+void setDefaultArcadeConfig(ArcadeConfig *config)
+{
+    config->audioPeriodFrames = AUDIO_DEFAULT_PERIOD_FRAMES;
+    config->resourcePath = NULL;
+    config->rewindSeconds = DEFAULT_REWIND_SECONDS;
+    config->recordPath = NULL;
+    config->keyframeInterval = DEFAULT_KEYFRAME_INTERVAL;
+    config->playPath = NULL;
+    config->engine = ReferenceEngine;
+    config->tracePath = NULL;
+    config->hotnessPath = NULL;
+    config->hookMode = HooksOff;
+    config->logLevel = LOG_INFO;
+    config->headless = false;
+}
+
+void setHeadlessArcadeConfig(ArcadeConfig *config)
+{
+    setDefaultArcadeConfig(config);
+    config->headless = true;
+    config->rewindSeconds = 0;
+}
+
+int parseArcadeConfig(int argc, char **argv, ArcadeConfig *config)
+{
+    for(int argNum = 1; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--audio-period") == 0 && argNum+1 < argc){
+            argNum++;
+            config->audioPeriodFrames = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--resources") == 0 && argNum+1 < argc){
+            argNum++;
+            config->resourcePath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--rewind") == 0 && argNum+1 < argc){
+            argNum++;
+            config->rewindSeconds = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--record") == 0 && argNum+1 < argc){
+            argNum++;
+            config->recordPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--keyframe-interval") == 0 && argNum+1 < argc){
+            argNum++;
+            config->keyframeInterval = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--play") == 0 && argNum+1 < argc){
+            argNum++;
+            config->playPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--engine") == 0 && argNum+1 < argc){
+            argNum++;
+            if(findCpuEngine(argv[argNum], &(config->engine)) == 0){
+                logger("Unknown CPU engine: %s\n", argv[argNum]);
+                return 0;
+            }
+        }else if(strcmp(argv[argNum], "--trace") == 0 && argNum+1 < argc){
+            argNum++;
+            config->tracePath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--hotness") == 0 && argNum+1 < argc){
+            argNum++;
+            config->hotnessPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--hooks") == 0 && argNum+1 < argc){
+            argNum++;
+            if(findRomHookMode(argv[argNum], &(config->hookMode)) == 0){
+                logger("Unknown hook mode: %s\n", argv[argNum]);
+                return 0;
+            }
+        }else if(strcmp(argv[argNum], "--log-level") == 0 && argNum+1 < argc){
+            argNum++;
+            if(findLogLevel(argv[argNum], &(config->logLevel)) == 0){
+                logger("Unknown log level: %s\n", argv[argNum]);
+                return 0;
+            }
+        }else{
+            logger("Unrecognized option: %s\n", argv[argNum]);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+ArcadeState *initializeArcade(const ArcadeConfig *config)
 {
     // Create an arcade to work with
     ArcadeState *arcade = mallocSet(sizeof(ArcadeState));
-    arcade->cpu = initializeCPU();
+
+    // Use the ROM compiled into the emulator unless a resource folder was given
+    if(config->resourcePath == NULL){
+        arcade->rom = embeddedInvadersRom;
+    }else{
+        arcade->rom = acquireRomSet(config->resourcePath);
+        if(arcade->rom == NULL){
+            free(arcade);
+            return NULL;
+        }
+    }
+    arcade->cpu = initializeCPU(arcade->rom);
+    arcade->engine = initializeCpuEngine(config->engine);
+    prepareCpuEngine(arcade->engine, arcade->cpu->memory);
     arcade->window = NULL;
     arcade->renderer = NULL;
+    arcade->headless = config->headless;
+    arcade->audio = NULL;
+    arcade->rewind = NULL;
+    arcade->movieRecorder = NULL;
+    arcade->moviePlayer = NULL;
+    arcade->tracer = NULL;
+    arcade->hotness = NULL;
+    arcade->hotnessPath = config->hotnessPath;
     arcade->colourProfile = Original;
 
+    // Movies are replayed from power-on, so rewinding would make them diverge
+    if(config->rewindSeconds > 0 && config->recordPath == NULL && config->playPath == NULL){
+        arcade->rewind = initializeRewindBuffer(config->rewindSeconds);
+    }
+
     resetPortsIO(arcade);
     synchronizeIO(arcade);
 
+    int successfulInit = 1;
+    if(config->recordPath != NULL){
+        arcade->movieRecorder = initializeMovieRecorder(config->recordPath, config->keyframeInterval);
+        if(arcade->movieRecorder == NULL){
+            successfulInit = 0;
+        }
+    }
+    if(successfulInit && config->playPath != NULL){
+        arcade->moviePlayer = initializeMoviePlayer(config->playPath);
+        if(arcade->moviePlayer == NULL){
+            successfulInit = 0;
+        }
+    }
+
+    if(successfulInit && config->tracePath != NULL){
+        arcade->tracer = initializeInstructionTracer(config->tracePath);
+        if(arcade->tracer == NULL){
+            successfulInit = 0;
+        }
+    }
+
+    // Hot ROM paths of earlier runs are decoded now rather than when first reached
+    if(successfulInit && config->hotnessPath != NULL){
+        arcade->hotness = loadHotnessProfile(config->hotnessPath, arcade->rom);
+        uint32_t numDecoded = warmStartCpuEngine(arcade->hotness, arcade->engine, arcade->cpu->memory);
+        uint32_t numFused = fuseHotInstructions(arcade->hotness, arcade->engine, arcade->cpu->memory);
+        if(numDecoded > 0){
+            LOG(LOG_INFO, "Pre-decoded %u instructions from hotness profile %s, %u sequences fused\n",
+                numDecoded, config->hotnessPath, numFused);
+        }
+    }
+
+    // Native routines take over from any fused sequences at their addresses, so are installed last
+    if(successfulInit && config->hookMode != HooksOff){
+        #ifdef CPU_PROFILE
+        LOG(LOG_WARNING, "--hooks is ignored in profile builds, every ROM instruction is profiled\n");
+        #endif
+        uint32_t numHooked = installCpuEngineHooks(arcade->engine, arcade->cpu->memory, config->hookMode);
+        LOG(LOG_INFO, "%u ROM routines replaced by native ones%s\n", numHooked,
+            (config->hookMode == HooksVerified) ? ", each run checked against the ROM code" : "");
+    }
 
     // Setup SDL for communicating with host machine API
-    if(initializeEnvironmentSDL(arcade) == 1 && loadAudio(arcade) == 1){
+    if(successfulInit && !(config->headless)){
+        successfulInit = initializeEnvironmentSDL(arcade, config) == 1 && loadAudio(arcade, config) == 1;
+    }
+
+    if(successfulInit){
         return arcade;
     }else{
-        destroyCPU(arcade->cpu);
         destroyArcade(arcade);
         return NULL;
     }
 }
 
-int initializeEnvironmentSDL(ArcadeState *arcade)
+int initializeEnvironmentSDL(ArcadeState *arcade, const ArcadeConfig *config)
 {
     int successfulInit = 1;
 
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0){
-        logger( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+        LOG(LOG_ERROR, "SDL could not initialize! SDL Error: %s\n", SDL_GetError());
         successfulInit = 0;
     }
 
@@ -46,14 +199,14 @@ int initializeEnvironmentSDL(ArcadeState *arcade)
         // 1 - linear filtering
         // 2 - anistropic filtering
         if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0")){
-            logger("Warning: Failure to manually set texture filtering!\n");
+            LOG(LOG_WARNING, "Warning: Failure to manually set texture filtering!\n");
         }
 
         // Create a window
         arcade->window = SDL_CreateWindow("Space Invaders", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
                                           SCREEN_WIDTH_PIXELS, SCREEN_HEIGHT_PIXELS, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
         if (arcade->window == NULL){
-            logger( "Window could not be created! SDL Error: %s\n", SDL_GetError());
+            LOG(LOG_ERROR, "Window could not be created! SDL Error: %s\n", SDL_GetError());
             successfulInit = 0;
         }
     }
@@ -63,15 +216,15 @@ int initializeEnvironmentSDL(ArcadeState *arcade)
         arcade->renderer = SDL_CreateRenderer(arcade->window, -1,
                 SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
         if (arcade->renderer == NULL){
-            logger( "Renderer could not be created! SDL Error: %s\n", SDL_GetError());
+            LOG(LOG_ERROR, "Renderer could not be created! SDL Error: %s\n", SDL_GetError());
             successfulInit = 0;
         }
     }
 
     if(successfulInit){
-        // Initialize SDL_mixer
-        if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0){
-            logger("SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError());
+        // Open the audio device
+        arcade->audio = initializeAudioEngine(config->audioPeriodFrames);
+        if(arcade->audio == NULL){
             successfulInit = 0;
         }
     }
@@ -79,52 +232,48 @@ int initializeEnvironmentSDL(ArcadeState *arcade)
     return successfulInit;
 }
 
-int loadAudio(ArcadeState *arcade)
+int loadAudio(ArcadeState *arcade, const ArcadeConfig *config)
 {
-    arcade->ufoMusic = Mix_LoadMUS("../resources/ufo_lowpitch.wav");
-    if(arcade->ufoMusic == NULL){
-        logger("Failed to load UFO music! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->playerShootSfx = Mix_LoadWAV("../resources/shoot.wav");
-    if(arcade->playerShootSfx == NULL){
-        logger("Failed to load player shoot sfx! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->playerDieSfx = Mix_LoadWAV("../resources/explosion.wav");
-    if(arcade->playerDieSfx == NULL){
-        logger("Failed to load player died sfx! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->invaderDieSfx = Mix_LoadWAV("../resources/invaderkilled.wav");
-    if(arcade->invaderDieSfx == NULL){
-        logger("Failed to load invader died sfx! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->fleetMove1Sfx = Mix_LoadWAV("../resources/fastinvader1.wav");
-    if(arcade->fleetMove1Sfx == NULL){
-        logger("Failed to load fleet move 1 music! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->fleetMove2Sfx = Mix_LoadWAV("../resources/fastinvader2.wav");
-    if(arcade->fleetMove2Sfx == NULL){
-        logger("Failed to load fleet move 2 music! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->fleetMove3Sfx = Mix_LoadWAV("../resources/fastinvader3.wav");
-    if(arcade->fleetMove3Sfx == NULL){
-        logger("Failed to load fleet move 3 music! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->fleetMove4Sfx = Mix_LoadWAV("../resources/fastinvader4.wav");
-    if(arcade->fleetMove4Sfx == NULL){
-        logger("Failed to load fleet move 4 music! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
-    }
-    arcade->ufoDieSfx = Mix_LoadWAV("../resources/ufo_highpitch.wav");
-    if(arcade->ufoDieSfx == NULL){
-        logger("Failed to load UFO died sfx! SDL_mixer Error: %s\n", Mix_GetError());
-        return 0;
+    // Each clip is named after its WAV file
+    struct{
+        AudioClip *clip;
+        const char *name;
+        const char *description;
+    } sounds[] = {
+        {&(arcade->ufoMusic), "ufo_lowpitch", "UFO music"},
+        {&(arcade->playerShootSfx), "shoot", "player shoot sfx"},
+        {&(arcade->playerDieSfx), "explosion", "player died sfx"},
+        {&(arcade->invaderDieSfx), "invaderkilled", "invader died sfx"},
+        {&(arcade->fleetMove1Sfx), "fastinvader1", "fleet move 1 music"},
+        {&(arcade->fleetMove2Sfx), "fastinvader2", "fleet move 2 music"},
+        {&(arcade->fleetMove3Sfx), "fastinvader3", "fleet move 3 music"},
+        {&(arcade->fleetMove4Sfx), "fastinvader4", "fleet move 4 music"},
+        {&(arcade->ufoDieSfx), "ufo_highpitch", "UFO died sfx"}
+    };
+    unsigned int numSounds = sizeof(sounds)/sizeof(sounds[0]);
+
+    for(unsigned int soundNum = 0; soundNum < numSounds; soundNum++){
+        AudioClip *clip = sounds[soundNum].clip;
+
+        if(config->resourcePath == NULL){
+            // Pre-decoded samples are used in place, without copying
+            const EmbeddedSound *sound = getEmbeddedSound(sounds[soundNum].name);
+            if(sound == NULL){
+                LOG(LOG_ERROR, "Failed to load %s! No embedded sound named %s\n",
+                       sounds[soundNum].description, sounds[soundNum].name);
+                return 0;
+            }
+            clip->samples = sound->samples;
+            clip->numSamples = sound->numSamples;
+            clip->ownsSamples = false;
+        }else{
+            char wavPath[RESOURCE_PATH_LENGTH];
+            snprintf(wavPath, sizeof(wavPath), "%s/%s.wav", config->resourcePath, sounds[soundNum].name);
+            if(loadAudioClip(wavPath, clip) == 0){
+                LOG(LOG_ERROR, "Failed to load %s! SDL Error: %s\n", sounds[soundNum].description, SDL_GetError());
+                return 0;
+            }
+        }
     }
 
     return 1;
@@ -133,34 +282,66 @@ int loadAudio(ArcadeState *arcade)
 void destroyArcade(ArcadeState *arcade)
 {
     // Free audio
-    Mix_FreeMusic(arcade->ufoMusic);
-    arcade->ufoMusic = NULL;
-    Mix_FreeChunk(arcade->playerShootSfx);
-    arcade->playerShootSfx = NULL;
-    Mix_FreeChunk(arcade->playerDieSfx);
-    arcade->playerDieSfx = NULL;
-    Mix_FreeChunk(arcade->invaderDieSfx);
-    arcade->invaderDieSfx = NULL;
-    Mix_FreeChunk(arcade->fleetMove1Sfx);
-    arcade->fleetMove1Sfx = NULL;
-    Mix_FreeChunk(arcade->fleetMove2Sfx);
-    arcade->fleetMove2Sfx = NULL;
-    Mix_FreeChunk(arcade->fleetMove3Sfx);
-    arcade->fleetMove3Sfx = NULL;
-    Mix_FreeChunk(arcade->fleetMove4Sfx);
-    arcade->fleetMove4Sfx = NULL;
-    Mix_FreeChunk(arcade->ufoDieSfx);
-    arcade->ufoDieSfx = NULL;
-    // Destroy window
-    SDL_DestroyWindow(arcade->window);
+    freeAudioClip(&(arcade->ufoMusic));
+    freeAudioClip(&(arcade->playerShootSfx));
+    freeAudioClip(&(arcade->playerDieSfx));
+    freeAudioClip(&(arcade->invaderDieSfx));
+    freeAudioClip(&(arcade->fleetMove1Sfx));
+    freeAudioClip(&(arcade->fleetMove2Sfx));
+    freeAudioClip(&(arcade->fleetMove3Sfx));
+    freeAudioClip(&(arcade->fleetMove4Sfx));
+    freeAudioClip(&(arcade->ufoDieSfx));
+    if(arcade->audio != NULL){
+        logger("Audio underruns: %u (%u sample frames of silence)\n",
+               getAudioUnderrunCount(arcade->audio), getAudioUnderrunFrames(arcade->audio));
+    }
+    destroyAudioEngine(arcade->audio);
+    arcade->audio = NULL;
+    // Destroy window and renderer, headless arcades never created them
+    if(!(arcade->headless)){
+        SDL_DestroyWindow(arcade->window);
+        SDL_DestroyRenderer(arcade->renderer);
+    }
     arcade->window = NULL;
-    // Destroy renderer
-    SDL_DestroyRenderer(arcade->renderer);
     arcade->renderer = NULL;
 
-    // Quit SDL and any related subsystems
-    Mix_Quit();
-    SDL_Quit();
+    // Free rewind history
+    if(arcade->rewind != NULL){
+        double captureMicroseconds = getRewindCaptureMicroseconds(arcade->rewind);
+        logger("Rewind capture: %.1f us per frame (%.3f%% of the frame budget)\n",
+               captureMicroseconds, captureMicroseconds*FPS/10000.0);
+    }
+    destroyRewindBuffer(arcade->rewind);
+    arcade->rewind = NULL;
+
+    // Finish movies
+    destroyMovieRecorder(arcade->movieRecorder);
+    arcade->movieRecorder = NULL;
+    destroyMoviePlayer(arcade->moviePlayer);
+    arcade->moviePlayer = NULL;
+    destroyInstructionTracer(arcade->tracer);
+    arcade->tracer = NULL;
+    if(arcade->hotness != NULL){
+        saveHotnessProfile(arcade->hotness, arcade->hotnessPath);
+        destroyHotnessProfile(arcade->hotness);
+        arcade->hotness = NULL;
+    }
+
+    destroyCpuEngine(arcade->engine);
+    arcade->engine = NULL;
+
+    // Release ROM
+    releaseRomSet(arcade->rom);
+    arcade->rom = NULL;
+
+    // Quit SDL and any related subsystems, only if this arcade initialized them. Headless arcades may be
+    // destroyed while other threads, such as the log writer, still use SDL.
+    if(!(arcade->headless)){
+        SDL_Quit();
+    }
+
+    destroyCPU(arcade->cpu);
+    free(arcade);
 }
 
 void synchronizeIO(ArcadeState *arcade)
@@ -225,8 +406,291 @@ void updateShiftRegister(ArcadeState *arcade)
 void runForCpuCycles(unsigned int numCyclesToRun, ArcadeState *arcade)
 {
     unsigned int startingCycles = arcade->cpu->cyclesCompleted;
+    // The tracer records every flag between instructions, so dead flags must be computed while tracing
+    if(arcade->tracer == NULL){
+        setCpuEngineRunEnd(arcade->engine, startingCycles+numCyclesToRun);
+    }
     while((arcade->cpu->cyclesCompleted - startingCycles) < numCyclesToRun){
         updateShiftRegister(arcade);
-        executeNextInstruction(arcade->cpu);
+        if(arcade->tracer != NULL){
+            traceInstruction(arcade->tracer, arcade->cpu);
+        }
+        uint16_t pc = arcade->cpu->pc;
+        unsigned int numExecuted = stepCpuEngine(arcade->engine, arcade->cpu);
+        // A fused step runs on through every instruction but its last, which are all in ROM.
+        // A native routine loops and returns, so only its first instruction is counted.
+        if(isCpuEngineHooked(arcade->engine, pc)){
+            numExecuted = 1;
+        }
+        for(unsigned int instructionNum = 0; arcade->hotness != NULL && instructionNum < numExecuted; instructionNum++){
+            recordHotness(arcade->hotness, pc, arcade->cpu);
+            pc += instructionSizes[arcade->cpu->memory[pc]];
+        }
+    }
+    clearCpuEngineRunEnd(arcade->engine);
+}
+
+void runFrame(ArcadeState *arcade)
+{
+    updateShiftRegister(arcade);
+
+    // Emulate cpu up to the known point of the mid-screen render interrupt
+    // Screen width is used here, rather than height, as the Space Invaders screen is rotated 90 degrees and is
+    // thus rendering vertical lines rather than horizontal lines
+    unsigned int numCyclesFirstHalf = CYCLES_PER_FRAME*((float)MIDSCREEN_INTERRUPT_LINE/(float)SCREEN_WIDTH_PIXELS);
+    runForCpuCycles(numCyclesFirstHalf, arcade);
+
+    // Trigger mid-screen interrupt
+    if(arcade->tracer != NULL){
+        traceInterrupt(arcade->tracer, arcade->cpu, 0x01);
+    }
+    generateInterrupt(0x01, arcade->cpu);  // mid-screen
+
+    // Emulate cpu up to the end of the frame
+    unsigned int numCyclesSecondHalf = CYCLES_PER_FRAME-numCyclesFirstHalf;
+    runForCpuCycles(numCyclesSecondHalf, arcade);
+
+    // Trigger end-of-screen vertical blank interrupt
+    if(arcade->tracer != NULL){
+        traceInterrupt(arcade->tracer, arcade->cpu, 0x02);
     }
+    generateInterrupt(0x02, arcade->cpu);
+}
+
+uint32_t *getCurrentFramePixels(ArcadeState *arcade)
+{
+    // get rotated pixel data from cpu
+    // 1 bit per pixel
+    uint8_t *rotatedPixels = getVideoRAM(arcade->cpu);
+
+    // At this point, a byte contains data for 8 pixels. However, the order of the bytes is counter-clockwise.
+    // This is because the original Space Invaders cabinet used a rotated CRT, so the developers accounted for this.
+    // Hence, if we read the bits in-order, we will be reading columnar data.
+    // By bit-index, with height=256 & width=224, our (corrected) screen is:
+    /*
+    255 - 511 - 767 - ... - 57343
+     |  -  |  -  |  - ... -   |
+    251 - 510 - 766 - ... - 57342
+     |  -  |  -  |  - ... -   |
+    ||| - ||| - ||| - ... -  |||
+     |  -  |  -  |  - ... -   |
+     1  - 257 - 513 - ... - 57089
+     |  -  |  -  |  - ... -   |
+     0  - 256 - 512 - ... - 57088
+    */
+    // This poses 2 problems:
+    // 1) The renderer is 32 bits per pixel
+    // 2) The renderer operates top-left pixel to bottom-right pixel, row-by-row.
+    //
+    // Fixing problem #1 is easy, we just expand each bit to 32 bits and we can even add RGBA info as we desire.
+    // Fixing problem #2 is messy. If we read from our data as currently ordered, we would have the pixel that should
+    // be in the bottom-leftmost position ending up rendered in the top-leftmost position.
+    // To fix this, we can create a map from the render-order pixel indices to the rotated ones that we have now:
+    /*
+      0  : 255 -  1  : 511 -    ...   - 223 :57343
+         |     -     |     -     |    -     |
+     224 : 251 - 225 : 510 -    ...   - 447 :57342
+         |     -     |     -     |    -     |
+        |||    -    |||    -    |||   -    |||
+         |     -     |     -     |    -     |
+    56896:  1  -56897: 257 -    ...   -57119:57089
+         |     -     |     -     |    -     |
+    57120:  0  -57121: 256 -    ...   -57343:57088
+    */
+    // The render-order pixel indices are on the left of each colon while the rotated versions from the 8080 VRAM
+    // are on the right of each colon.
+    // We can call the render-order indices I_2 and the rotated indices I_1
+    // Thus our goal is to find a mapping function of the form I_1 = f(I_2)
+    //
+    // If we give each pixel a coordinate of the form (x,y) and assert that Width=W and Height=H
+    // We may note the following by inspection:
+    // I_1 = (x+1)H - (y+1);  x = I_2%W;  y = floor(I_2/W);
+    // Substituting as appropriate yields:
+    // I_1 = ((I_2%W)+1)H - (floor(I_2/W)+1);
+
+    // Prepare to expand pixels
+    // each bit from cpu will become 32 bits (RGBA format)
+    // 8 bits for each of: red, green, blue, alpha
+    unsigned int numPixels = SCREEN_HEIGHT_PIXELS*SCREEN_WIDTH_PIXELS;
+    unsigned int numPixelBytes = numPixels*BYTES_PER_PIXEL;
+    uint32_t *currentFramePixels = mallocSet(numPixelBytes);  // Pointer to data describing 32-bit pixels for current frame
+
+    // Get 32-bit pixel data for entire frame by iterating through pixels to be rendered on screen
+    unsigned int I_1;
+    unsigned int y;
+    unsigned int x;
+    unsigned int W = SCREEN_WIDTH_PIXELS;
+    unsigned int H = SCREEN_HEIGHT_PIXELS;
+    uint8_t currentByte = 0x00;
+    bool currentPixelBit = 0;
+    unsigned int byteIndex = 0;
+    unsigned int bitIndexWithinByte = 0;  // MSB index == 7, LSB index == 0
+    // top-left pixel = index 0, top-right = index 223, bottom-right = 57,343
+    for(unsigned int I_2 = 0; I_2 < numPixels; I_2++){
+        // Get the rotated index for the desired bit in VRAM that corresponds with the current pixel
+        x = I_2%W;
+        y = floor(I_2/W);
+        I_1 = (x+1)*H - (y+1);
+
+        // Get the byte that contains the desired bit
+        byteIndex = floor(I_1 / 8);
+        currentByte = rotatedPixels[byteIndex];
+
+        // Get desired bit
+        bitIndexWithinByte = I_1 % 8;
+        currentPixelBit = (currentByte >> bitIndexWithinByte) & 0x01;
+
+        // Expand bit to 32 bits RGBA info
+        // Insert colour data depending on active colour profile
+        if(currentPixelBit == 1){
+            // Pixel is on
+            uint32_t R;
+            uint32_t G;
+            uint32_t B;
+            switch(arcade->colourProfile){
+                case BlackAndWhite:
+                    currentFramePixels[I_2] = WHITE_PIXEL;
+                    break;
+                case Inverted:
+                    currentFramePixels[I_2] = BLACK_PIXEL;
+                    break;
+                case Original:
+                    // True to Space Invaders arcade machine with transparent colour overlays
+                    if(y<64 && y > 31){  // UFO
+                        currentFramePixels[I_2] = RED_PIXEL;
+                    }else if(y>191){  // Player and Shields
+                        currentFramePixels[I_2] = GREEN_PIXEL;
+                    }else{
+                        currentFramePixels[I_2] = WHITE_PIXEL;
+                    }
+                    break;
+                case Spectrum1:
+                    // Vary R vertically, G horizontally, B diagonally
+                    R = ((uint32_t)y) << 24;
+                    G = (0x000000ff & ((((uint32_t)x) * 255)/223)) << 16;
+                    B = (((255.0-(float)y)) + ((223.0-(float)x))) * (255.0/478.0);
+                    if(B > 255.0){
+                        B = 0x0000ff00;
+                    }else{
+                        B = ((uint32_t)B) << 8;
+                    }
+                    currentFramePixels[I_2] = R | G | B ;
+                    break;
+                case Spectrum2:
+                    // Vary R horizontally, G diagonally, B vertically
+                    R = (0x000000ff & ((((uint32_t)x) * 255)/223)) << 24;
+                    G = (((255.0-(float)y)) + ((223.0-(float)x))) * (255.0/478.0);
+                    B = ((uint32_t)y) << 8;
+                    if(G > 255.0){
+                        G = 0x00ff0000;
+                    }else{
+                        G = ((uint32_t)G) << 16;
+                    }
+                    currentFramePixels[I_2] = R | G | B ;
+                    break;
+                case Spectrum3:
+                    // Vary R diagonally, G vertically, B horizontally
+                    R = (((255.0-(float)y)) + ((223.0-(float)x))) * (255.0/478.0);
+                    G = ((uint32_t)y) << 16;
+                    B = (0x000000ff & ((((uint32_t)x) * 255)/223)) << 8;
+                    if(R > 255.0){
+                        R = 0xff000000;
+                    }else{
+                        R = ((uint32_t)R) << 24;
+                    }
+                    currentFramePixels[I_2] = R | G | B ;
+                    break;
+                case Spectrum4:
+                    // Color Map
+                    //   y     R    G     B
+                    //   0    215   45   125
+                    //  20    255   85    85
+                    //  21    255   87    83
+                    //  62    173  169    1
+                    //  63    171  171    1
+                    //  105    87  255    85
+                    //  106    85  255    87
+                    //  148    1   171    171
+                    //  149    1   169    173
+                    //  190    83   87    255
+                    //  191    85   85    255
+                    //  233   169   1     171
+                    //  234   234   1     169
+                    //  255   213   43    127
+                    //
+                    // For each colour dimension (R,G,B),
+                    // the value changes by either +2 or -2 between
+                    // adjacent vertical pixels. Rows are constant.
+                    if(y <= 20){
+                        R = 215 + (2*y);
+                        G = 45 + (2*y);
+                        B = 125 - (2*y);
+                    }else if(y <= 62){
+                        R = 297 - (2*y);
+                        G = 45 + (2*y);
+                        B = 125 - (2*y);
+                    }else if(y <= 105){
+                        R = 297 - (2*y);
+                        G = 45 + (2*y);
+                        B = (-125) + (2*y);
+                    }else if(y <= 148){
+                        R = 297 - (2*y);
+                        G = 467 - (2*y);
+                        B = (-125) + (2*y);
+                    }else if(y <= 190){
+                        R = (-297) + (2*y);
+                        G = 467 - (2*y);
+                        B = (-125) + (2*y);
+                    }else if(y <= 233){
+                        R = (-297) + (2*y);
+                        G = 467 - (2*y);
+                        B = 637 - (2*y);
+                    }else{
+                        R = (-297) + (2*y);
+                        G = (-467) + (2*y);
+                        B = 637 - (2*y);
+                    }
+                    R <<= 24;
+                    G <<= 16;
+                    B <<= 8;
+                    currentFramePixels[I_2] = R | G | B ;
+                    break;
+                case Rainbow:
+                    if(y < 36){
+                        currentFramePixels[I_2] = VIOLET_PIXEL;
+                    }else if(y <= 72){
+                        currentFramePixels[I_2] = INDIGO_PIXEL;
+                    }else if(y <= 106){
+                        currentFramePixels[I_2] = BLUE_PIXEL;
+                    }else if(y <= 143){
+                        currentFramePixels[I_2] = GREEN_PIXEL;
+                    }else if(y <= 178){
+                        currentFramePixels[I_2] = YELLOW_PIXEL;
+                    }else if(y <= 214){
+                        currentFramePixels[I_2] = ORANGE_PIXEL;
+                    }else{
+                        currentFramePixels[I_2] = RED_PIXEL;
+                    }
+                    break;
+            }
+        }else{
+            // Pixel is off
+            if(arcade->colourProfile == Inverted){
+                currentFramePixels[I_2] = WHITE_PIXEL;
+            }else if(arcade->colourProfile == BlackAndWhite){
+                currentFramePixels[I_2] = BLACK_PIXEL;
+            }else if(arcade->colourProfile == Original){
+                currentFramePixels[I_2] = BLACK_PIXEL;
+            }else{
+                if(arcade->darkModeOn){
+                    currentFramePixels[I_2] = BLACK_PIXEL;
+                }else{
+                    currentFramePixels[I_2] = WHITE_PIXEL;
+                }
+            }
+        }
+    }
+
+    free(rotatedPixels);
+    return currentFramePixels;
 }
\ No newline at end of file
@@ -12,10 +12,13 @@
 #include <math.h>
 #include <time.h>
 #include "sdl_sources/SDL.h"
-#include "sdl_sources/SDL_mixer.h"
 #include "helpers.h"
 #include "cpuStructures.h"
 #include "shell8080.h"
+#include "audioEngine.h"
+#include "embeddedAssets.h"
+#include "romLoader.h"
+#include "cpuEngines.h"
 
 // Hardware parameters
 #define SCREEN_WIDTH_PIXELS 224
@@ -24,6 +27,9 @@
 #define FPS 60
 #define CYCLES_PER_FRAME floor(CYCLES_PER_SECOND_8080/FPS)
 #define MIDSCREEN_INTERRUPT_LINE 96
+#define RESOURCE_PATH_LENGTH 1024
+#define DEFAULT_REWIND_SECONDS 120
+#define DEFAULT_KEYFRAME_INTERVAL 600  // 10 seconds, about 830 bytes of keyframe per second of play
 // Masks for setting 8080 input port bits for Space Invaders actions
 #define SHOOT_MASK 0x10  // For triggering player character to shoot
 #define MOVE_LEFT_MASK 0x20  // For moving player character left
@@ -55,13 +61,40 @@
 // Colour profile determines the colours to be rendered when the game is playing
 enum ColourProfile {BlackAndWhite, Inverted, Original, Spectrum1, Spectrum2, Spectrum3, Spectrum4, Rainbow};
 
+/**
+ * Runtime options for the arcade machine, typically taken from the command line
+ */
+typedef struct ArcadeConfig{
+    unsigned int audioPeriodFrames;  /**< Audio device period in sample frames, smaller values lower the latency */
+    const char *resourcePath;  /**< Folder to load the ROM and sounds from, or NULL to use the embedded copies */
+    unsigned int rewindSeconds;  /**< Seconds of play kept for rewinding, 0 disables rewind */
+    const char *recordPath;  /**< Movie file to record input into, or NULL */
+    unsigned int keyframeInterval;  /**< Frames between keyframes in recorded movies */
+    const char *playPath;  /**< Movie file to take input from, or NULL */
+    enum CpuEngineType engine;  /**< Engine executing the CPU's instructions */
+    const char *tracePath;  /**< Binary instruction trace file to write, or NULL */
+    const char *hotnessPath;  /**< ROM hotness profile to warm start from and save at exit, or NULL */
+    enum RomHookMode hookMode;  /**< Whether native routines replace hot ROM routines, predecoded engine only */
+    LogLevel logLevel;  /**< Messages below this level are dropped, applied by startLogWriter */
+    bool headless;  /**< Skip the window and audio device, for emulating without a display */
+} ArcadeConfig;
+
+struct RewindBuffer;
+struct MovieRecorder;
+struct MoviePlayer;
+struct InstructionTracer;
+struct HotnessProfile;
+
 /**
  * Holds the parameters for the arcade machine
  */
 typedef struct ArcadeState{
     State8080 *cpu;  /**< Intel 8080 CPU */
+    CpuEngine *engine;  /**< Executes the CPU's instructions */
+    const uint8_t *rom;  /**< Read-only ROM set the CPU was loaded from, may be shared with other arcades */
     SDL_Window *window;  /**< The game window */
     SDL_Renderer *renderer;  /**< The renderer for the game window */
+    bool headless;  /**< SDL was never initialized, there is no window or audio device */
     enum ColourProfile colourProfile;  /**< Determines the on-screen colours */
     bool darkModeOn;  /**< Determines default pixel colour */
     // Input ports, read from by 8080
@@ -77,42 +110,90 @@ typedef struct ArcadeState{
     uint8_t outputPort5;
     uint8_t outputPort6;
     uint16_t shiftRegister;  /**< Custom hardware, found in arcade cabinet, for performing multi-bit shifts */
+    struct RewindBuffer *rewind;  /**< Recent history of the machine, or NULL if rewind is disabled */
+    struct MovieRecorder *movieRecorder;  /**< Records each frame's input, or NULL if not recording */
+    struct MoviePlayer *moviePlayer;  /**< Supplies each frame's input, or NULL if input is live */
+    struct InstructionTracer *tracer;  /**< Records every instruction, or NULL if not tracing */
+    struct HotnessProfile *hotness;  /**< Counts executed ROM addresses, or NULL if not profiling */
+    const char *hotnessPath;  /**< File the hotness profile is saved to when the arcade is destroyed */
     // Audio data
-    Mix_Music *ufoMusic;  /**< Plays while UFO is present */
-    Mix_Chunk *playerShootSfx;  /**< Player has fired a shot */
-    Mix_Chunk *playerDieSfx;  /**< Player died */
-    Mix_Chunk *invaderDieSfx;  /**< Invader was destroyed */
-    Mix_Chunk *fleetMove1Sfx;  /**< Lowest pitch */
-    Mix_Chunk *fleetMove2Sfx;  /**< Low pitch */
-    Mix_Chunk *fleetMove3Sfx;  /**< High pitch */
-    Mix_Chunk *fleetMove4Sfx;  /**< Highest pitch */
-    Mix_Chunk *ufoDieSfx;  /**< UFO was destroyed */
+    AudioEngine *audio;  /**< Mixes sound effects and feeds the audio device */
+    AudioClip ufoMusic;  /**< Plays while UFO is present */
+    AudioClip playerShootSfx;  /**< Player has fired a shot */
+    AudioClip playerDieSfx;  /**< Player died */
+    AudioClip invaderDieSfx;  /**< Invader was destroyed */
+    AudioClip fleetMove1Sfx;  /**< Lowest pitch */
+    AudioClip fleetMove2Sfx;  /**< Low pitch */
+    AudioClip fleetMove3Sfx;  /**< High pitch */
+    AudioClip fleetMove4Sfx;  /**< Highest pitch */
+    AudioClip ufoDieSfx;  /**< UFO was destroyed */
 
 } ArcadeState;
 
+/**
+ * Fills a config with the default options
+ * @param config - The config to fill
+ */
+void setDefaultArcadeConfig(ArcadeConfig *config);
+
+/**
+ * Fills a config with the default options for an arcade run without a window, audio device or rewind
+ * history, as used by the test and benchmark harnesses
+ * @param config - The config to fill
+ */
+void setHeadlessArcadeConfig(ArcadeConfig *config);
+
+/**
+ * Reads options from the command line into a config.
+ * Options not present on the command line are left untouched.
+ *
+ * Supported options:
+ * --audio-period N  Audio device period in sample frames (64 to 4096)
+ * --resources DIR   Load the ROM set and WAV files from DIR instead of using the embedded copies
+ * --rewind SECONDS  Seconds of play kept for rewinding, 0 disables rewind
+ * --record FILE     Record input into a movie file
+ * --keyframe-interval N  Frames between keyframes in recorded movies
+ * --play FILE       Take input from a movie file instead of the keyboard
+ * --engine NAME     CPU engine to run, "reference" or "predecoded"
+ * --trace FILE      Write a binary trace of every instruction, for bin/trace_decoder
+ * --hotness FILE    Pre-decode the ROM paths FILE found hot, then add this run's counts to it at exit
+ * --hooks MODE      Replace hot ROM routines with native ones, "off", "on" or "verify" to check them against the ROM
+ * --log-level NAME  Least important messages to log, "debug", "info", "warning", "error" or "none"
+ *
+ * @param argc - Number of command line arguments
+ * @param argv - Command line arguments
+ * @param config - The config to fill
+ * @return int - 1 if all options were understood, 0 otherwise
+ */
+int parseArcadeConfig(int argc, char **argv, ArcadeConfig *config);
+
 /**
  * Sets up an arcade for emulation
+ * @param config - Runtime options for the arcade
  * @return - pointer to an initialized arcade, or NULL if initialization failed
  */
-ArcadeState *initializeArcade();
+ArcadeState *initializeArcade(const ArcadeConfig *config);
 
 /**
  * Sets up the SDL environment.
+ * Not needed by headless arcades.
  * Must be called before any other SDL actions.
  * @param arcade - The arcade state
+ * @param config - Runtime options for the arcade
  * @return int - 1 if initialization was successful, 0 otherwise
  */
-int initializeEnvironmentSDL(ArcadeState *arcade);
+int initializeEnvironmentSDL(ArcadeState *arcade, const ArcadeConfig *config);
 
 /**
- * Attempts to load audio files for gameplay.
+ * Attempts to load audio for gameplay, from the embedded sounds or from the configured resource folder.
  * @param arcade - The arcade state
+ * @param config - Runtime options for the arcade
  * @return int - 1 if all loads successful, 0 otherwise
  */
-int loadAudio(ArcadeState *arcade);
+int loadAudio(ArcadeState *arcade, const ArcadeConfig *config);
 
 /**
- * Tears down the SDL environment.
+ * Tears down the SDL environment, then frees the arcade and its CPU.
  * Should be called after all SDL actions are complete.
  * @param arcade - The arcade state
  * @return void
@@ -150,4 +231,19 @@ void updateShiftRegister(ArcadeState *arcade);
  */
 void runForCpuCycles(unsigned int numCyclesToRun, ArcadeState *arcade);
 
+/**
+ * Emulates one frame of the arcade machine, including the mid-screen and vertical blank interrupts.
+ * The input ports should be set for the frame beforehand.
+ * @param arcade - The arcade state
+ */
+void runFrame(ArcadeState *arcade);
+
+/**
+ * Returns a pointer to data (32-bits-per-pixel) for the current frame to be rendered (by extracting from 8080 VRAM)
+ * The caller is responsible for freeing the pixel data.
+ * @param arcade - The arcade state
+ * @return Pointer to pixel data, ready to be rendered directly by SDL
+ */
+uint32_t *getCurrentFramePixels(ArcadeState *arcade);
+
 #endif //INTEL_8080_EMULATOR_ARCADEENVIRONMENT_H
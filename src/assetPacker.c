@@ -0,0 +1,276 @@
+/***********************************************************************************
+ *
+ * Build step that converts the Space Invaders ROM and sound effects into C source,
+ * so they can be compiled directly into the emulator.
+ *
+ * Usage: asset_packer <resource folder> <output .c file>
+ *
+ * WAV files are decoded here, rather than at startup, into the format expected by
+ * the audio engine: mono, signed 16-bit samples at AUDIO_SAMPLE_RATE.
+ * Only uncompressed PCM WAV files are supported.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "cpuStructures.h"
+#include "helpers.h"
+#include "audioEngine.h"
+
+#define VALUES_PER_LINE 12
+
+// Sounds to embed, named after their WAV files in the resource folder
+const char *soundNames[] = {
+    "ufo_lowpitch",
+    "shoot",
+    "explosion",
+    "invaderkilled",
+    "fastinvader1",
+    "fastinvader2",
+    "fastinvader3",
+    "fastinvader4",
+    "ufo_highpitch"
+};
+#define NUM_SOUNDS (sizeof(soundNames)/sizeof(soundNames[0]))
+
+int writeAssetSource(FILE *output, const char *resourceFolder);
+uint8_t *readWholeFile(const char *path, size_t *fileSize);
+int16_t *decodeWav(const uint8_t *wav, size_t wavSize, uint32_t *numSamples);
+
+int main(int argc, char **argv)
+{
+    if(argc != 3){
+        fprintf(stderr, "Usage: %s <resource folder> <output .c file>\n", argv[0]);
+        return 1;
+    }
+
+    // Written beside the output and renamed over it once complete, so a failed run never leaves
+    // a truncated file behind that make would consider up to date
+    char tempPath[1024];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", argv[2]);
+    FILE *output = fopen(tempPath, "w");
+    if(output == NULL){
+        fprintf(stderr, "Failed to open %s for writing\n", tempPath);
+        return 1;
+    }
+
+    int succeeded = writeAssetSource(output, argv[1]);
+    if(ferror(output)){
+        fprintf(stderr, "Failed to write %s\n", tempPath);
+        succeeded = 0;
+    }
+    if(fclose(output) != 0){
+        fprintf(stderr, "Failed to close %s\n", tempPath);
+        succeeded = 0;
+    }
+    if(!succeeded){
+        remove(tempPath);
+        return 1;
+    }
+
+    remove(argv[2]);  // rename does not replace an existing file on Windows
+    if(rename(tempPath, argv[2]) != 0){
+        fprintf(stderr, "Failed to rename %s to %s\n", tempPath, argv[2]);
+        remove(tempPath);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes the C source holding the ROM and the decoded sounds
+ * @param output - File the source is written to
+ * @param resourceFolder - Folder holding the ROM and the WAV files
+ * @return - 1 on success, 0 if an asset could not be read or decoded
+ */
+int writeAssetSource(FILE *output, const char *resourceFolder)
+{
+    char path[1024];
+    size_t fileSize;
+
+    fprintf(output, "// Generated by assetPacker.c from the resource folder. Do not edit.\n\n");
+    fprintf(output, "#include \"embeddedAssets.h\"\n\n");
+
+    // ROM
+    snprintf(path, sizeof(path), "%s/invaders", resourceFolder);
+    uint8_t *rom = readWholeFile(path, &fileSize);
+    if(rom == NULL || fileSize != ROM_LIMIT_8080){
+        fprintf(stderr, "%s is missing or is not %d bytes\n", path, ROM_LIMIT_8080);
+        free(rom);
+        return 0;
+    }
+    fprintf(output, "const uint8_t embeddedInvadersRom[ROM_LIMIT_8080] = {");
+    for(size_t byteNum = 0; byteNum < fileSize; byteNum++){
+        fprintf(output, "%s0x%02x,", (byteNum % VALUES_PER_LINE == 0) ? "\n    " : " ", rom[byteNum]);
+    }
+    fprintf(output, "\n};\n\n");
+    free(rom);
+
+    // Sounds
+    uint32_t numSamples[NUM_SOUNDS];
+    for(unsigned int soundNum = 0; soundNum < NUM_SOUNDS; soundNum++){
+        snprintf(path, sizeof(path), "%s/%s.wav", resourceFolder, soundNames[soundNum]);
+        uint8_t *wav = readWholeFile(path, &fileSize);
+        if(wav == NULL){
+            fprintf(stderr, "Failed to read %s\n", path);
+            return 0;
+        }
+        int16_t *samples = decodeWav(wav, fileSize, &(numSamples[soundNum]));
+        if(samples == NULL){
+            fprintf(stderr, "%s is not an uncompressed PCM WAV file\n", path);
+            free(wav);
+            return 0;
+        }
+
+        fprintf(output, "const int16_t embeddedSound%u[%u] = {", soundNum, numSamples[soundNum]);
+        for(uint32_t sampleNum = 0; sampleNum < numSamples[soundNum]; sampleNum++){
+            fprintf(output, "%s%d,", (sampleNum % VALUES_PER_LINE == 0) ? "\n    " : " ", samples[sampleNum]);
+        }
+        fprintf(output, "\n};\n\n");
+
+        free(samples);
+        free(wav);
+    }
+
+    fprintf(output, "const EmbeddedSound embeddedSounds[] = {\n");
+    for(unsigned int soundNum = 0; soundNum < NUM_SOUNDS; soundNum++){
+        fprintf(output, "    {\"%s\", embeddedSound%u, %u},\n", soundNames[soundNum], soundNum, numSamples[soundNum]);
+    }
+    fprintf(output, "};\n\n");
+    fprintf(output, "const unsigned int numEmbeddedSounds = %u;\n\n", (unsigned int)NUM_SOUNDS);
+
+    fprintf(output,
+            "const EmbeddedSound *getEmbeddedSound(const char *name)\n"
+            "{\n"
+            "    for(unsigned int soundNum = 0; soundNum < numEmbeddedSounds; soundNum++){\n"
+            "        if(strcmp(embeddedSounds[soundNum].name, name) == 0){\n"
+            "            return &(embeddedSounds[soundNum]);\n"
+            "        }\n"
+            "    }\n"
+            "\n"
+            "    return NULL;\n"
+            "}\n");
+
+    return 1;
+
+}
+
+/**
+ * Reads an entire file into a newly allocated buffer
+ * @param path - Path of the file
+ * @param fileSize - Receives the number of bytes read
+ * @return - pointer to the file contents, or NULL on failure
+ */
+uint8_t *readWholeFile(const char *path, size_t *fileSize)
+{
+    FILE *file = fopen(path, "rb");
+    if(file == NULL){
+        return NULL;
+    }
+
+    long size = -1;
+    if(fseek(file, 0, SEEK_END) == 0){
+        size = ftell(file);
+    }
+    if(size <= 0 || fseek(file, 0, SEEK_SET) != 0){
+        fclose(file);
+        return NULL;
+    }
+
+    uint8_t *contents = malloc(size);
+    if(contents == NULL){
+        fclose(file);
+        return NULL;
+    }
+    if(fread(contents, 1, size, file) != (size_t)size){
+        free(contents);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+    *fileSize = (size_t)size;
+    return contents;
+}
+
+/**
+ * Decodes a PCM WAV file to mono, signed 16-bit samples at AUDIO_SAMPLE_RATE.
+ * Channels are averaged and the sample rate is converted by linear interpolation.
+ * @param wav - Contents of the WAV file
+ * @param wavSize - Size of the WAV file, in bytes
+ * @param numSamples - Receives the number of decoded samples
+ * @return - pointer to the decoded samples, or NULL if the file could not be decoded
+ */
+int16_t *decodeWav(const uint8_t *wav, size_t wavSize, uint32_t *numSamples)
+{
+    unsigned int numChannels = 0;
+    unsigned int sampleRate = 0;
+    unsigned int bitsPerSample = 0;
+    const uint8_t *data = NULL;
+    uint32_t dataSize = 0;
+
+    if(wavSize < 12 || memcmp(wav, "RIFF", 4) != 0 || memcmp(&(wav[8]), "WAVE", 4) != 0){
+        return NULL;
+    }
+
+    // Walk the RIFF chunks looking for the format and the samples
+    size_t chunkOffset = 12;
+    while(chunkOffset+8 <= wavSize){
+        const uint8_t *chunk = &(wav[chunkOffset]);
+        uint32_t chunkSize = readLittleEndian(&(chunk[4]), 4);
+        if(chunkOffset+8+chunkSize > wavSize){
+            chunkSize = (uint32_t)(wavSize-chunkOffset-8);  // Tolerate truncated files
+        }
+
+        if(memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16){
+            if(readLittleEndian(&(chunk[8]), 2) != 1){
+                return NULL;  // Not PCM
+            }
+            numChannels = readLittleEndian(&(chunk[10]), 2);
+            sampleRate = readLittleEndian(&(chunk[12]), 4);
+            bitsPerSample = readLittleEndian(&(chunk[22]), 2);
+        }else if(memcmp(chunk, "data", 4) == 0){
+            data = &(chunk[8]);
+            dataSize = chunkSize;
+        }
+
+        chunkOffset += 8 + chunkSize + (chunkSize & 1);  // Chunks are padded to an even size
+    }
+
+    if(data == NULL || numChannels == 0 || sampleRate == 0 || (bitsPerSample != 8 && bitsPerSample != 16)){
+        return NULL;
+    }
+
+    // Decode to mono at the source rate
+    unsigned int bytesPerFrame = numChannels*(bitsPerSample/8);
+    uint32_t numSourceFrames = dataSize/bytesPerFrame;
+    int32_t *sourceFrames = malloc((numSourceFrames+1)*sizeof(int32_t));
+    for(uint32_t frameNum = 0; frameNum < numSourceFrames; frameNum++){
+        int32_t sum = 0;
+        for(unsigned int channel = 0; channel < numChannels; channel++){
+            const uint8_t *sample = &(data[frameNum*bytesPerFrame + channel*(bitsPerSample/8)]);
+            if(bitsPerSample == 8){
+                sum += ((int32_t)sample[0] - 128) << 8;  // 8-bit WAV samples are unsigned
+            }else{
+                sum += (int16_t)readLittleEndian(sample, 2);
+            }
+        }
+        sourceFrames[frameNum] = sum/(int32_t)numChannels;
+    }
+    sourceFrames[numSourceFrames] = (numSourceFrames > 0) ? sourceFrames[numSourceFrames-1] : 0;
+
+    // Convert to the output rate
+    *numSamples = (uint32_t)(((uint64_t)numSourceFrames*AUDIO_SAMPLE_RATE)/sampleRate);
+    int16_t *samples = malloc((*numSamples+1)*sizeof(int16_t));
+    for(uint32_t sampleNum = 0; sampleNum < *numSamples; sampleNum++){
+        uint64_t sourcePosition = ((uint64_t)sampleNum*sampleRate << 16)/AUDIO_SAMPLE_RATE;  // 16.16 fixed point
+        uint32_t sourceIndex = (uint32_t)(sourcePosition >> 16);
+        int32_t fraction = (int32_t)(sourcePosition & 0xffff);
+        int32_t first = sourceFrames[sourceIndex];
+        int32_t second = sourceFrames[sourceIndex+1];
+        samples[sampleNum] = (int16_t)(first + (int32_t)(((int64_t)(second-first)*fraction) >> 16));
+    }
+
+    free(sourceFrames);
+    return samples;
+}
@@ -0,0 +1,245 @@
+/***********************************************************************************
+ *
+ * Source for the low-latency audio pipeline used by the arcade machine
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "audioEngine.h"
+#include "helpers.h"
+
+#define AUDIO_RING_MASK (AUDIO_RING_CAPACITY-1)
+#define AUDIO_PRODUCER_RATE 60  // renderAudio() is called once per emulated frame
+
+void SDLCALL fillAudioDevice(void *userdata, Uint8 *stream, int len);
+unsigned int roundPeriodFrames(unsigned int periodFrames);
+
+AudioEngine *initializeAudioEngine(unsigned int periodFrames)
+{
+    AudioEngine *audio = mallocSet(sizeof(AudioEngine));
+    SDL_AudioSpec desiredSpec;
+    SDL_AudioSpec obtainedSpec;
+
+    SDL_zero(desiredSpec);
+    desiredSpec.freq = AUDIO_SAMPLE_RATE;
+    desiredSpec.format = AUDIO_S16SYS;
+    desiredSpec.channels = AUDIO_OUTPUT_CHANNELS;
+    desiredSpec.samples = (Uint16)roundPeriodFrames(periodFrames);
+    desiredSpec.callback = fillAudioDevice;
+    desiredSpec.userdata = audio;
+
+    // Do not allow any changes, the callback relies on this exact format
+    audio->device = SDL_OpenAudioDevice(NULL, 0, &desiredSpec, &obtainedSpec, 0);
+    if(audio->device == 0){
+        LOG(LOG_ERROR, "Audio device could not be opened! SDL Error: %s\n", SDL_GetError());
+        free(audio);
+        return NULL;
+    }
+
+    // Keep enough queued for two device periods, plus the audio produced by one emulated frame,
+    // as the producer only gets to run once per frame
+    audio->periodFrames = obtainedSpec.samples;
+    audio->targetFill = 2*audio->periodFrames + (AUDIO_SAMPLE_RATE/AUDIO_PRODUCER_RATE);
+    audio->deviceStarted = false;
+    SDL_AtomicSet(&audio->readIndex, 0);
+    SDL_AtomicSet(&audio->writeIndex, 0);
+    SDL_AtomicSet(&audio->underruns, 0);
+    SDL_AtomicSet(&audio->underrunFrames, 0);
+
+    return audio;
+}
+
+void destroyAudioEngine(AudioEngine *audio)
+{
+    if(audio == NULL){
+        return;
+    }
+
+    SDL_CloseAudioDevice(audio->device);
+    free(audio);
+}
+
+int loadAudioClip(const char *path, AudioClip *clip)
+{
+    SDL_AudioSpec wavSpec;
+    Uint8 *wavBuffer;
+    Uint32 wavLength;
+    SDL_AudioCVT converter;
+
+    if(SDL_LoadWAV(path, &wavSpec, &wavBuffer, &wavLength) == NULL){
+        return 0;
+    }
+
+    // Convert to mono signed 16-bit at the output rate
+    if(SDL_BuildAudioCVT(&converter, wavSpec.format, wavSpec.channels, wavSpec.freq,
+            AUDIO_S16SYS, 1, AUDIO_SAMPLE_RATE) < 0){
+        SDL_FreeWAV(wavBuffer);
+        return 0;
+    }
+    converter.len = (int)wavLength;
+    converter.buf = mallocSet(wavLength*converter.len_mult);
+    memcpy(converter.buf, wavBuffer, wavLength);
+    SDL_FreeWAV(wavBuffer);
+
+    if(SDL_ConvertAudio(&converter) < 0){
+        free(converter.buf);
+        return 0;
+    }
+
+    clip->samples = (int16_t *)converter.buf;
+    clip->numSamples = converter.len_cvt/sizeof(int16_t);
+    clip->ownsSamples = true;
+
+    return 1;
+}
+
+void freeAudioClip(AudioClip *clip)
+{
+    if(clip->ownsSamples){
+        free((void *)clip->samples);
+    }
+    clip->samples = NULL;
+    clip->numSamples = 0;
+    clip->ownsSamples = false;
+}
+
+void playAudioClip(AudioEngine *audio, const AudioClip *clip, bool looping)
+{
+    if(clip->numSamples == 0){
+        return;
+    }
+
+    for(int voiceNum = 0; voiceNum < AUDIO_MAX_VOICES; voiceNum++){
+        AudioVoice *voice = &(audio->voices[voiceNum]);
+        if(!voice->active){
+            voice->clip = clip;
+            voice->position = 0;
+            voice->looping = looping;
+            voice->active = true;
+            return;
+        }
+    }
+}
+
+void stopAudioClip(AudioEngine *audio, const AudioClip *clip)
+{
+    for(int voiceNum = 0; voiceNum < AUDIO_MAX_VOICES; voiceNum++){
+        if(audio->voices[voiceNum].clip == clip){
+            audio->voices[voiceNum].active = false;
+        }
+    }
+}
+
+bool isAudioClipPlaying(AudioEngine *audio, const AudioClip *clip)
+{
+    for(int voiceNum = 0; voiceNum < AUDIO_MAX_VOICES; voiceNum++){
+        if(audio->voices[voiceNum].active && audio->voices[voiceNum].clip == clip){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void renderAudio(AudioEngine *audio)
+{
+    // Only this thread advances writeIndex, so it needs no synchronization with itself
+    uint32_t writeIndex = (uint32_t)SDL_AtomicGet(&audio->writeIndex);
+    uint32_t readIndex = (uint32_t)SDL_AtomicGet(&audio->readIndex);
+    uint32_t queuedSamples = writeIndex - readIndex;
+
+    if(queuedSamples < audio->targetFill){
+        uint32_t samplesToRender = audio->targetFill - queuedSamples;
+
+        for(uint32_t sampleNum = 0; sampleNum < samplesToRender; sampleNum++){
+            int32_t mixedSample = 0;
+
+            for(int voiceNum = 0; voiceNum < AUDIO_MAX_VOICES; voiceNum++){
+                AudioVoice *voice = &(audio->voices[voiceNum]);
+                if(voice->active){
+                    mixedSample += voice->clip->samples[voice->position];
+                    voice->position++;
+                    if(voice->position >= voice->clip->numSamples){
+                        voice->position = 0;
+                        voice->active = voice->looping;
+                    }
+                }
+            }
+
+            // Clip to 16 bits
+            if(mixedSample > INT16_MAX){
+                mixedSample = INT16_MAX;
+            }else if(mixedSample < INT16_MIN){
+                mixedSample = INT16_MIN;
+            }
+            audio->ring[(writeIndex+sampleNum) & AUDIO_RING_MASK] = (int16_t)mixedSample;
+        }
+
+        // Publish the new samples only after they have been written
+        SDL_AtomicSet(&audio->writeIndex, (int)(writeIndex+samplesToRender));
+    }
+
+    // Wait for the first batch of samples before starting playback, otherwise the first callbacks would underrun
+    if(!audio->deviceStarted){
+        SDL_PauseAudioDevice(audio->device, 0);
+        audio->deviceStarted = true;
+    }
+}
+
+unsigned int getAudioUnderrunCount(AudioEngine *audio)
+{
+    return (unsigned int)SDL_AtomicGet(&audio->underruns);
+}
+
+unsigned int getAudioUnderrunFrames(AudioEngine *audio)
+{
+    return (unsigned int)SDL_AtomicGet(&audio->underrunFrames);
+}
+
+/**
+ * Audio device callback, runs on SDL's audio thread.
+ * Copies queued mono samples from the ring to both output channels, padding with silence on underrun.
+ */
+void SDLCALL fillAudioDevice(void *userdata, Uint8 *stream, int len)
+{
+    AudioEngine *audio = (AudioEngine *)userdata;
+    int16_t *output = (int16_t *)stream;
+    uint32_t framesRequested = (uint32_t)len / (sizeof(int16_t)*AUDIO_OUTPUT_CHANNELS);
+
+    // Only this thread advances readIndex
+    uint32_t readIndex = (uint32_t)SDL_AtomicGet(&audio->readIndex);
+    uint32_t writeIndex = (uint32_t)SDL_AtomicGet(&audio->writeIndex);
+    uint32_t framesAvailable = writeIndex - readIndex;
+    uint32_t framesToCopy = (framesAvailable < framesRequested) ? framesAvailable : framesRequested;
+
+    for(uint32_t frameNum = 0; frameNum < framesToCopy; frameNum++){
+        int16_t sample = audio->ring[(readIndex+frameNum) & AUDIO_RING_MASK];
+        for(int channel = 0; channel < AUDIO_OUTPUT_CHANNELS; channel++){
+            output[frameNum*AUDIO_OUTPUT_CHANNELS + channel] = sample;
+        }
+    }
+
+    if(framesToCopy < framesRequested){
+        uint32_t missingFrames = framesRequested - framesToCopy;
+        memset(&(output[framesToCopy*AUDIO_OUTPUT_CHANNELS]), 0, missingFrames*sizeof(int16_t)*AUDIO_OUTPUT_CHANNELS);
+        SDL_AtomicAdd(&audio->underruns, 1);
+        SDL_AtomicAdd(&audio->underrunFrames, (int)missingFrames);
+    }
+
+    // Hand the consumed slots back to the producer
+    SDL_AtomicSet(&audio->readIndex, (int)(readIndex+framesToCopy));
+}
+
+/**
+ * Clamps a requested period to the supported range and rounds it up to a power of 2, as SDL expects
+ */
+unsigned int roundPeriodFrames(unsigned int periodFrames)
+{
+    unsigned int roundedFrames = AUDIO_MIN_PERIOD_FRAMES;
+
+    while(roundedFrames < periodFrames && roundedFrames < AUDIO_MAX_PERIOD_FRAMES){
+        roundedFrames <<= 1;
+    }
+
+    return roundedFrames;
+}
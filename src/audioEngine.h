@@ -0,0 +1,136 @@
+/***********************************************************************************
+ *
+ * Header for the low-latency audio pipeline used by the arcade machine.
+ *
+ * Sound effects are mixed on the emulation thread and handed to the audio device
+ * through a single-producer/single-consumer lock-free ring buffer.
+ * The audio device callback only ever copies out of the ring, so the size of its
+ * period (and hence the output latency) can be chosen at runtime.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_AUDIOENGINE_H
+#define INTEL_8080_EMULATOR_AUDIOENGINE_H
+
+#include "sdl_sources/SDL.h"
+#include "cpuStructures.h"
+
+#define AUDIO_SAMPLE_RATE 44100
+#define AUDIO_OUTPUT_CHANNELS 2
+#define AUDIO_DEFAULT_PERIOD_FRAMES 256
+#define AUDIO_MIN_PERIOD_FRAMES 64
+#define AUDIO_MAX_PERIOD_FRAMES 4096
+#define AUDIO_RING_CAPACITY 16384  // Mono samples, must be a power of 2
+#define AUDIO_MAX_VOICES 8  // Same number of channels SDL_mixer allocated by default
+
+/**
+ * A mono, signed 16-bit sound, already converted to AUDIO_SAMPLE_RATE
+ */
+typedef struct AudioClip{
+    const int16_t *samples;
+    uint32_t numSamples;
+    bool ownsSamples;  /**< Whether the samples were allocated when loading the clip */
+} AudioClip;
+
+/**
+ * A clip currently being mixed into the output
+ */
+typedef struct AudioVoice{
+    const AudioClip *clip;
+    uint32_t position;  /**< Index of the next sample to be mixed */
+    bool looping;
+    bool active;
+} AudioVoice;
+
+/**
+ * Holds the audio device and the ring buffer feeding it.
+ *
+ * readIndex is only advanced by the audio callback and writeIndex is only advanced by the emulation thread.
+ * Both are free-running counters, masked with (AUDIO_RING_CAPACITY-1) to index the ring.
+ */
+typedef struct AudioEngine{
+    SDL_AudioDeviceID device;
+    unsigned int periodFrames;  /**< Sample frames requested by the audio device per callback */
+    unsigned int targetFill;  /**< Samples the producer tries to keep queued in the ring */
+    bool deviceStarted;
+    int16_t ring[AUDIO_RING_CAPACITY];
+    SDL_atomic_t readIndex;
+    SDL_atomic_t writeIndex;
+    SDL_atomic_t underruns;  /**< Number of callbacks that found fewer samples than requested */
+    SDL_atomic_t underrunFrames;  /**< Total sample frames replaced by silence */
+    AudioVoice voices[AUDIO_MAX_VOICES];
+} AudioEngine;
+
+/**
+ * Opens the default audio device with the requested period.
+ * SDL_INIT_AUDIO must already be initialized.
+ * @param periodFrames - Sample frames per device callback, clamped to [AUDIO_MIN_PERIOD_FRAMES, AUDIO_MAX_PERIOD_FRAMES]
+ * @return - pointer to an initialized audio engine, or NULL if the device could not be opened
+ */
+AudioEngine *initializeAudioEngine(unsigned int periodFrames);
+
+/**
+ * Closes the audio device and frees the engine.
+ * Does not free any clips.
+ * @param audio - The audio engine
+ */
+void destroyAudioEngine(AudioEngine *audio);
+
+/**
+ * Loads a WAV file and converts it to the engine's sample format.
+ * @param path - Path of the WAV file
+ * @param clip - Clip to be filled
+ * @return int - 1 if the load was successful, 0 otherwise
+ */
+int loadAudioClip(const char *path, AudioClip *clip);
+
+/**
+ * Frees the samples held by a clip, if the clip owns them.
+ * @param clip - The clip to free
+ */
+void freeAudioClip(AudioClip *clip);
+
+/**
+ * Starts mixing a clip into the output.
+ * Silently does nothing if every voice is busy.
+ * @param audio - The audio engine
+ * @param clip - The clip to play
+ * @param looping - Whether the clip should restart once it finishes
+ */
+void playAudioClip(AudioEngine *audio, const AudioClip *clip, bool looping);
+
+/**
+ * Stops every voice currently playing a clip.
+ * @param audio - The audio engine
+ * @param clip - The clip to stop
+ */
+void stopAudioClip(AudioEngine *audio, const AudioClip *clip);
+
+/**
+ * @param audio - The audio engine
+ * @param clip - The clip to check
+ * @return - true if any voice is playing the clip
+ */
+bool isAudioClipPlaying(AudioEngine *audio, const AudioClip *clip);
+
+/**
+ * Mixes the active voices into the ring buffer until it holds the target amount of queued audio.
+ * Should be called once per emulated frame, from the emulation thread.
+ * @param audio - The audio engine
+ */
+void renderAudio(AudioEngine *audio);
+
+/**
+ * @param audio - The audio engine
+ * @return - Number of device callbacks that ran out of queued samples
+ */
+unsigned int getAudioUnderrunCount(AudioEngine *audio);
+
+/**
+ * @param audio - The audio engine
+ * @return - Number of sample frames that were replaced with silence due to underruns
+ */
+unsigned int getAudioUnderrunFrames(AudioEngine *audio);
+
+#endif //INTEL_8080_EMULATOR_AUDIOENGINE_H
@@ -0,0 +1,347 @@
+/***********************************************************************************
+ *
+ * Emulator benchmark suite.
+ *
+ * Measures the throughput of the CPU core on its own, of whole frames without rendering,
+ * of converting VRAM into pixels, and of saving and restoring snapshots. Every benchmark
+ * starts from the same point of a recorded game and is repeated several times, after an
+ * untimed warm-up run, so that runs of different builds can be compared. The mean,
+ * standard deviation and a 95% confidence interval of each are written out as JSON.
+ *
+ * Usage: benchmark [--movie FILE] [--repeat N] [--output FILE] [--resources DIR]
+ * --movie FILE   Recorded game supplying the input (default "tests/one_player.mov")
+ * --repeat N     Timed runs of each benchmark (default 10)
+ * --output FILE  File the JSON results are written to (default "bench.json")
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "arcadeEnvironment.h"
+#include "movie.h"
+#include "saveState.h"
+
+#define DEFAULT_BENCH_MOVIE "tests/one_player.mov"
+#define DEFAULT_BENCH_OUTPUT "bench.json"
+#define DEFAULT_BENCH_REPEATS 10
+#define MAX_BENCH_REPEATS 1000
+#define BENCH_FORMAT_VERSION 1
+#define BENCH_START_FRAME 1800  // A keyframe of the test movies, in the middle of a game
+#define BENCH_FRAMES 600  // Frames emulated per run
+#define BENCH_CONVERSIONS 200  // Frames converted to pixels per run
+#define BENCH_SNAPSHOTS 20000  // Snapshots saved or restored per run
+
+/**
+ * Timings of one benchmark
+ */
+typedef struct BenchResult{
+    char name[64];
+    const char *unit;
+    double samples[MAX_BENCH_REPEATS];  /**< Rate measured by each run */
+    unsigned int numSamples;
+    double mean;
+    double standardDeviation;
+    double confidenceInterval;  /**< Half-width of the 95% confidence interval of the mean */
+} BenchResult;
+
+/**
+ * Everything the benchmarks share
+ */
+typedef struct BenchSession{
+    ArcadeState *arcade;
+    uint8_t startState[SAVE_STATE_SIZE];  /**< The arcade at BENCH_START_FRAME, every run starts from here */
+    uint8_t scratchState[SAVE_STATE_SIZE];
+    unsigned int numRepeats;
+} BenchSession;
+
+double benchCpuCore(BenchSession *session);
+double benchFrameStepping(BenchSession *session);
+double benchFrameConversion(BenchSession *session);
+double benchSnapshotSave(BenchSession *session);
+double benchSnapshotRestore(BenchSession *session);
+void runBenchmark(BenchSession *session, BenchResult *result, const char *name, const char *unit,
+                  double (*benchmark)(BenchSession *session));
+void summarizeSamples(BenchResult *result);
+double getStudentT95(unsigned int degreesOfFreedom);
+double getSeconds(uint64_t startTicks);
+void writeBenchJSON(FILE *output, const char *moviePath, unsigned int numRepeats,
+                    const BenchResult *results, unsigned int numResults);
+
+int main(int argc, char **argv)
+{
+    ArcadeConfig config;
+    setHeadlessArcadeConfig(&config);
+    const char *moviePath = DEFAULT_BENCH_MOVIE;
+    const char *outputPath = DEFAULT_BENCH_OUTPUT;
+    unsigned int numRepeats = DEFAULT_BENCH_REPEATS;
+
+    for(int argNum = 1; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--movie") == 0 && argNum+1 < argc){
+            argNum++;
+            moviePath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--repeat") == 0 && argNum+1 < argc){
+            argNum++;
+            numRepeats = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--output") == 0 && argNum+1 < argc){
+            argNum++;
+            outputPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--resources") == 0 && argNum+1 < argc){
+            argNum++;
+            config.resourcePath = argv[argNum];
+        }else{
+            logger("Usage: %s [--movie FILE] [--repeat N] [--output FILE] [--resources DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(numRepeats < 2 || numRepeats > MAX_BENCH_REPEATS){
+        logger("Number of runs must be from 2 to %d\n", MAX_BENCH_REPEATS);
+        return 1;
+    }
+
+    config.playPath = moviePath;
+    BenchSession *session = mallocSet(sizeof(BenchSession));
+    session->numRepeats = numRepeats;
+    session->arcade = initializeArcade(&config);
+    if(session->arcade == NULL){
+        free(session);
+        return 1;
+    }
+    if(session->arcade->moviePlayer->numFrames < BENCH_START_FRAME+BENCH_FRAMES ||
+       seekMovie(session->arcade->moviePlayer, session->arcade, BENCH_START_FRAME) == 0){
+        logger("Movie %s is too short to benchmark with, it needs %d frames\n", moviePath, BENCH_START_FRAME+BENCH_FRAMES);
+        destroyArcade(session->arcade);
+        free(session);
+        return 1;
+    }
+    saveState(session->arcade, session->startState, SAVE_STATE_SIZE);
+
+    // The CPU engine benchmarks are run once per engine, with the arcade's engine swapped out
+    BenchResult *results = mallocSet((2*NUM_CPU_ENGINES+3)*sizeof(BenchResult));
+    unsigned int numResults = 0;
+    CpuEngine *originalEngine = session->arcade->engine;
+    char name[64];
+    for(unsigned int engineNum = 0; engineNum < NUM_CPU_ENGINES; engineNum++){
+        session->arcade->engine = initializeCpuEngine((enum CpuEngineType)engineNum);
+        prepareCpuEngine(session->arcade->engine, session->arcade->cpu->memory);
+        snprintf(name, sizeof(name), "cpu_core.%s", getCpuEngineName((enum CpuEngineType)engineNum));
+        runBenchmark(session, &(results[numResults++]), name, "MHz", benchCpuCore);
+        snprintf(name, sizeof(name), "frame_step.%s", getCpuEngineName((enum CpuEngineType)engineNum));
+        runBenchmark(session, &(results[numResults++]), name, "frames/s", benchFrameStepping);
+        destroyCpuEngine(session->arcade->engine);
+    }
+    session->arcade->engine = originalEngine;
+    runBenchmark(session, &(results[numResults++]), "frame_conversion", "frames/s", benchFrameConversion);
+    runBenchmark(session, &(results[numResults++]), "snapshot_save", "snapshots/s", benchSnapshotSave);
+    runBenchmark(session, &(results[numResults++]), "snapshot_restore", "snapshots/s", benchSnapshotRestore);
+
+    int exitCode = 0;
+    FILE *output = fopen(outputPath, "w");
+    if(output == NULL){
+        logger("Failed to open %s for writing\n", outputPath);
+        exitCode = 1;
+    }else{
+        writeBenchJSON(output, moviePath, numRepeats, results, numResults);
+        fclose(output);
+        logger("Results written to %s\n", outputPath);
+    }
+
+    free(results);
+    destroyArcade(session->arcade);
+    free(session);
+    return exitCode;
+}
+
+/**
+ * Runs the CPU alone, with the interrupts at the usual points of each frame but without the I/O
+ * synchronization done around every instruction
+ * @return - Emulated clock rate, in MHz
+ */
+double benchCpuCore(BenchSession *session)
+{
+    ArcadeState *arcade = session->arcade;
+    State8080 *cpu = arcade->cpu;
+    loadState(arcade, session->startState, SAVE_STATE_SIZE);
+    unsigned int numCyclesFirstHalf = CYCLES_PER_FRAME*((float)MIDSCREEN_INTERRUPT_LINE/(float)SCREEN_WIDTH_PIXELS);
+    unsigned int numCyclesSecondHalf = CYCLES_PER_FRAME-numCyclesFirstHalf;
+    uint64_t numCycles = 0;
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int frame = 0; frame < BENCH_FRAMES; frame++){
+        unsigned int startingCycles = cpu->cyclesCompleted;
+        // Run ends are set as in runForCpuCycles, so the engine's dead flag handlers are timed too
+        setCpuEngineRunEnd(arcade->engine, startingCycles+numCyclesFirstHalf);
+        while(cpu->cyclesCompleted - startingCycles < numCyclesFirstHalf){
+            stepCpuEngine(arcade->engine, cpu);
+        }
+        clearCpuEngineRunEnd(arcade->engine);
+        generateInterrupt(0x01, cpu);
+        setCpuEngineRunEnd(arcade->engine, startingCycles+numCyclesFirstHalf+numCyclesSecondHalf);
+        while(cpu->cyclesCompleted - startingCycles < numCyclesFirstHalf+numCyclesSecondHalf){
+            stepCpuEngine(arcade->engine, cpu);
+        }
+        clearCpuEngineRunEnd(arcade->engine);
+        generateInterrupt(0x02, cpu);
+        numCycles += cpu->cyclesCompleted - startingCycles;
+    }
+
+    return numCycles/getSeconds(startTicks)/1e6;
+}
+
+/**
+ * Emulates whole frames with the recorded input, as the emulator does apart from rendering and audio
+ * @return - Frames per second
+ */
+double benchFrameStepping(BenchSession *session)
+{
+    ArcadeState *arcade = session->arcade;
+    if(seekMovie(arcade->moviePlayer, arcade, BENCH_START_FRAME) == 0){
+        return 0;
+    }
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int frame = 0; frame < BENCH_FRAMES; frame++){
+        resetPortsIO(arcade);
+        playMovieFrame(arcade->moviePlayer, arcade);
+        runFrame(arcade);
+    }
+
+    return BENCH_FRAMES/getSeconds(startTicks);
+}
+
+/**
+ * Converts VRAM into 32-bit pixels, as done before every frame is rendered
+ * @return - Frames per second
+ */
+double benchFrameConversion(BenchSession *session)
+{
+    loadState(session->arcade, session->startState, SAVE_STATE_SIZE);
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int conversionNum = 0; conversionNum < BENCH_CONVERSIONS; conversionNum++){
+        free(getCurrentFramePixels(session->arcade));
+    }
+
+    return BENCH_CONVERSIONS/getSeconds(startTicks);
+}
+
+/**
+ * @return - Snapshots saved per second
+ */
+double benchSnapshotSave(BenchSession *session)
+{
+    loadState(session->arcade, session->startState, SAVE_STATE_SIZE);
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int snapshotNum = 0; snapshotNum < BENCH_SNAPSHOTS; snapshotNum++){
+        saveState(session->arcade, session->scratchState, SAVE_STATE_SIZE);
+    }
+
+    return BENCH_SNAPSHOTS/getSeconds(startTicks);
+}
+
+/**
+ * @return - Snapshots restored per second
+ */
+double benchSnapshotRestore(BenchSession *session)
+{
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int snapshotNum = 0; snapshotNum < BENCH_SNAPSHOTS; snapshotNum++){
+        loadState(session->arcade, session->startState, SAVE_STATE_SIZE);
+    }
+
+    return BENCH_SNAPSHOTS/getSeconds(startTicks);
+}
+
+/**
+ * Runs a benchmark once to warm up, then the configured number of times
+ * @param session - Shared benchmark state
+ * @param result - Filled in with the timings
+ * @param name - Name of the benchmark in the results
+ * @param unit - Unit of the rate the benchmark returns
+ * @param benchmark - Runs the benchmark once and returns the rate it ran at
+ */
+void runBenchmark(BenchSession *session, BenchResult *result, const char *name, const char *unit,
+                  double (*benchmark)(BenchSession *session))
+{
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->unit = unit;
+
+    benchmark(session);
+    for(unsigned int repeatNum = 0; repeatNum < session->numRepeats; repeatNum++){
+        result->samples[repeatNum] = benchmark(session);
+    }
+    result->numSamples = session->numRepeats;
+    summarizeSamples(result);
+
+    logger("%-28s %12.2f %-12s +/- %.2f\n", result->name, result->mean, result->unit, result->confidenceInterval);
+}
+
+void summarizeSamples(BenchResult *result)
+{
+    double sum = 0;
+    for(unsigned int sampleNum = 0; sampleNum < result->numSamples; sampleNum++){
+        sum += result->samples[sampleNum];
+    }
+    result->mean = sum/result->numSamples;
+
+    double sumOfSquares = 0;
+    for(unsigned int sampleNum = 0; sampleNum < result->numSamples; sampleNum++){
+        double deviation = result->samples[sampleNum]-result->mean;
+        sumOfSquares += deviation*deviation;
+    }
+    result->standardDeviation = sqrt(sumOfSquares/(result->numSamples-1));
+    result->confidenceInterval = getStudentT95(result->numSamples-1)*result->standardDeviation/sqrt(result->numSamples);
+}
+
+/**
+ * @return - Two-sided 95% critical value of Student's t distribution
+ */
+double getStudentT95(unsigned int degreesOfFreedom)
+{
+    const double criticalValues[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+
+    if(degreesOfFreedom == 0){
+        return 0;
+    }else if(degreesOfFreedom <= 30){
+        return criticalValues[degreesOfFreedom-1];
+    }
+
+    return 1.96;
+}
+
+double getSeconds(uint64_t startTicks)
+{
+    return (double)(SDL_GetPerformanceCounter()-startTicks)/(double)SDL_GetPerformanceFrequency();
+}
+
+void writeBenchJSON(FILE *output, const char *moviePath, unsigned int numRepeats,
+                    const BenchResult *results, unsigned int numResults)
+{
+    fprintf(output, "{\n");
+    fprintf(output, "  \"format_version\": %d,\n", BENCH_FORMAT_VERSION);
+    fprintf(output, "  \"movie\": \"");
+    for(const char *character = moviePath; *character != '\0'; character++){
+        if(*character == '"' || *character == '\\'){
+            fputc('\\', output);
+        }
+        fputc(*character, output);
+    }
+    fprintf(output, "\",\n");
+    fprintf(output, "  \"start_frame\": %d,\n", BENCH_START_FRAME);
+    fprintf(output, "  \"repeats\": %u,\n", numRepeats);
+    fprintf(output, "  \"results\": [\n");
+    for(unsigned int resultNum = 0; resultNum < numResults; resultNum++){
+        const BenchResult *result = &(results[resultNum]);
+        fprintf(output, "    {\"name\": \"%s\", \"unit\": \"%s\", \"mean\": %.4f, \"stddev\": %.4f, \"ci95\": %.4f, \"samples\": [",
+                result->name, result->unit, result->mean, result->standardDeviation, result->confidenceInterval);
+        for(unsigned int sampleNum = 0; sampleNum < result->numSamples; sampleNum++){
+            fprintf(output, "%s%.4f", (sampleNum == 0) ? "" : ", ", result->samples[sampleNum]);
+        }
+        fprintf(output, "]}%s\n", (resultNum+1 < numResults) ? "," : "");
+    }
+    fprintf(output, "  ]\n");
+    fprintf(output, "}\n");
+}
@@ -0,0 +1,851 @@
+/***********************************************************************************
+ *
+ * Source for the interchangeable 8080 execution engines
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "cpuEngines.h"
+#include "instructions.h"
+#include "alu8080.h"
+#include "helpers.h"
+#include "profiler.h"
+#include "opcodeSpec.h"
+#include <stddef.h>
+
+// The predecoded engine leaves the last instructions of ROM to the reference engine, so operands never come from RAM
+#define PREDECODE_LIMIT (ROM_LIMIT_8080-2)
+#define MAX_FUSED_LENGTH 3
+// Condition numbers, as encoded in bits 3-5 of conditional branch opcodes
+#define CONDITION_NOT_ZERO 0
+#define CONDITION_ZERO 1
+#define CONDITION_NO_CARRY 2
+#define CONDITION_CARRY 3
+#define CONDITION_PARITY_ODD 4
+#define CONDITION_PARITY_EVEN 5
+#define CONDITION_PLUS 6
+#define CONDITION_MINUS 7
+
+const char *cpuEngineNames[NUM_CPU_ENGINES] = {"reference", "predecoded"};
+
+// Location of each register within the 8080 state, by register number; M has no register
+const size_t registerOffsets[8] = {
+    offsetof(State8080, b), offsetof(State8080, c), offsetof(State8080, d), offsetof(State8080, e),
+    offsetof(State8080, h), offsetof(State8080, l), 0, offsetof(State8080, a)
+};
+
+void decodeInstruction(PredecodedInstruction *instruction, const uint8_t *memory, uint16_t pc);
+void setDeadFlagHandler(PredecodedInstruction *instruction, const RomInstruction *analyzed);
+void computeAluLiveFlags(const PredecodedInstruction *instruction, uint8_t data, State8080 *state);
+InstructionHandler findFusedHandler(const PredecodedInstruction **sequence, unsigned int *length);
+unsigned int runHookedRoutine(CpuEngine *engine, const PredecodedInstruction *instruction, State8080 *state);
+unsigned int verifyHookedRoutine(CpuEngine *engine, const RomHook *hook, State8080 *state, unsigned int cyclesLeft);
+bool isSameMachine(const State8080 *first, const State8080 *second, int *memoryAddress);
+uint8_t *getRegister(uint8_t registerNum, State8080 *state);
+bool isConditionMet(uint8_t condition, const State8080 *state);
+void handleFallback(const PredecodedInstruction *instruction, State8080 *state);
+void handleNop(const PredecodedInstruction *instruction, State8080 *state);
+void handleMoveRegister(const PredecodedInstruction *instruction, State8080 *state);
+void handleMoveFromMemory(const PredecodedInstruction *instruction, State8080 *state);
+void handleMoveToMemory(const PredecodedInstruction *instruction, State8080 *state);
+void handleMoveImmediate(const PredecodedInstruction *instruction, State8080 *state);
+void handleIncrement(const PredecodedInstruction *instruction, State8080 *state);
+void handleDecrement(const PredecodedInstruction *instruction, State8080 *state);
+void handleDecimalAdjust(const PredecodedInstruction *instruction, State8080 *state);
+void handleAluRegister(const PredecodedInstruction *instruction, State8080 *state);
+void handleAluMemory(const PredecodedInstruction *instruction, State8080 *state);
+void handleAluImmediate(const PredecodedInstruction *instruction, State8080 *state);
+void handleLoadPair(const PredecodedInstruction *instruction, State8080 *state);
+void handleIncrementPair(const PredecodedInstruction *instruction, State8080 *state);
+void handleDecrementPair(const PredecodedInstruction *instruction, State8080 *state);
+void handleAddPair(const PredecodedInstruction *instruction, State8080 *state);
+void handlePush(const PredecodedInstruction *instruction, State8080 *state);
+void handlePop(const PredecodedInstruction *instruction, State8080 *state);
+void handleJump(const PredecodedInstruction *instruction, State8080 *state);
+void handleConditionalJump(const PredecodedInstruction *instruction, State8080 *state);
+void handleCall(const PredecodedInstruction *instruction, State8080 *state);
+void handleConditionalCall(const PredecodedInstruction *instruction, State8080 *state);
+void handleReturn(const PredecodedInstruction *instruction, State8080 *state);
+void handleConditionalReturn(const PredecodedInstruction *instruction, State8080 *state);
+void handleRestart(const PredecodedInstruction *instruction, State8080 *state);
+void handleAluRegisterLiveFlags(const PredecodedInstruction *instruction, State8080 *state);
+void handleAluMemoryLiveFlags(const PredecodedInstruction *instruction, State8080 *state);
+void handleAluImmediateLiveFlags(const PredecodedInstruction *instruction, State8080 *state);
+void handleIncrementLiveFlags(const PredecodedInstruction *instruction, State8080 *state);
+void handleDecrementLiveFlags(const PredecodedInstruction *instruction, State8080 *state);
+void runAluRegister(const PredecodedInstruction *instruction, State8080 *state);
+void runDecrement(const PredecodedInstruction *instruction, State8080 *state);
+void handleHookedRoutine(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedLoadAluJump(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedCountdownJump(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedDecrementJump(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedAluJump(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedAluImmediateJump(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedLoadAlu(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedLoadPairStore(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedLoadPairLoad(const PredecodedInstruction *instruction, State8080 *state);
+void handleFusedIncrementStep(const PredecodedInstruction *instruction, State8080 *state);
+
+// Handler of each opcode, generated from the opcode specification
+#define OPCODE_HANDLER(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) handle##handler,
+const InstructionHandler opcodeHandlers[NUM_OPCODES] = {OPCODE_SPEC(OPCODE_HANDLER)};
+
+CpuEngine *initializeCpuEngine(enum CpuEngineType type)
+{
+    CpuEngine *engine = mallocSet(sizeof(CpuEngine));
+    engine->type = type;
+    if(type == PredecodedEngine){
+        engine->decoded = mallocSet(PREDECODE_LIMIT*sizeof(PredecodedInstruction));
+    }
+
+    return engine;
+}
+
+void destroyCpuEngine(CpuEngine *engine)
+{
+    if(engine == NULL){
+        return;
+    }
+
+    free(engine->decoded);
+    destroyRomAnalysis(engine->analysis);
+    free(engine->hooks);
+    free(engine->verifyMemory);
+    free(engine);
+}
+
+unsigned int stepCpuEngine(CpuEngine *engine, State8080 *state)
+{
+    unsigned int numExecuted = 1;
+    PROFILE_INSTRUCTION_START(state)
+    if(engine->type == ReferenceEngine || state->pc >= PREDECODE_LIMIT){
+        executeNextInstruction(state);
+    }else{
+        PredecodedInstruction *instruction = &(engine->decoded[state->pc]);
+        if(instruction->handler == NULL){
+            decodeInstruction(instruction, state->memory, state->pc);
+            if(engine->analysis != NULL){
+                setDeadFlagHandler(instruction, &(engine->analysis->instructions[state->pc]));
+            }
+        }
+        // Flags left stale must be overwritten, and fused sequences finished, before the run ends
+        if(instruction->fastHandler != NULL && engine->runEndKnown
+           && (int)(engine->runEndCycles - state->cyclesCompleted) > (int)(instruction->fastDistance*MAX_INSTRUCTION_CYCLES)){
+            if(instruction->fastHandler == handleHookedRoutine){
+                numExecuted = runHookedRoutine(engine, instruction, state);
+            }else{
+                instruction->fastHandler(instruction, state);
+                numExecuted = instruction->fastLength;
+            }
+        }else{
+            instruction->handler(instruction, state);
+        }
+    }
+    PROFILE_INSTRUCTION_END(state)
+    return numExecuted;
+}
+
+int predecodeAddress(CpuEngine *engine, const uint8_t *memory, uint16_t address)
+{
+    if(engine->type != PredecodedEngine || address >= PREDECODE_LIMIT){
+        return 0;
+    }
+
+    PredecodedInstruction *instruction = &(engine->decoded[address]);
+    if(instruction->handler == NULL){
+        decodeInstruction(instruction, memory, address);
+        if(engine->analysis != NULL){
+            setDeadFlagHandler(instruction, &(engine->analysis->instructions[address]));
+        }
+    }
+    return 1;
+}
+
+unsigned int fuseInstructions(CpuEngine *engine, const uint8_t *memory, uint16_t address)
+{
+#ifdef CPU_PROFILE
+    // The profiler counts every step as one instruction
+    return 0;
+#else
+    const PredecodedInstruction *sequence[MAX_FUSED_LENGTH];
+    unsigned int length = 0;
+    uint32_t nextAddress = address;
+    while(length < MAX_FUSED_LENGTH && predecodeAddress(engine, memory, (uint16_t)nextAddress)){
+        sequence[length] = &(engine->decoded[nextAddress]);
+        nextAddress += instructionSizes[memory[nextAddress]];
+        length++;
+    }
+
+    InstructionHandler fusedHandler = findFusedHandler(sequence, &length);
+    if(fusedHandler == NULL){
+        return 0;
+    }
+
+    // Every instruction must run, and flags any of them leave stale must be overwritten, before the run ends
+    unsigned int distance = length-1;
+    for(unsigned int instructionNum = 0; instructionNum < length; instructionNum++){
+        const PredecodedInstruction *component = sequence[instructionNum];
+        if(component->liveFlags != ALL_FLAGS && instructionNum+component->fastDistance > distance){
+            distance = instructionNum+component->fastDistance;
+        }
+    }
+    PredecodedInstruction *first = &(engine->decoded[address]);
+    first->fastHandler = fusedHandler;
+    first->fastDistance = (uint8_t)distance;
+    first->fastLength = (uint8_t)length;
+    return length;
+#endif
+}
+
+void prepareCpuEngine(CpuEngine *engine, const uint8_t *memory)
+{
+    if(engine->type != PredecodedEngine || engine->analysis != NULL){
+        return;
+    }
+
+    engine->analysis = analyzeRom(memory);
+}
+
+uint32_t installCpuEngineHooks(CpuEngine *engine, const uint8_t *memory, enum RomHookMode mode)
+{
+#ifdef CPU_PROFILE
+    // The profiler counts every step as one instruction, a whole native routine would count as one
+    return 0;
+#else
+    if(engine->type != PredecodedEngine || mode == HooksOff){
+        return 0;
+    }
+
+    if(engine->hooks == NULL){
+        engine->hooks = mallocSet(PREDECODE_LIMIT*sizeof(const RomHook *));
+    }
+    if(mode == HooksVerified && engine->verifyMemory == NULL){
+        engine->verifyMemory = mallocSet(MEMORY_SIZE_8080);
+    }
+    uint32_t numHooked = 0;
+    for(uint32_t address = 0; address < PREDECODE_LIMIT; address++){
+        const RomHook *hook = findRomHook(memory, (uint16_t)address);
+        if(hook == NULL || address+hook->codeLength > PREDECODE_LIMIT || !predecodeAddress(engine, memory, (uint16_t)address)){
+            continue;
+        }
+        // The decoded handler is kept, for when the native routine does not fit in what is left of the run
+        PredecodedInstruction *instruction = &(engine->decoded[address]);
+        instruction->fastHandler = handleHookedRoutine;
+        instruction->liveFlags = ALL_FLAGS;
+        instruction->fastDistance = 0;
+        instruction->fastLength = 1;
+        engine->hooks[address] = hook;
+        numHooked++;
+    }
+
+    return numHooked;
+#endif
+}
+
+bool isCpuEngineHooked(const CpuEngine *engine, uint16_t address)
+{
+    return engine->hooks != NULL && address < PREDECODE_LIMIT && engine->hooks[address] != NULL;
+}
+
+void setCpuEngineRunEnd(CpuEngine *engine, unsigned int endCycles)
+{
+    engine->runEndCycles = endCycles;
+    engine->runEndKnown = true;
+}
+
+void clearCpuEngineRunEnd(CpuEngine *engine)
+{
+    engine->runEndKnown = false;
+}
+
+uint8_t getCpuEngineLiveFlags(const CpuEngine *engine, uint16_t address)
+{
+    if(engine->analysis == NULL){
+        return ALL_FLAGS;
+    }
+
+    return getLiveFlags(engine->analysis, address);
+}
+
+const char *getCpuEngineName(enum CpuEngineType type)
+{
+    if((unsigned int)type >= NUM_CPU_ENGINES){
+        return "unknown";
+    }
+
+    return cpuEngineNames[type];
+}
+
+int findCpuEngine(const char *name, enum CpuEngineType *type)
+{
+    for(unsigned int engineNum = 0; engineNum < NUM_CPU_ENGINES; engineNum++){
+        if(strcmp(name, cpuEngineNames[engineNum]) == 0){
+            *type = (enum CpuEngineType)engineNum;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Picks the handler for the ROM instruction at the program counter, as named by the opcode specification,
+ * and extracts its operands. Handlers reuse the helpers from instructions.c, or the table-driven ALU, and charge
+ * the specification's cycles, so results match the reference engine exactly. Instructions whose reference
+ * implementation has quirks of its own, such as ADC M, are left to the reference engine.
+ * ROM is never expected to change, a write to it is already reported as an error by writeMem.
+ * @param instruction - Cache entry to fill in
+ * @param memory - The 8080 memory
+ * @param pc - Address of the instruction
+ */
+void decodeInstruction(PredecodedInstruction *instruction, const uint8_t *memory, uint16_t pc)
+{
+    uint8_t opcode = memory[pc];
+
+    // Unused operand bytes read as 0xff, as they do in the reference engine
+    uint8_t lowOperand = (instructionSizes[opcode] >= 2) ? memory[pc+1] : 0xff;
+    uint8_t highOperand = (instructionSizes[opcode] >= 3) ? memory[pc+2] : 0xff;
+
+    instruction->opcode = opcode;
+    instruction->operand = ((uint16_t)highOperand<<8) | lowOperand;
+    instruction->destination = (opcode>>3) & 0x07;
+    instruction->source = opcode & 0x07;
+    instruction->handler = opcodeHandlers[opcode];
+    instruction->fastHandler = NULL;
+    instruction->liveFlags = ALL_FLAGS;
+    instruction->fastDistance = 0;
+    instruction->fastLength = 1;
+}
+
+/**
+ * Gives an instruction a handler skipping its dead flags, if the zero and carry flags are
+ * the only flags it writes that are live, and there is a limit to how long they stay stale.
+ * While fastDistance more instructions are sure to run, the last of them will have been overwritten.
+ * @param instruction - A decoded instruction
+ * @param analyzed - What the ROM analysis found out about the instruction's address
+ */
+void setDeadFlagHandler(PredecodedInstruction *instruction, const RomInstruction *analyzed)
+{
+    uint8_t liveFlags = analyzed->flagsWritten & analyzed->liveFlagsOut;
+    if(!(analyzed->isCode) || analyzed->killDistance == 0 || (liveFlags & ~(FLAG_ZERO | FLAG_CARRY)) != 0){
+        return;
+    }
+
+    if(instruction->handler == handleAluRegister){
+        instruction->fastHandler = handleAluRegisterLiveFlags;
+    }else if(instruction->handler == handleAluMemory){
+        instruction->fastHandler = handleAluMemoryLiveFlags;
+    }else if(instruction->handler == handleAluImmediate){
+        instruction->fastHandler = handleAluImmediateLiveFlags;
+    }else if(instruction->handler == handleIncrement){
+        instruction->fastHandler = handleIncrementLiveFlags;
+    }else if(instruction->handler == handleDecrement){
+        instruction->fastHandler = handleDecrementLiveFlags;
+    }else{
+        return;
+    }
+    instruction->liveFlags = liveFlags;
+    instruction->fastDistance = analyzed->killDistance;
+}
+
+/**
+ * Finds the fused handler for the longest sequence of instructions that has one
+ * @param sequence - The instructions, decoded, in the order they run
+ * @param length - Number of instructions in the sequence, set to the number fused
+ * @return - The fused handler, or NULL if there is none
+ */
+InstructionHandler findFusedHandler(const PredecodedInstruction **sequence, unsigned int *length)
+{
+    InstructionHandler handlers[MAX_FUSED_LENGTH] = {NULL, NULL, NULL};
+    for(unsigned int instructionNum = 0; instructionNum < *length; instructionNum++){
+        handlers[instructionNum] = sequence[instructionNum]->handler;
+    }
+
+    if(handlers[0] == handleMoveFromMemory && handlers[1] == handleAluRegister && handlers[2] == handleConditionalJump){
+        *length = 3;  // e.g. MOV A,M ANA A JZ
+        return handleFusedLoadAluJump;
+    }else if(handlers[0] == handleIncrementPair && handlers[1] == handleDecrement && handlers[2] == handleConditionalJump){
+        *length = 3;  // e.g. INX H DCR B JNZ, ending a copy loop
+        return handleFusedCountdownJump;
+    }else if(*length < 2){
+        return NULL;
+    }
+
+    *length = 2;
+    if(handlers[0] == handleDecrement && handlers[1] == handleConditionalJump){
+        return handleFusedDecrementJump;
+    }else if(handlers[0] == handleAluRegister && handlers[1] == handleConditionalJump){
+        return handleFusedAluJump;
+    }else if(handlers[0] == handleAluImmediate && handlers[1] == handleConditionalJump){
+        return handleFusedAluImmediateJump;
+    }else if(handlers[0] == handleMoveFromMemory && handlers[1] == handleAluRegister){
+        return handleFusedLoadAlu;
+    }else if(handlers[0] == handleLoadPair && handlers[1] == handleMoveToMemory){
+        return handleFusedLoadPairStore;
+    }else if(handlers[0] == handleLoadPair && handlers[1] == handleMoveFromMemory){
+        return handleFusedLoadPairLoad;
+    }else if(handlers[0] == handleIncrement && handlers[1] == handleIncrementPair){
+        return handleFusedIncrementStep;
+    }
+
+    return NULL;
+}
+
+/**
+ * Runs the native routine installed at the program counter, or if not even part of it fits in what is
+ * left of the run, the instruction there
+ * @param engine - The engine, with a run end set
+ * @param instruction - The decoded instruction at the program counter
+ * @param state - The 8080 state
+ * @return - Number of ROM instructions run
+ */
+unsigned int runHookedRoutine(CpuEngine *engine, const PredecodedInstruction *instruction, State8080 *state)
+{
+    const RomHook *hook = engine->hooks[state->pc];
+    unsigned int cyclesLeft = engine->runEndCycles - state->cyclesCompleted;
+    unsigned int numExecuted = 0;
+    if(engine->verifyMemory != NULL){
+        numExecuted = verifyHookedRoutine(engine, hook, state, cyclesLeft);
+    }else{
+        numExecuted = hook->run(state, cyclesLeft);
+    }
+
+    if(numExecuted == 0){
+        instruction->handler(instruction, state);
+        numExecuted = 1;
+    }
+    return numExecuted;
+}
+
+/**
+ * Runs a native routine on a copy of the machine and the ROM code it replaces on the machine itself,
+ * for as many instructions as the native routine ran, and reports any difference. The machine is
+ * left as the ROM code left it, so emulation stays exact whatever the native routine did.
+ * @param engine - The engine
+ * @param hook - The routine
+ * @param state - The 8080 state, at the routine's address
+ * @param cyclesLeft - Cycles that may be run
+ * @return - Number of ROM instructions run, 0 if the native routine did not run
+ */
+unsigned int verifyHookedRoutine(CpuEngine *engine, const RomHook *hook, State8080 *state, unsigned int cyclesLeft)
+{
+    State8080 native = *state;
+    native.memory = engine->verifyMemory;
+    memcpy(native.memory, state->memory, MEMORY_SIZE_8080);
+    unsigned int numExecuted = hook->run(&native, cyclesLeft);
+
+    for(unsigned int instructionNum = 0; instructionNum < numExecuted; instructionNum++){
+        executeNextInstruction(state);
+    }
+
+    int memoryAddress = -1;
+    if(numExecuted > 0 && !isSameMachine(&native, state, &memoryAddress)){
+        engine->numHookMismatches++;
+        LOG(LOG_ERROR, "Native %s differs from the ROM code after %u instructions, at cycle %u\n",
+            hook->name, numExecuted, state->cyclesCompleted);
+        if(memoryAddress >= 0){
+            LOG(LOG_ERROR, "Memory at %04x: native %02x, ROM code %02x\n",
+                memoryAddress, native.memory[memoryAddress], state->memory[memoryAddress]);
+        }
+        LOG(LOG_ERROR, "Native   PC %04x SP %04x A %02x BC %02x%02x DE %02x%02x HL %02x%02x Z%u S%u P%u CY%u AC%u cycle %u\n",
+            native.pc, native.sp, native.a, native.b, native.c, native.d, native.e, native.h, native.l, native.flags.zero,
+            native.flags.sign, native.flags.parity, native.flags.carry, native.flags.auxiliaryCarry, native.cyclesCompleted);
+        LOG(LOG_ERROR, "ROM code PC %04x SP %04x A %02x BC %02x%02x DE %02x%02x HL %02x%02x Z%u S%u P%u CY%u AC%u cycle %u\n",
+            state->pc, state->sp, state->a, state->b, state->c, state->d, state->e, state->h, state->l, state->flags.zero,
+            state->flags.sign, state->flags.parity, state->flags.carry, state->flags.auxiliaryCarry, state->cyclesCompleted);
+    }
+    return numExecuted;
+}
+
+/**
+ * @param first - An 8080 state
+ * @param second - Another 8080 state
+ * @param memoryAddress - Set to the first address whose memory differs, or -1 if none does
+ * @return - Whether the registers, flags, cycle count, interrupt state and all of memory match
+ */
+bool isSameMachine(const State8080 *first, const State8080 *second, int *memoryAddress)
+{
+    *memoryAddress = -1;
+    if(memcmp(first->memory, second->memory, MEMORY_SIZE_8080) != 0){
+        for(int address = 0; address < MEMORY_SIZE_8080 && *memoryAddress < 0; address++){
+            if(first->memory[address] != second->memory[address]){
+                *memoryAddress = address;
+            }
+        }
+    }
+
+    return *memoryAddress < 0 && first->a == second->a && first->b == second->b && first->c == second->c
+           && first->d == second->d && first->e == second->e && first->h == second->h && first->l == second->l
+           && first->sp == second->sp && first->pc == second->pc && first->cyclesCompleted == second->cyclesCompleted
+           && first->interruptsEnabled == second->interruptsEnabled && first->flags.zero == second->flags.zero
+           && first->flags.sign == second->flags.sign && first->flags.parity == second->flags.parity
+           && first->flags.carry == second->flags.carry && first->flags.auxiliaryCarry == second->flags.auxiliaryCarry;
+}
+
+uint8_t *getRegister(uint8_t registerNum, State8080 *state)
+{
+    return (uint8_t*)state + registerOffsets[registerNum];
+}
+
+bool isConditionMet(uint8_t condition, const State8080 *state)
+{
+    switch(condition){
+        case CONDITION_NOT_ZERO:
+            return !(state->flags.zero);
+        case CONDITION_ZERO:
+            return state->flags.zero;
+        case CONDITION_NO_CARRY:
+            return !(state->flags.carry);
+        case CONDITION_CARRY:
+            return state->flags.carry;
+        case CONDITION_PARITY_ODD:
+            return !(state->flags.parity);
+        case CONDITION_PARITY_EVEN:
+            return state->flags.parity;
+        case CONDITION_PLUS:
+            return !(state->flags.sign);
+        default:
+            return state->flags.sign;
+    }
+}
+
+void handleFallback(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t operands[2] = {(uint8_t)(instruction->operand), (uint8_t)(instruction->operand>>8)};
+    executeInstructionByOpcode(instruction->opcode, operands, state);
+}
+
+void handleNop(const PredecodedInstruction *instruction, State8080 *state)
+{
+    NOP(state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleMoveRegister(const PredecodedInstruction *instruction, State8080 *state)
+{
+    MOV_R1_R2(getRegister(instruction->destination, state), getRegister(instruction->source, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleMoveFromMemory(const PredecodedInstruction *instruction, State8080 *state)
+{
+    MOV_R_M(getRegister(instruction->destination, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleMoveToMemory(const PredecodedInstruction *instruction, State8080 *state)
+{
+    MOV_M_R(*getRegister(instruction->source, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleMoveImmediate(const PredecodedInstruction *instruction, State8080 *state)
+{
+    MVI_R(getRegister(instruction->destination, state), (uint8_t)(instruction->operand), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleIncrement(const PredecodedInstruction *instruction, State8080 *state)
+{
+    aluIncrement(getRegister(instruction->destination, state), state);
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleDecrement(const PredecodedInstruction *instruction, State8080 *state)
+{
+    aluDecrement(getRegister(instruction->destination, state), state);
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleDecimalAdjust(const PredecodedInstruction *instruction, State8080 *state)
+{
+    aluDecimalAdjust(state);
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleAluRegister(const PredecodedInstruction *instruction, State8080 *state)
+{
+    aluOperations[instruction->destination](*getRegister(instruction->source, state), state);
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleAluMemory(const PredecodedInstruction *instruction, State8080 *state)
+{
+    aluOperations[instruction->destination](readMem(getValueHL(state), state), state);
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleAluImmediate(const PredecodedInstruction *instruction, State8080 *state)
+{
+    aluOperations[instruction->destination]((uint8_t)(instruction->operand), state);
+    state->pc += 2;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleLoadPair(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t highRegNum = instruction->destination & 0x06;
+    LXI_RP(getRegister(highRegNum, state), getRegister(highRegNum+1, state), instruction->operand, state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleIncrementPair(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t highRegNum = instruction->destination & 0x06;
+    INX_RP(getRegister(highRegNum, state), getRegister(highRegNum+1, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleDecrementPair(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t highRegNum = instruction->destination & 0x06;
+    DCX_RP(getRegister(highRegNum, state), getRegister(highRegNum+1, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleAddPair(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t highRegNum = instruction->destination & 0x06;
+    DAD_RP(*getRegister(highRegNum, state), *getRegister(highRegNum+1, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handlePush(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t highRegNum = instruction->destination & 0x06;
+    PUSH_RP(*getRegister(highRegNum, state), *getRegister(highRegNum+1, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handlePop(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t highRegNum = instruction->destination & 0x06;
+    POP_RP(getRegister(highRegNum, state), getRegister(highRegNum+1, state), state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleJump(const PredecodedInstruction *instruction, State8080 *state)
+{
+    JMP(instruction->operand, state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleConditionalJump(const PredecodedInstruction *instruction, State8080 *state)
+{
+    if(isConditionMet(instruction->destination, state)){
+        JMP(instruction->operand, state);
+        state->cyclesCompleted += instructionCycles[instruction->opcode];
+    }else{
+        state->pc += 3;
+        state->cyclesCompleted += instructionCyclesNotTaken[instruction->opcode];
+    }
+}
+
+void handleCall(const PredecodedInstruction *instruction, State8080 *state)
+{
+    CALL(instruction->operand, state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleConditionalCall(const PredecodedInstruction *instruction, State8080 *state)
+{
+    if(isConditionMet(instruction->destination, state)){
+        CALL(instruction->operand, state);
+        state->cyclesCompleted += instructionCycles[instruction->opcode];
+    }else{
+        state->pc += 3;
+        state->cyclesCompleted += instructionCyclesNotTaken[instruction->opcode];
+    }
+}
+
+void handleReturn(const PredecodedInstruction *instruction, State8080 *state)
+{
+    RET(state);
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleConditionalReturn(const PredecodedInstruction *instruction, State8080 *state)
+{
+    if(isConditionMet(instruction->destination, state)){
+        RET(state);
+        state->cyclesCompleted += instructionCycles[instruction->opcode];
+    }else{
+        state->pc += 1;
+        state->cyclesCompleted += instructionCyclesNotTaken[instruction->opcode];
+    }
+}
+
+void handleRestart(const PredecodedInstruction *instruction, State8080 *state)
+{
+    bool isTaken = state->interruptsEnabled;
+    RST(instruction->destination, state);
+    state->cyclesCompleted += isTaken ? instructionCycles[instruction->opcode] : instructionCyclesNotTaken[instruction->opcode];
+}
+
+/**
+ * Carries out an ALU operation, setting only the zero and carry flags, and only those in liveFlags
+ * @param instruction - The instruction
+ * @param data - The byte combined with the accumulator
+ * @param state - The 8080 state
+ */
+void computeAluLiveFlags(const PredecodedInstruction *instruction, uint8_t data, State8080 *state)
+{
+    uint8_t operation = instruction->destination;
+    uint8_t result = aluOperationResult(operation, data, state);
+    if(instruction->liveFlags & FLAG_CARRY){
+        state->flags.carry = aluOperationCarry(operation, data, state);
+    }
+    if(instruction->liveFlags & FLAG_ZERO){
+        state->flags.zero = (result == 0);
+    }
+    if(operation != ALU_CMP){
+        state->a = result;
+    }
+}
+
+void handleAluRegisterLiveFlags(const PredecodedInstruction *instruction, State8080 *state)
+{
+    computeAluLiveFlags(instruction, *getRegister(instruction->source, state), state);
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleAluMemoryLiveFlags(const PredecodedInstruction *instruction, State8080 *state)
+{
+    computeAluLiveFlags(instruction, readMem(getValueHL(state), state), state);
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleAluImmediateLiveFlags(const PredecodedInstruction *instruction, State8080 *state)
+{
+    computeAluLiveFlags(instruction, (uint8_t)(instruction->operand), state);
+    state->pc += 2;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleIncrementLiveFlags(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t *reg = getRegister(instruction->destination, state);
+    *reg += 1;
+    if(instruction->liveFlags & FLAG_ZERO){
+        state->flags.zero = (*reg == 0);
+    }
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+void handleDecrementLiveFlags(const PredecodedInstruction *instruction, State8080 *state)
+{
+    uint8_t *reg = getRegister(instruction->destination, state);
+    *reg -= 1;
+    if(instruction->liveFlags & FLAG_ZERO){
+        state->flags.zero = (*reg == 0);
+    }
+    state->pc += 1;
+    state->cyclesCompleted += instructionCycles[instruction->opcode];
+}
+
+/**
+ * Marks a decoded instruction as the start of a routine with a native version, which stepCpuEngine runs
+ * instead of calling this. Called as a handler, it runs the instruction itself.
+ */
+void handleHookedRoutine(const PredecodedInstruction *instruction, State8080 *state)
+{
+    instruction->handler(instruction, state);
+}
+
+/*
+ * Fused handlers. Each runs a sequence of instructions by calling their handlers in turn, so the
+ * results are those of running them one at a time. The instructions after the first are the
+ * entries following it in the decoded ROM, each is instructionSizes[opcode] entries on.
+ */
+
+void runAluRegister(const PredecodedInstruction *instruction, State8080 *state)
+{
+    if(instruction->liveFlags == ALL_FLAGS){
+        handleAluRegister(instruction, state);
+    }else{
+        handleAluRegisterLiveFlags(instruction, state);
+    }
+}
+
+void runDecrement(const PredecodedInstruction *instruction, State8080 *state)
+{
+    if(instruction->liveFlags == ALL_FLAGS){
+        handleDecrement(instruction, state);
+    }else{
+        handleDecrementLiveFlags(instruction, state);
+    }
+}
+
+void handleFusedLoadAluJump(const PredecodedInstruction *instruction, State8080 *state)
+{
+    const PredecodedInstruction *alu = instruction+1;
+    handleMoveFromMemory(instruction, state);
+    runAluRegister(alu, state);
+    handleConditionalJump(alu+1, state);
+}
+
+void handleFusedCountdownJump(const PredecodedInstruction *instruction, State8080 *state)
+{
+    const PredecodedInstruction *decrement = instruction+1;
+    handleIncrementPair(instruction, state);
+    runDecrement(decrement, state);
+    handleConditionalJump(decrement+1, state);
+}
+
+void handleFusedDecrementJump(const PredecodedInstruction *instruction, State8080 *state)
+{
+    runDecrement(instruction, state);
+    handleConditionalJump(instruction+1, state);
+}
+
+void handleFusedAluJump(const PredecodedInstruction *instruction, State8080 *state)
+{
+    runAluRegister(instruction, state);
+    handleConditionalJump(instruction+1, state);
+}
+
+void handleFusedAluImmediateJump(const PredecodedInstruction *instruction, State8080 *state)
+{
+    if(instruction->liveFlags == ALL_FLAGS){
+        handleAluImmediate(instruction, state);
+    }else{
+        handleAluImmediateLiveFlags(instruction, state);
+    }
+    handleConditionalJump(instruction+2, state);
+}
+
+void handleFusedLoadAlu(const PredecodedInstruction *instruction, State8080 *state)
+{
+    handleMoveFromMemory(instruction, state);
+    runAluRegister(instruction+1, state);
+}
+
+void handleFusedLoadPairStore(const PredecodedInstruction *instruction, State8080 *state)
+{
+    handleLoadPair(instruction, state);
+    handleMoveToMemory(instruction+3, state);
+}
+
+void handleFusedLoadPairLoad(const PredecodedInstruction *instruction, State8080 *state)
+{
+    handleLoadPair(instruction, state);
+    handleMoveFromMemory(instruction+3, state);
+}
+
+void handleFusedIncrementStep(const PredecodedInstruction *instruction, State8080 *state)
+{
+    if(instruction->liveFlags == ALL_FLAGS){
+        handleIncrement(instruction, state);
+    }else{
+        handleIncrementLiveFlags(instruction, state);
+    }
+    handleIncrementPair(instruction+1, state);
+}
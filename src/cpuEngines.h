@@ -0,0 +1,185 @@
+/***********************************************************************************
+ *
+ * Header for the interchangeable 8080 execution engines.
+ *
+ * The reference engine is the switch interpreter in shell8080.c, which fetches and
+ * decodes every instruction as it is executed. The predecoded engine decodes each
+ * ROM instruction once, the first time it is reached, into a handler and its
+ * operands, and afterwards dispatches straight to the handler. Instructions outside
+ * of ROM, and those without a dedicated handler, fall back to the reference engine,
+ * so both engines must produce bit-identical CPU states (see src/engineDiff.c).
+ *
+ * Once prepareCpuEngine has analyzed the ROM (see romAnalysis.h), ALU, INR and DCR
+ * instructions whose zero and carry flags are the only ones read afterwards are decoded
+ * with a second handler that skips computing the others, parity included. It is only run
+ * when the engine knows it will not be stopped before those flags are overwritten, so the
+ * flags are exact again whenever the CPU is observed between runs, e.g. by interrupts.
+ *
+ * Frequent short sequences, such as DCR then JNZ ending a loop, can also be fused into one
+ * handler running the whole sequence in a single step (see fuseInstructions). Which ones are
+ * fused is left to a hotness profile (see hotnessProfile.h). A fused handler is only run when
+ * the run is known to last long enough for the whole sequence, as an interrupt could have been
+ * taken partway through it otherwise.
+ *
+ * Hot ROM routines can be replaced by native ones (see romHooks.h), looked up once per address
+ * when hooks are installed and marked in the decoded entry, so no other instruction pays for them.
+ * In verify mode each native run is checked against the ROM code run on a copy of the machine.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_CPUENGINES_H
+#define INTEL_8080_EMULATOR_CPUENGINES_H
+
+#include "shell8080.h"
+#include "romAnalysis.h"
+#include "romHooks.h"
+
+#define NUM_CPU_ENGINES 2
+// Register numbers, as encoded in 8080 opcodes
+#define REGISTER_B 0
+#define REGISTER_C 1
+#define REGISTER_D 2
+#define REGISTER_E 3
+#define REGISTER_H 4
+#define REGISTER_L 5
+#define REGISTER_M 6  // Memory at (H)(L)
+#define REGISTER_A 7
+
+enum CpuEngineType {ReferenceEngine, PredecodedEngine};
+
+struct PredecodedInstruction;
+typedef void (*InstructionHandler)(const struct PredecodedInstruction *instruction, State8080 *state);
+
+/**
+ * An instruction decoded ahead of execution
+ */
+typedef struct PredecodedInstruction{
+    InstructionHandler handler;  /**< NULL until the instruction is first decoded */
+    InstructionHandler fastHandler;  /**< Handler only computing liveFlags, or running a fused sequence, or NULL */
+    uint16_t operand;  /**< Immediate data or address, already in host order */
+    uint8_t opcode;
+    uint8_t destination;  /**< Destination register number, or condition number for conditional branches */
+    uint8_t source;  /**< Source register number */
+    uint8_t liveFlags;  /**< Flags the fast handler computes, the others are overwritten before being read */
+    uint8_t fastDistance;  /**< Instructions after this one that must run before the run ends for fastHandler to be used */
+    uint8_t fastLength;  /**< Instructions fastHandler runs */
+} PredecodedInstruction;
+
+typedef struct CpuEngine{
+    enum CpuEngineType type;
+    PredecodedInstruction *decoded;  /**< One entry per ROM address, NULL for the reference engine */
+    RomAnalysis *analysis;  /**< Flags live at each ROM instruction, NULL until prepareCpuEngine */
+    unsigned int runEndCycles;  /**< Cycle count the current run stops at, if runEndKnown */
+    bool runEndKnown;
+    const RomHook **hooks;  /**< Native routine by ROM address, NULL unless hooks are installed */
+    uint8_t *verifyMemory;  /**< Copy of memory the ROM code is checked on in verify mode, otherwise NULL */
+    uint64_t numHookMismatches;  /**< Native routine runs that verify mode found to differ from the ROM code */
+} CpuEngine;
+
+/**
+ * Creates an execution engine
+ * @param type - The kind of engine
+ * @return - pointer to the engine
+ */
+CpuEngine *initializeCpuEngine(enum CpuEngineType type);
+
+/**
+ * Frees an execution engine
+ * @param engine - The engine
+ */
+void destroyCpuEngine(CpuEngine *engine);
+
+/**
+ * Analyzes the ROM, so that instructions are decoded with handlers skipping the flags they set
+ * that are never read. Does nothing for engines that do not decode ahead.
+ * @param engine - The engine, before it has run any instructions
+ * @param memory - Memory of a CPU the engine will run, only ROM is read
+ */
+void prepareCpuEngine(CpuEngine *engine, const uint8_t *memory);
+
+/**
+ * Tells the engine that it is about to be stepped until the CPU's cycle count reaches endCycles,
+ * and will not be stopped any sooner. Until clearCpuEngineRunEnd, the CPU's flags are only exact
+ * where romAnalysis.h finds them live.
+ * @param engine - The engine
+ * @param endCycles - Cycle count at which stepping stops
+ */
+void setCpuEngineRunEnd(CpuEngine *engine, unsigned int endCycles);
+
+/**
+ * Ends a run started by setCpuEngineRunEnd, after which every instruction computes every flag
+ * @param engine - The engine
+ */
+void clearCpuEngineRunEnd(CpuEngine *engine);
+
+/**
+ * @param engine - The engine
+ * @param address - An address
+ * @return - Flags whose value can affect execution from the address, ALL_FLAGS if the engine has no analysis
+ */
+uint8_t getCpuEngineLiveFlags(const CpuEngine *engine, uint16_t address);
+
+/**
+ * Executes the instruction at the program counter, or a sequence fused with it.
+ * An engine may only be used with CPUs whose ROM is the same, as decoded ROM instructions are kept.
+ * @param engine - The engine
+ * @param state - The 8080 state
+ * @return - Number of instructions executed, only more than 1 while a run end is set
+ */
+unsigned int stepCpuEngine(CpuEngine *engine, State8080 *state);
+
+/**
+ * Decodes a ROM instruction ahead of it being reached, e.g. from a hotness profile of an earlier run.
+ * Decoding only depends on the ROM, so any address may be decoded, whether or not it is ever executed.
+ * @param engine - The engine
+ * @param memory - Memory of a CPU the engine will run, only ROM is read
+ * @param address - Address of the instruction
+ * @return int - 1 if the instruction is decoded, 0 if the engine does not decode ahead or the address is not decoded
+ */
+int predecodeAddress(CpuEngine *engine, const uint8_t *memory, uint16_t address);
+
+/**
+ * Fuses the instruction at an address with the instructions after it into one handler, if they form
+ * one of the sequences the engine has a fused handler for. Whether a sequence is run often enough to be
+ * worth fusing is left to the caller (see fuseHotInstructions).
+ * @param engine - The engine
+ * @param memory - Memory of a CPU the engine will run, only ROM is read
+ * @param address - Address of the first instruction
+ * @return - Number of instructions fused, 0 if the engine does not decode ahead or no sequence starts there
+ */
+unsigned int fuseInstructions(CpuEngine *engine, const uint8_t *memory, uint16_t address);
+
+/**
+ * Replaces the ROM routines romHooks.h has native versions of, where the ROM holds the code they replace.
+ * Installed after any fusing, which it takes precedence over. Does nothing for engines that do not decode ahead,
+ * nor in CPU_PROFILE builds, whose profiler counts every step as one instruction.
+ * @param engine - The engine
+ * @param memory - Memory of a CPU the engine will run, only ROM is read
+ * @param mode - HooksVerified to also run the ROM code on a copy of the machine and report any difference
+ * @return - Number of routines replaced
+ */
+uint32_t installCpuEngineHooks(CpuEngine *engine, const uint8_t *memory, enum RomHookMode mode);
+
+/**
+ * @param engine - The engine
+ * @param address - An address
+ * @return - Whether a native routine is installed at the address
+ */
+bool isCpuEngineHooked(const CpuEngine *engine, uint16_t address);
+
+/**
+ * @param type - The kind of engine
+ * @return - Name of the engine, as used on the command line
+ */
+const char *getCpuEngineName(enum CpuEngineType type);
+
+/**
+ * Looks up an engine by name
+ * @param name - Name of the engine
+ * @param type - Set to the kind of engine if the name is known
+ * @return int - 1 if the name is known, 0 otherwise
+ */
+int findCpuEngine(const char *name, enum CpuEngineType *type);
+
+#endif //INTEL_8080_EMULATOR_CPUENGINES_H
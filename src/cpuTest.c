@@ -0,0 +1,194 @@
+/***********************************************************************************
+ *
+ * Runs CP/M 8080 diagnostic programs, such as resources/cpudiag.bin, on the emulated CPU.
+ *
+ * Programs are loaded at 0x0100 as CP/M would. Calls to the BDOS entry point at 0x0005
+ * are trapped to print console output (functions 2 and 9), and a jump to the warm boot
+ * vector at 0x0000 ends the program. A program passes if it returns to CP/M without
+ * printing an error. The number of emulated instructions per second is reported, which
+ * makes this a pure CPU throughput benchmark as well. Short programs can be run repeatedly,
+ * from a fresh copy each time, to get a stable measurement.
+ * The core must be compiled with CPU_DIAG defined, so programs may run and write outside of ROM.
+ *
+ * Usage: cpu_test PROGRAM... [--repeat N] [--max-instructions N]
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "shell8080.h"
+#include "helpers.h"
+#include <time.h>
+
+#define CPM_LOAD_ADDRESS 0x0100
+#define BDOS_ADDRESS 0x0005
+#define WARM_BOOT_ADDRESS 0x0000
+#define BDOS_PRINT_CHAR 2
+#define BDOS_PRINT_STRING 9
+#define CONSOLE_BUFFER_SIZE 4096
+#define DEFAULT_MAX_INSTRUCTIONS 100000000000ULL  // Longest exercisers run for a few billion instructions
+
+/**
+ * Console output captured from a diagnostic program
+ */
+typedef struct ConsoleOutput{
+    char text[CONSOLE_BUFFER_SIZE];
+    size_t length;
+} ConsoleOutput;
+
+int runDiagnostic(const char *programPath, unsigned int numRepeats, uint64_t maxInstructions);
+void handleBDOSCall(State8080 *cpu, ConsoleOutput *console, bool echo);
+void writeConsole(ConsoleOutput *console, char character, bool echo);
+
+int main(int argc, char **argv)
+{
+    uint64_t maxInstructions = DEFAULT_MAX_INSTRUCTIONS;
+    unsigned int numRepeats = 1;
+    const char *programPaths[argc];
+    int numPrograms = 0;
+    int numFailures = 0;
+
+    for(int argNum = 1; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--max-instructions") == 0 && argNum+1 < argc){
+            argNum++;
+            maxInstructions = strtoull(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--repeat") == 0 && argNum+1 < argc){
+            argNum++;
+            numRepeats = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else{
+            programPaths[numPrograms] = argv[argNum];
+            numPrograms++;
+        }
+    }
+
+    if(numPrograms == 0){
+        logger("Usage: %s PROGRAM... [--repeat N] [--max-instructions N]\n", argv[0]);
+        return 1;
+    }
+
+    for(int programNum = 0; programNum < numPrograms; programNum++){
+        if(runDiagnostic(programPaths[programNum], numRepeats, maxInstructions) == 0){
+            numFailures++;
+        }
+    }
+
+    logger("%d of %d diagnostic programs passed\n", numPrograms-numFailures, numPrograms);
+    return (numFailures == 0) ? 0 : 1;
+}
+
+/**
+ * Loads a diagnostic program and runs it until it returns to CP/M
+ * @param programPath - Path of the program binary
+ * @param numRepeats - Number of times to run the program, each from a freshly loaded copy
+ * @param maxInstructions - Instructions after which a run is assumed to be stuck
+ * @return int - 1 if every run passed, 0 otherwise
+ */
+int runDiagnostic(const char *programPath, unsigned int numRepeats, uint64_t maxInstructions)
+{
+    FILE *programFile = fopen(programPath, "rb");
+    if(programFile == NULL){
+        logger("FAIL %s: cannot open file\n", programPath);
+        return 0;
+    }
+    uint8_t *program = getRomBuffer(programFile);
+    fseek(programFile, 0, SEEK_END);
+    long programSize = ftell(programFile);
+    fclose(programFile);
+    if(program == NULL || programSize > MEMORY_SIZE_8080-CPM_LOAD_ADDRESS){
+        logger("FAIL %s: cannot load program\n", programPath);
+        free(program);
+        return 0;
+    }
+
+    // Memory below the program stays empty, BDOS calls never reach it
+    uint8_t *emptyRom = mallocSet(ROM_LIMIT_8080);
+    State8080 *cpu = initializeCPU(emptyRom);
+    free(emptyRom);
+    cpu->memory[BDOS_ADDRESS] = 0xc9;  // RET, executed after each trapped BDOS call
+
+    ConsoleOutput *console = mallocSet(sizeof(ConsoleOutput));
+    int passed = 1;
+    uint64_t numInstructions = 0;
+    uint64_t totalCycles = 0;
+    clock_t startTime = clock();
+    for(unsigned int repeatNum = 0; repeatNum < numRepeats && passed; repeatNum++){
+        // Programs modify themselves and their data, so each run starts from a fresh copy
+        memcpy(&(cpu->memory[CPM_LOAD_ADDRESS]), program, programSize);
+        cpu->pc = CPM_LOAD_ADDRESS;
+        cpu->sp = 0;
+        console->length = 0;
+        memset(console->text, 0, CONSOLE_BUFFER_SIZE);
+
+        uint64_t runInstructions = 0;
+        while(cpu->pc != WARM_BOOT_ADDRESS && runInstructions < maxInstructions){
+            if(cpu->pc == BDOS_ADDRESS){
+                handleBDOSCall(cpu, console, repeatNum == 0);
+            }
+            executeNextInstruction(cpu);
+            runInstructions++;
+
+            // The cycle counter is only 32 bits wide, so it is folded into a wider total as it goes
+            if(cpu->cyclesCompleted >= 0x80000000u){
+                totalCycles += cpu->cyclesCompleted;
+                cpu->cyclesCompleted = 0;
+            }
+        }
+        numInstructions += runInstructions;
+
+        if(repeatNum == 0 && console->length > 0 && console->text[console->length-1] != '\n'){
+            logger("\n");
+        }
+        if(cpu->pc != WARM_BOOT_ADDRESS){
+            logger("Program did not return to CP/M, stopped at PC 0x%04x\n", cpu->pc);
+            passed = 0;
+        }else if(strstr(console->text, "FAIL") != NULL || strstr(console->text, "ERROR") != NULL){
+            passed = 0;
+        }
+    }
+    totalCycles += cpu->cyclesCompleted;
+    double seconds = (double)(clock()-startTime)/CLOCKS_PER_SEC;
+
+    logger("%s %s: %llu instructions, %llu cycles", passed ? "PASS" : "FAIL", programPath,
+           (unsigned long long)numInstructions, (unsigned long long)totalCycles);
+    if(seconds > 0){
+        logger(", %.1f million instructions per second (%.1f MHz)",
+               numInstructions/seconds/1e6, totalCycles/seconds/1e6);
+    }
+    logger("\n");
+
+    free(program);
+    free(console);
+    destroyCPU(cpu);
+    return passed;
+}
+
+/**
+ * Performs the console functions of a BDOS call, the RET at the entry point then returns to the program
+ * Output is only echoed if echo is set, so that repeated runs print once.
+ */
+void handleBDOSCall(State8080 *cpu, ConsoleOutput *console, bool echo)
+{
+    if(cpu->c == BDOS_PRINT_CHAR){
+        writeConsole(console, (char)(cpu->e), echo);
+    }else if(cpu->c == BDOS_PRINT_STRING){
+        // String at DE, terminated by '$'
+        uint16_t address = ((uint16_t)(cpu->d)<<8) | cpu->e;
+        for(unsigned int charNum = 0; charNum < MEMORY_SIZE_8080 && cpu->memory[address] != '$'; charNum++){
+            writeConsole(console, (char)(cpu->memory[address]), echo);
+            address++;
+        }
+    }
+}
+
+/**
+ * Echoes a character of program output and keeps it for checking once the program ends
+ */
+void writeConsole(ConsoleOutput *console, char character, bool echo)
+{
+    if(echo){
+        logger("%c", character);
+    }
+    if(console->length < CONSOLE_BUFFER_SIZE-1){
+        console->text[console->length] = character;
+        console->length++;
+    }
+}
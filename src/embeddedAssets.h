@@ -0,0 +1,37 @@
+/***********************************************************************************
+ *
+ * Header for the ROM and sound data compiled into the emulator.
+ *
+ * The matching source file, embeddedAssets.c, is generated at build time by assetPacker.c
+ * from the contents of the resources folder. Sounds are stored pre-decoded in the audio
+ * engine's format, so no file I/O or conversion is needed at startup.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_EMBEDDEDASSETS_H
+#define INTEL_8080_EMULATOR_EMBEDDEDASSETS_H
+
+#include "cpuStructures.h"
+
+/**
+ * A sound decoded to mono, signed 16-bit samples at AUDIO_SAMPLE_RATE
+ */
+typedef struct EmbeddedSound{
+    const char *name;  /**< Name of the source WAV file, without extension */
+    const int16_t *samples;
+    uint32_t numSamples;
+} EmbeddedSound;
+
+extern const uint8_t embeddedInvadersRom[ROM_LIMIT_8080];
+extern const EmbeddedSound embeddedSounds[];
+extern const unsigned int numEmbeddedSounds;
+
+/**
+ * Finds an embedded sound by name
+ * @param name - Name of the source WAV file, without extension
+ * @return - pointer to the sound, or NULL if no sound has that name
+ */
+const EmbeddedSound *getEmbeddedSound(const char *name);
+
+#endif //INTEL_8080_EMULATOR_EMBEDDEDASSETS_H
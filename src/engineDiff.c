@@ -0,0 +1,337 @@
+/***********************************************************************************
+ *
+ * Lockstep differential test between CPU engines.
+ *
+ * Runs the reference engine and a candidate engine side by side, each in its own headless
+ * arcade with the same ROM and the same input, one instruction at a time. Every few
+ * instructions the two machines are compared: registers, flags, cycle count, interrupt
+ * state, I/O ports and all 8 KB of RAM, and at the end of every frame all 64 KB of memory.
+ * At the first difference both states are printed along with the instructions that led
+ * up to it, disassembled, and the test fails. Between interrupts the candidate may leave
+ * flags nobody reads uncomputed (see cpuEngines.h), so only the live flags are compared
+ * after an instruction; at interrupts every flag must match. A candidate running a fused sequence
+ * of instructions in one step (see fuseInstructions), or a native routine in place of ROM code (see
+ * romHooks.h), is compared once the whole step has run.
+ *
+ * Usage: engine_diff [--engine NAME] [--movie FILE] [--frames N] [--every N] [--symbols FILE] [--resources DIR] [--hotness FILE]
+ *                    [--hooks MODE]
+ * --engine NAME   Candidate engine (default "predecoded")
+ * --movie FILE    Take input from a movie, otherwise the attract mode is run with no input
+ * --frames N      Frames to run (default the length of the movie, or 3600)
+ * --every N       Instructions between comparisons (default 1), 0 to compare once per frame only
+ * --symbols FILE  Symbol map to label the instructions shown with, e.g. resources/invaders.sym
+ * --hotness FILE  Hotness profile the candidate is warm started and fuses sequences from, left unchanged
+ * --hooks MODE    Native routines for the candidate to run in place of ROM routines, "on" or "verify" (default "off")
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "arcadeEnvironment.h"
+#include "movie.h"
+#include "symbolMap.h"
+#include "hotnessProfile.h"
+
+#define DEFAULT_DIFF_FRAMES 3600
+#define DIFF_HISTORY_LENGTH 16  // Instructions shown leading up to a divergence
+#define RAM_END_ADDRESS 0x4000  // The cabinet has 8 KB of RAM after ROM, the rest of memory is only compared at frame ends
+
+/**
+ * The two arcades being run in lockstep
+ */
+typedef struct DiffSession{
+    ArcadeState *reference;
+    ArcadeState *candidate;
+    uint64_t checkInterval;  /**< Instructions between comparisons, 0 for frame ends only */
+    uint64_t numInstructions;
+    uint64_t numComparisons;
+    uint32_t frame;  /**< Frame being run, counting from 1 */
+    uint16_t history[DIFF_HISTORY_LENGTH];  /**< Addresses of the last instructions run, oldest first once wrapped */
+    const SymbolMap *symbols;  /**< NULL if no symbol file was given */
+    bool diverged;
+} DiffSession;
+
+void runLockstepCycles(DiffSession *session, unsigned int numCyclesToRun);
+void runLockstepFrame(DiffSession *session);
+void compareArcades(DiffSession *session, bool wholeMemory, uint8_t flagsCompared, const char *where);
+void printDivergence(DiffSession *session, const char *where, int memoryAddress);
+void printCpuState(const char *name, const ArcadeState *arcade);
+void destroyDiffArcade(ArcadeState *arcade);
+
+int main(int argc, char **argv)
+{
+    ArcadeConfig config;
+    setHeadlessArcadeConfig(&config);
+    enum CpuEngineType candidateEngine = PredecodedEngine;
+    uint32_t numFrames = 0;
+    uint64_t checkInterval = 1;
+    const char *symbolPath = NULL;
+    const char *hotnessPath = NULL;
+    enum RomHookMode hookMode = HooksOff;
+
+    for(int argNum = 1; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--engine") == 0 && argNum+1 < argc){
+            argNum++;
+            if(findCpuEngine(argv[argNum], &candidateEngine) == 0){
+                logger("Unknown CPU engine: %s\n", argv[argNum]);
+                return 1;
+            }
+        }else if(strcmp(argv[argNum], "--movie") == 0 && argNum+1 < argc){
+            argNum++;
+            config.playPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--frames") == 0 && argNum+1 < argc){
+            argNum++;
+            numFrames = (uint32_t)strtoul(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--every") == 0 && argNum+1 < argc){
+            argNum++;
+            checkInterval = strtoull(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--symbols") == 0 && argNum+1 < argc){
+            argNum++;
+            symbolPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--resources") == 0 && argNum+1 < argc){
+            argNum++;
+            config.resourcePath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--hotness") == 0 && argNum+1 < argc){
+            argNum++;
+            hotnessPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--hooks") == 0 && argNum+1 < argc){
+            argNum++;
+            if(findRomHookMode(argv[argNum], &hookMode) == 0){
+                logger("Unknown hook mode: %s\n", argv[argNum]);
+                return 1;
+            }
+        }else{
+            logger("Usage: %s [--engine NAME] [--movie FILE] [--frames N] [--every N] [--symbols FILE] [--resources DIR] [--hotness FILE] [--hooks MODE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    DiffSession session;
+    memset(&session, 0, sizeof(DiffSession));
+    session.checkInterval = checkInterval;
+    SymbolMap *symbols = NULL;
+    if(symbolPath != NULL){
+        symbols = loadSymbolMap(symbolPath);
+        if(symbols == NULL){
+            return 1;
+        }
+    }
+    session.symbols = symbols;
+    config.engine = ReferenceEngine;
+    session.reference = initializeArcade(&config);
+    config.engine = candidateEngine;
+    config.hotnessPath = hotnessPath;
+    config.hookMode = hookMode;
+    session.candidate = initializeArcade(&config);
+    if(session.reference == NULL || session.candidate == NULL){
+        logger("Arcades could not be set up\n");
+        destroyDiffArcade(session.reference);
+        destroyDiffArcade(session.candidate);
+        destroySymbolMap(symbols);
+        return 1;
+    }
+
+    if(numFrames == 0){
+        numFrames = (session.reference->moviePlayer != NULL) ?
+                    session.reference->moviePlayer->numFrames : DEFAULT_DIFF_FRAMES;
+    }
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(session.frame = 1; session.frame <= numFrames && !(session.diverged); session.frame++){
+        resetPortsIO(session.reference);
+        resetPortsIO(session.candidate);
+        if(session.reference->moviePlayer != NULL){
+            if(playMovieFrame(session.reference->moviePlayer, session.reference) == 0 ||
+               playMovieFrame(session.candidate->moviePlayer, session.candidate) == 0){
+                logger("Movie ended at frame %u\n", session.frame);
+                break;
+            }
+        }
+        runLockstepFrame(&session);
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter()-startTicks)/(double)SDL_GetPerformanceFrequency();
+
+    int exitCode = 0;
+    if(session.diverged){
+        exitCode = 1;
+    }else{
+        printf("PASS %s matches %s: %u frames, %llu instructions, %llu comparisons",
+               getCpuEngineName(candidateEngine), getCpuEngineName(ReferenceEngine), session.frame-1,
+               (unsigned long long)session.numInstructions, (unsigned long long)session.numComparisons);
+        if(seconds > 0){
+            printf(", %.1f million instructions per second", session.numInstructions/seconds/1e6);
+        }
+        printf("\n");
+    }
+
+    destroyDiffArcade(session.reference);
+    destroyDiffArcade(session.candidate);
+    destroySymbolMap(symbols);
+    return exitCode;
+}
+
+/**
+ * Runs both arcades for a number of the reference CPU's cycles, one instruction at a time.
+ * The reference is stepped through as many instructions as the candidate ran, so a difference in
+ * cycle counts is caught by the comparison rather than throwing the two out of step.
+ * @param session - The arcades being compared
+ * @param numCyclesToRun - Cycles of the reference CPU to run for
+ */
+void runLockstepCycles(DiffSession *session, unsigned int numCyclesToRun)
+{
+    ArcadeState *reference = session->reference;
+    ArcadeState *candidate = session->candidate;
+    unsigned int startingCycles = reference->cpu->cyclesCompleted;
+    setCpuEngineRunEnd(candidate->engine, candidate->cpu->cyclesCompleted+numCyclesToRun);
+
+    while((reference->cpu->cyclesCompleted - startingCycles) < numCyclesToRun && !(session->diverged)){
+        updateShiftRegister(candidate);
+        unsigned int numExecuted = stepCpuEngine(candidate->engine, candidate->cpu);
+        bool isCheckDue = false;
+        for(unsigned int instructionNum = 0; instructionNum < numExecuted; instructionNum++){
+            session->history[session->numInstructions % DIFF_HISTORY_LENGTH] = reference->cpu->pc;
+            updateShiftRegister(reference);
+            stepCpuEngine(reference->engine, reference->cpu);
+            session->numInstructions++;
+            isCheckDue = isCheckDue || (session->checkInterval > 0 && session->numInstructions % session->checkInterval == 0);
+        }
+
+        if(isCheckDue){
+            uint8_t liveFlags = getCpuEngineLiveFlags(candidate->engine, candidate->cpu->pc);
+            compareArcades(session, false, liveFlags, "instruction");
+        }
+    }
+    clearCpuEngineRunEnd(candidate->engine);
+}
+
+/**
+ * Runs both arcades for a frame, as runFrame does, comparing them after each interrupt
+ */
+void runLockstepFrame(DiffSession *session)
+{
+    updateShiftRegister(session->reference);
+    updateShiftRegister(session->candidate);
+
+    unsigned int numCyclesFirstHalf = CYCLES_PER_FRAME*((float)MIDSCREEN_INTERRUPT_LINE/(float)SCREEN_WIDTH_PIXELS);
+    runLockstepCycles(session, numCyclesFirstHalf);
+    generateInterrupt(0x01, session->reference->cpu);
+    generateInterrupt(0x01, session->candidate->cpu);
+    compareArcades(session, false, ALL_FLAGS, "mid-screen interrupt");
+
+    unsigned int numCyclesSecondHalf = CYCLES_PER_FRAME-numCyclesFirstHalf;
+    runLockstepCycles(session, numCyclesSecondHalf);
+    generateInterrupt(0x02, session->reference->cpu);
+    generateInterrupt(0x02, session->candidate->cpu);
+    compareArcades(session, true, ALL_FLAGS, "end of frame");
+}
+
+/**
+ * Compares the two arcades and reports the first divergence
+ * @param session - The arcades being compared
+ * @param wholeMemory - Compare all of memory rather than just RAM
+ * @param flagsCompared - Flags that must match, as romAnalysis.h masks
+ * @param where - Point in the frame the comparison is made at, for the report
+ */
+void compareArcades(DiffSession *session, bool wholeMemory, uint8_t flagsCompared, const char *where)
+{
+    if(session->diverged){
+        return;
+    }
+    session->numComparisons++;
+
+    const ArcadeState *reference = session->reference;
+    const ArcadeState *candidate = session->candidate;
+    const State8080 *refCpu = reference->cpu;
+    const State8080 *candCpu = candidate->cpu;
+    bool registersMatch =
+        refCpu->a == candCpu->a && refCpu->b == candCpu->b && refCpu->c == candCpu->c &&
+        refCpu->d == candCpu->d && refCpu->e == candCpu->e && refCpu->h == candCpu->h &&
+        refCpu->l == candCpu->l && refCpu->sp == candCpu->sp && refCpu->pc == candCpu->pc &&
+        ((*(const uint8_t*)&(refCpu->flags) ^ *(const uint8_t*)&(candCpu->flags)) & flagsCompared) == 0 &&
+        refCpu->cyclesCompleted == candCpu->cyclesCompleted &&
+        refCpu->interruptsEnabled == candCpu->interruptsEnabled &&
+        reference->shiftRegister == candidate->shiftRegister;
+    bool portsMatch =
+        memcmp(refCpu->inputBuffers, candCpu->inputBuffers, NUM_INPUT_DEVICES) == 0 &&
+        memcmp(refCpu->outputBuffers, candCpu->outputBuffers, NUM_OUTPUT_DEVICES) == 0;
+
+    unsigned int firstAddress = wholeMemory ? 0 : ROM_LIMIT_8080;
+    unsigned int endAddress = wholeMemory ? MEMORY_SIZE_8080 : RAM_END_ADDRESS;
+    int memoryAddress = -1;
+    if(memcmp(&(refCpu->memory[firstAddress]), &(candCpu->memory[firstAddress]), endAddress-firstAddress) != 0){
+        for(unsigned int address = firstAddress; address < endAddress; address++){
+            if(refCpu->memory[address] != candCpu->memory[address]){
+                memoryAddress = (int)address;
+                break;
+            }
+        }
+    }
+
+    if(!registersMatch || !portsMatch || memoryAddress >= 0){
+        session->diverged = true;
+        printDivergence(session, where, memoryAddress);
+    }
+}
+
+void printDivergence(DiffSession *session, const char *where, int memoryAddress)
+{
+    const State8080 *refCpu = session->reference->cpu;
+    const State8080 *candCpu = session->candidate->cpu;
+
+    printf("FAIL %s diverges from %s in frame %u, at %s after instruction %llu\n",
+           getCpuEngineName(session->candidate->engine->type), getCpuEngineName(ReferenceEngine),
+           session->frame, where, (unsigned long long)session->numInstructions);
+    printCpuState("reference", session->reference);
+    printCpuState("candidate", session->candidate);
+    if(memoryAddress >= 0){
+        printf("first memory difference at 0x%04x: reference 0x%02x, candidate 0x%02x\n",
+               memoryAddress, refCpu->memory[memoryAddress], candCpu->memory[memoryAddress]);
+    }
+    for(unsigned int portNum = 0; portNum < NUM_OUTPUT_DEVICES; portNum++){
+        if(refCpu->inputBuffers[portNum] != candCpu->inputBuffers[portNum]){
+            printf("input port %u: reference 0x%02x, candidate 0x%02x\n",
+                   portNum, refCpu->inputBuffers[portNum], candCpu->inputBuffers[portNum]);
+        }
+        if(refCpu->outputBuffers[portNum] != candCpu->outputBuffers[portNum]){
+            printf("output port %u: reference 0x%02x, candidate 0x%02x\n",
+                   portNum, refCpu->outputBuffers[portNum], candCpu->outputBuffers[portNum]);
+        }
+    }
+
+    // Both engines ran the same instructions up to here, the last one is where they parted
+    printf("last instructions run:\n");
+    uint64_t numShown = (session->numInstructions < DIFF_HISTORY_LENGTH) ? session->numInstructions : DIFF_HISTORY_LENGTH;
+    for(uint64_t instructionNum = session->numInstructions-numShown; instructionNum < session->numInstructions; instructionNum++){
+        char text[32];
+        char label[SYMBOL_NAME_LENGTH+8];
+        uint16_t address = session->history[instructionNum % DIFF_HISTORY_LENGTH];
+        disassembleInstruction(refCpu, address, text, sizeof(text));
+        if(session->symbols != NULL){
+            formatSymbolAddress(session->symbols, address, label, sizeof(label));
+            printf("  %04x  %-24s  %s\n", address, label, text);
+        }else{
+            printf("  %04x  %s\n", address, text);
+        }
+    }
+}
+
+void printCpuState(const char *name, const ArcadeState *arcade)
+{
+    const State8080 *cpu = arcade->cpu;
+    printf("%-9s  A %02x B %02x C %02x D %02x E %02x H %02x L %02x SP %04x PC %04x  "
+           "z%u s%u p%u cy%u ac%u  IE %u  cycles %u  shift %04x\n",
+           name, cpu->a, cpu->b, cpu->c, cpu->d, cpu->e, cpu->h, cpu->l, cpu->sp, cpu->pc,
+           cpu->flags.zero, cpu->flags.sign, cpu->flags.parity, cpu->flags.carry, cpu->flags.auxiliaryCarry,
+           cpu->interruptsEnabled, cpu->cyclesCompleted, arcade->shiftRegister);
+}
+
+void destroyDiffArcade(ArcadeState *arcade)
+{
+    if(arcade == NULL){
+        return;
+    }
+
+    // A profile given with --hotness is only read from, the lockstep run records nothing into it
+    destroyHotnessProfile(arcade->hotness);
+    arcade->hotness = NULL;
+    destroyArcade(arcade);
+}
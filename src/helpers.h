@@ -12,10 +12,48 @@
 #include "../src/cpuStructures.h"
 
 /**
- Immediately prints content to console.
+ * Importance of a log message, messages below logLevel are dropped
+ */
+typedef enum LogLevel{
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARNING,
+    LOG_ERROR,
+    LOG_NONE  /**< Only for logLevel, turns off all messages */
+} LogLevel;
+
+/**
+ * Receives log messages at or above logLevel instead of them being printed immediately,
+ * see logWriter.h
+ */
+typedef void (*LogSink)(LogLevel level, const char *format, va_list argList);
+
+extern LogLevel logLevel;  /**< Messages below this level are dropped, LOG_INFO by default */
+extern LogSink logSink;  /**< NULL to print messages immediately */
+
+/**
+ * Logs a message at a level. The arguments are only evaluated if the level is enabled,
+ * so disabled messages cost a single comparison.
+ * Usage: LOG(LOG_WARNING, "Address 0x%04x\n", address);
+ */
+#define LOG(level, ...) do{ if((level) >= logLevel){ logMessage((level), __VA_ARGS__); } }while(0)
+
+/**
+ Logs a message at a level, printing it immediately unless a log sink is installed.
+ Same call signature as printf() after the level.
+ LOG() should be preferred, it skips evaluating the arguments of disabled messages.
+
+ @param level - importance of the message
+ @param format - print format specifier
+ @param ... - variable quantity of arguments to be printed
+ */
+void logMessage(LogLevel level, const char *format, ...);
+
+/**
+ Logs a message at LOG_INFO.
  Same call signature as printf().
 
- Achieves this by calling vprintf & fflush(stdout)
+ Without a log sink, achieves this by calling vprintf & fflush(stdout)
 
  @param format - print format specifier
  @param ... - variable quantity of arguments to be printed
@@ -39,4 +77,33 @@ uint8_t twosComplement(uint8_t num);
  */
 void *mallocSet(size_t size);
 
+/**
+ * Computes a CRC-32 (the polynomial used by zip and MAME ROM sets).
+ * Can be computed in pieces by passing the result of the previous piece as crc.
+ *
+ * @param crc - 0 for the first piece, otherwise the CRC of the data preceding this piece
+ * @param data - bytes to checksum
+ * @param size - number of bytes
+ * @return - CRC-32 of all pieces so far
+ */
+uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size);
+
+/**
+ * Stores a value least significant byte first, the byte order of every file format written by the emulator.
+ *
+ * @param data - where to store the value
+ * @param value - value to store, only its low numBytes bytes are kept
+ * @param numBytes - number of bytes to store, at most 4
+ */
+void writeLittleEndian(uint8_t *data, uint32_t value, unsigned int numBytes);
+
+/**
+ * Reads a value stored least significant byte first.
+ *
+ * @param data - where the value is stored
+ * @param numBytes - number of bytes to read, at most 4
+ * @return - the value read
+ */
+uint32_t readLittleEndian(const uint8_t *data, unsigned int numBytes);
+
 #endif  // HELPERS_H_
\ No newline at end of file
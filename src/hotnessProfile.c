@@ -0,0 +1,219 @@
+/***********************************************************************************
+ *
+ * Source for ROM hotness profiles
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "hotnessProfile.h"
+#include "helpers.h"
+#include "opcodeSpec.h"
+
+/**
+ * An executed address, for ordering addresses by hotness
+ */
+typedef struct HotAddress{
+    uint16_t address;
+    uint64_t executions;
+} HotAddress;
+
+int readHotnessEntries(HotnessProfile *profile, FILE *file, const char *path);
+bool isConditionalBranch(uint8_t opcode);
+int compareHotAddresses(const void *first, const void *second);
+
+HotnessProfile *loadHotnessProfile(const char *path, const uint8_t *rom)
+{
+    HotnessProfile *profile = mallocSet(sizeof(HotnessProfile));
+    profile->romChecksum = crc32(0, rom, ROM_LIMIT_8080);
+    if(path == NULL){
+        return profile;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if(file == NULL){
+        return profile;  // First run, nothing recorded yet
+    }
+    if(readHotnessEntries(profile, file, path) == 0){
+        memset(profile->counts, 0, sizeof(profile->counts));
+    }
+    fclose(file);
+
+    return profile;
+}
+
+int saveHotnessProfile(const HotnessProfile *profile, const char *path)
+{
+    uint32_t numEntries = 0;
+    uint64_t largestCount = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(profile->counts[address].executions > 0){
+            numEntries++;
+        }
+        // Block entries and branches are never counted more often than executions
+        if(profile->counts[address].executions > largestCount){
+            largestCount = profile->counts[address].executions;
+        }
+    }
+    unsigned int scaleShift = 0;
+    while((largestCount>>scaleShift) > UINT32_MAX){
+        scaleShift++;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if(file == NULL){
+        LOG(LOG_ERROR, "Failed to create hotness profile %s\n", path);
+        return 0;
+    }
+    uint8_t header[HOTNESS_HEADER_SIZE];
+    memcpy(header, HOTNESS_MAGIC, 8);
+    writeLittleEndian(&(header[8]), HOTNESS_VERSION, 4);
+    writeLittleEndian(&(header[12]), profile->romChecksum, 4);
+    writeLittleEndian(&(header[16]), numEntries, 4);
+    int successfulWrite = fwrite(header, 1, HOTNESS_HEADER_SIZE, file) == HOTNESS_HEADER_SIZE;
+
+    for(uint32_t address = 0; address < ROM_LIMIT_8080 && successfulWrite; address++){
+        if(profile->counts[address].executions == 0){
+            continue;
+        }
+        uint8_t entry[HOTNESS_ENTRY_SIZE];
+        writeLittleEndian(&(entry[0]), address, 2);
+        writeLittleEndian(&(entry[2]), (uint32_t)(profile->counts[address].executions>>scaleShift), 4);
+        writeLittleEndian(&(entry[6]), (uint32_t)(profile->counts[address].blockEntries>>scaleShift), 4);
+        writeLittleEndian(&(entry[10]), (uint32_t)(profile->counts[address].branchesTaken>>scaleShift), 4);
+        writeLittleEndian(&(entry[14]), (uint32_t)(profile->counts[address].branchesNotTaken>>scaleShift), 4);
+        successfulWrite = fwrite(entry, 1, HOTNESS_ENTRY_SIZE, file) == HOTNESS_ENTRY_SIZE;
+    }
+
+    if(fclose(file) != 0 || !successfulWrite){
+        LOG(LOG_ERROR, "Failed to write hotness profile %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+void destroyHotnessProfile(HotnessProfile *profile)
+{
+    free(profile);
+}
+
+void recordHotness(HotnessProfile *profile, uint16_t pc, const State8080 *state)
+{
+    if(pc >= ROM_LIMIT_8080){
+        profile->nextPc = 0;
+        return;
+    }
+
+    HotnessCounts *counts = &(profile->counts[pc]);
+    uint8_t opcode = state->memory[pc];
+    uint16_t fallthroughPc = (uint16_t)(pc+instructionSizes[opcode]);
+    counts->executions++;
+    counts->blockEntries += (pc != profile->nextPc);
+    if(isConditionalBranch(opcode)){
+        counts->branchesTaken += (state->pc != fallthroughPc);
+        counts->branchesNotTaken += (state->pc == fallthroughPc);
+    }
+    profile->nextPc = fallthroughPc;
+}
+
+uint32_t warmStartCpuEngine(const HotnessProfile *profile, CpuEngine *engine, const uint8_t *memory)
+{
+    HotAddress *hotAddresses = mallocSet(ROM_LIMIT_8080*sizeof(HotAddress));
+    uint32_t numHotAddresses = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(profile->counts[address].executions > 0){
+            hotAddresses[numHotAddresses].address = (uint16_t)address;
+            hotAddresses[numHotAddresses].executions = profile->counts[address].executions;
+            numHotAddresses++;
+        }
+    }
+    qsort(hotAddresses, numHotAddresses, sizeof(HotAddress), compareHotAddresses);
+
+    uint32_t numDecoded = 0;
+    for(uint32_t hotNum = 0; hotNum < numHotAddresses; hotNum++){
+        numDecoded += (uint32_t)predecodeAddress(engine, memory, hotAddresses[hotNum].address);
+    }
+
+    free(hotAddresses);
+    return numDecoded;
+}
+
+uint32_t fuseHotInstructions(const HotnessProfile *profile, CpuEngine *engine, const uint8_t *memory)
+{
+    uint64_t totalExecutions = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        totalExecutions += profile->counts[address].executions;
+    }
+
+    uint32_t numFused = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080 && totalExecutions > 0; address++){
+        if(profile->counts[address].executions*HOT_FUSE_SHARE < totalExecutions){
+            continue;
+        }
+        // Every instruction of a sequence runs on into the next, so none is run less often than the first
+        numFused += (fuseInstructions(engine, memory, (uint16_t)address) > 0);
+    }
+
+    return numFused;
+}
+
+/**
+ * Adds the entries of a profile file to a profile
+ * @param profile - The profile, with the checksum of the ROM being profiled
+ * @param file - The open profile file
+ * @param path - Path of the file, for messages
+ * @return int - 1 if every entry was read, 0 if the file is damaged or from another ROM
+ */
+int readHotnessEntries(HotnessProfile *profile, FILE *file, const char *path)
+{
+    uint8_t header[HOTNESS_HEADER_SIZE];
+    if(fread(header, 1, HOTNESS_HEADER_SIZE, file) != HOTNESS_HEADER_SIZE
+       || memcmp(header, HOTNESS_MAGIC, 8) != 0 || readLittleEndian(&(header[8]), 4) != HOTNESS_VERSION){
+        LOG(LOG_WARNING, "%s is not a version %d hotness profile, starting a new one\n", path, HOTNESS_VERSION);
+        return 0;
+    }
+    if(readLittleEndian(&(header[12]), 4) != profile->romChecksum){
+        LOG(LOG_WARNING, "Hotness profile %s was recorded on another ROM, starting a new one\n", path);
+        return 0;
+    }
+
+    uint32_t numEntries = readLittleEndian(&(header[16]), 4);
+    for(uint32_t entryNum = 0; entryNum < numEntries; entryNum++){
+        uint8_t entry[HOTNESS_ENTRY_SIZE];
+        uint16_t address = 0;
+        if(fread(entry, 1, HOTNESS_ENTRY_SIZE, file) != HOTNESS_ENTRY_SIZE
+           || (address = (uint16_t)readLittleEndian(&(entry[0]), 2)) >= ROM_LIMIT_8080){
+            LOG(LOG_WARNING, "Hotness profile %s is damaged, starting a new one\n", path);
+            return 0;
+        }
+        profile->counts[address].executions += readLittleEndian(&(entry[2]), 4);
+        profile->counts[address].blockEntries += readLittleEndian(&(entry[6]), 4);
+        profile->counts[address].branchesTaken += readLittleEndian(&(entry[10]), 4);
+        profile->counts[address].branchesNotTaken += readLittleEndian(&(entry[14]), 4);
+    }
+
+    return 1;
+}
+
+/**
+ * @param opcode - An 8080 opcode
+ * @return - Whether the opcode is a conditional jump, call or return
+ */
+bool isConditionalBranch(uint8_t opcode)
+{
+    uint8_t operation = opcode & 0xc7;
+    return operation == 0xc0 || operation == 0xc2 || operation == 0xc4;
+}
+
+/**
+ * Orders addresses from most to least executed
+ */
+int compareHotAddresses(const void *first, const void *second)
+{
+    uint64_t firstExecutions = ((const HotAddress *)first)->executions;
+    uint64_t secondExecutions = ((const HotAddress *)second)->executions;
+    if(firstExecutions != secondExecutions){
+        return (firstExecutions > secondExecutions) ? -1 : 1;
+    }
+    return (int)((const HotAddress *)first)->address-(int)((const HotAddress *)second)->address;
+}
+
@@ -0,0 +1,100 @@
+/***********************************************************************************
+ *
+ * Header for ROM hotness profiles.
+ *
+ * A hotness profile counts, for every ROM address, how many times an instruction there
+ * was executed, how many times a basic block was entered there (reached other than by
+ * running on from the previous instruction), and for conditional branches, how many
+ * times the branch was taken and not taken. A profile saved at exit is loaded again on
+ * the next start, so engines can prepare the hot ROM paths before they are first run,
+ * and the counts keep adding up over sessions.
+ *
+ * File layout, little-endian:
+ * - Header: "8080HOTP", then the version, the CRC-32 of the ROM the profile was
+ *   recorded on and the number of entries, 4 bytes each
+ * - Entries, one per executed address, in address order: the address (2), then the
+ *   executions, block entries, branches taken and branches not taken (4 each)
+ * Counts too large for 4 bytes are all halved together until they fit.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_HOTNESSPROFILE_H
+#define INTEL_8080_EMULATOR_HOTNESSPROFILE_H
+
+#include "cpuStructures.h"
+#include "cpuEngines.h"
+
+#define HOTNESS_MAGIC "8080HOTP"
+#define HOTNESS_VERSION 1
+#define HOTNESS_HEADER_SIZE 20
+#define HOTNESS_ENTRY_SIZE 18
+#define HOT_FUSE_SHARE 4096  // Sequences run for less than this fraction of instructions are not fused
+
+/**
+ * Counts for one ROM address, kept together so recording an instruction touches one cache line
+ */
+typedef struct HotnessCounts{
+    uint64_t executions;
+    uint64_t blockEntries;  /**< Times a basic block started here */
+    uint64_t branchesTaken;
+    uint64_t branchesNotTaken;
+} HotnessCounts;
+
+typedef struct HotnessProfile{
+    HotnessCounts counts[ROM_LIMIT_8080];
+    uint32_t romChecksum;  /**< CRC-32 of the ROM being profiled */
+    uint16_t nextPc;  /**< Where the last instruction recorded runs on to, if it does not branch */
+} HotnessProfile;
+
+/**
+ * Creates an empty profile, or loads one saved earlier for the same ROM
+ * @param path - Profile file to load, or NULL; a missing file is not an error
+ * @param rom - The ROM being profiled, ROM_LIMIT_8080 bytes
+ * @return - pointer to the profile; empty if the file is missing, damaged, or from another ROM
+ */
+HotnessProfile *loadHotnessProfile(const char *path, const uint8_t *rom);
+
+/**
+ * Saves a profile, with the counts of any profile it was loaded from included
+ * @param profile - The profile
+ * @param path - File to save to
+ * @return int - 1 on success, 0 if the file could not be written
+ */
+int saveHotnessProfile(const HotnessProfile *profile, const char *path);
+
+/**
+ * Frees a profile
+ * @param profile - The profile, may be NULL
+ */
+void destroyHotnessProfile(HotnessProfile *profile);
+
+/**
+ * Counts an instruction that was just executed
+ * @param profile - The profile
+ * @param pc - Address the instruction was executed at
+ * @param state - The 8080 state after executing it
+ */
+void recordHotness(HotnessProfile *profile, uint16_t pc, const State8080 *state);
+
+/**
+ * Decodes every ROM instruction the profile saw executed, hottest first, so that an engine
+ * runs them at full speed from the first frame
+ * @param profile - The profile
+ * @param engine - The engine, engines that do not decode ahead are left untouched
+ * @param memory - Memory of a CPU the engine will run
+ * @return - Number of instructions decoded
+ */
+uint32_t warmStartCpuEngine(const HotnessProfile *profile, CpuEngine *engine, const uint8_t *memory);
+
+/**
+ * Fuses the instruction sequences the profile saw run often enough into single handlers, those
+ * starting at an address that ran at least 1/HOT_FUSE_SHARE of every instruction the profile counted
+ * @param profile - The profile
+ * @param engine - The engine, engines that do not decode ahead are left untouched
+ * @param memory - Memory of a CPU the engine will run
+ * @return - Number of sequences fused
+ */
+uint32_t fuseHotInstructions(const HotnessProfile *profile, CpuEngine *engine, const uint8_t *memory);
+
+#endif //INTEL_8080_EMULATOR_HOTNESSPROFILE_H
@@ -0,0 +1,489 @@
+/***********************************************************************************
+ *
+ * Source for binary instruction traces
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "instructionTrace.h"
+#include "helpers.h"
+#include "opcodeSpec.h"
+
+void fillTraceRecord(TraceRecord *record, const State8080 *cpu);
+void addTraceRecord(InstructionTracer *tracer, const TraceRecord *record);
+void submitTraceChunk(InstructionTracer *tracer);
+int runTraceWriter(void *data);
+uint16_t getPredictedPC(const TraceRecord *previous);
+const uint8_t *takeTraceBytes(TraceReader *reader, uint32_t numBytes);
+int readTraceChunk(TraceReader *reader);
+
+InstructionTracer *initializeInstructionTracer(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if(file == NULL){
+        logger("Failed to create trace file %s\n", path);
+        return NULL;
+    }
+    uint8_t header[TRACE_HEADER_SIZE];
+    memcpy(header, TRACE_MAGIC, 8);
+    writeLittleEndian(&(header[8]), TRACE_VERSION, 4);
+    writeLittleEndian(&(header[12]), TRACE_CHUNK_SIZE, 4);
+    if(fwrite(header, 1, TRACE_HEADER_SIZE, file) != TRACE_HEADER_SIZE){
+        logger("Failed to write trace file %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    InstructionTracer *tracer = mallocSet(sizeof(InstructionTracer));
+    tracer->file = file;
+    for(unsigned int chunkNum = 0; chunkNum < TRACE_NUM_CHUNKS; chunkNum++){
+        tracer->chunks[chunkNum] = mallocSet(TRACE_CHUNK_SIZE);
+    }
+    tracer->needKeyframe = true;
+    tracer->lock = SDL_CreateMutex();
+    tracer->chunkChanged = SDL_CreateCond();
+    tracer->writer = SDL_CreateThread(runTraceWriter, "TraceWriter", tracer);
+    if(tracer->lock == NULL || tracer->chunkChanged == NULL || tracer->writer == NULL){
+        logger("Failed to start the trace writer: %s\n", SDL_GetError());
+        if(tracer->writer != NULL){
+            SDL_LockMutex(tracer->lock);
+            tracer->stopping = true;
+            SDL_CondSignal(tracer->chunkChanged);
+            SDL_UnlockMutex(tracer->lock);
+            SDL_WaitThread(tracer->writer, NULL);
+            tracer->writer = NULL;
+        }
+        tracer->file = NULL;
+        fclose(file);
+        destroyInstructionTracer(tracer);
+        return NULL;
+    }
+
+    return tracer;
+}
+
+void traceInstruction(InstructionTracer *tracer, const State8080 *cpu)
+{
+    TraceRecord record;
+    fillTraceRecord(&record, cpu);
+    record.interrupt = false;
+    record.interruptNum = 0;
+    uint8_t opcode = cpu->memory[cpu->pc];
+    record.instructionSize = (instructionSizes[opcode] > 0) ? (uint8_t)instructionSizes[opcode] : 1;
+    for(uint8_t byteNum = 0; byteNum < record.instructionSize; byteNum++){
+        record.instruction[byteNum] = cpu->memory[(uint16_t)(cpu->pc+byteNum)];
+    }
+
+    addTraceRecord(tracer, &record);
+}
+
+void traceInterrupt(InstructionTracer *tracer, const State8080 *cpu, uint8_t interruptNum)
+{
+    if(!(cpu->interruptsEnabled)){
+        return;
+    }
+
+    TraceRecord record;
+    fillTraceRecord(&record, cpu);
+    record.interrupt = true;
+    record.interruptNum = interruptNum;
+    record.instructionSize = 0;
+
+    addTraceRecord(tracer, &record);
+}
+
+void destroyInstructionTracer(InstructionTracer *tracer)
+{
+    if(tracer == NULL){
+        return;
+    }
+
+    if(tracer->writer != NULL){
+        if(tracer->chunkSizes[tracer->fillingChunk] > 0){
+            submitTraceChunk(tracer);
+        }
+        SDL_LockMutex(tracer->lock);
+        tracer->stopping = true;
+        SDL_CondSignal(tracer->chunkChanged);
+        SDL_UnlockMutex(tracer->lock);
+        SDL_WaitThread(tracer->writer, NULL);
+
+        if(tracer->failed || fclose(tracer->file) != 0){
+            logger("Failed to finish trace file!\n");
+        }else{
+            logger("Traced %llu records in %llu bytes (%.2f bytes per record)\n",
+                   (unsigned long long)tracer->numRecords, (unsigned long long)tracer->numBytes,
+                   (tracer->numRecords > 0) ? (double)tracer->numBytes/(double)tracer->numRecords : 0.0);
+        }
+    }
+
+    for(unsigned int chunkNum = 0; chunkNum < TRACE_NUM_CHUNKS; chunkNum++){
+        free(tracer->chunks[chunkNum]);
+    }
+    if(tracer->chunkChanged != NULL){
+        SDL_DestroyCond(tracer->chunkChanged);
+    }
+    if(tracer->lock != NULL){
+        SDL_DestroyMutex(tracer->lock);
+    }
+    free(tracer);
+}
+
+TraceReader *initializeTraceReader(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if(file == NULL){
+        logger("Failed to open trace file %s\n", path);
+        return NULL;
+    }
+
+    uint8_t header[TRACE_HEADER_SIZE];
+    if(fread(header, 1, TRACE_HEADER_SIZE, file) != TRACE_HEADER_SIZE || memcmp(header, TRACE_MAGIC, 8) != 0){
+        logger("%s is not a trace file\n", path);
+        fclose(file);
+        return NULL;
+    }
+    if(readLittleEndian(&(header[8]), 4) != TRACE_VERSION){
+        logger("Trace file %s is version %u, only version %d is supported\n",
+               path, readLittleEndian(&(header[8]), 4), TRACE_VERSION);
+        fclose(file);
+        return NULL;
+    }
+
+    TraceReader *reader = mallocSet(sizeof(TraceReader));
+    reader->file = file;
+    reader->maxChunkSize = readLittleEndian(&(header[12]), 4);
+    reader->chunk = mallocSet(reader->maxChunkSize);
+
+    return reader;
+}
+
+int readTraceRecord(TraceReader *reader, TraceRecord *record)
+{
+    if(reader->position == reader->chunkSize && readTraceChunk(reader) == 0){
+        return 0;
+    }
+
+    const uint8_t *bytes = takeTraceBytes(reader, 1);
+    if(bytes == NULL){
+        return 0;
+    }
+    uint8_t recordType = bytes[0];
+    TraceRecord *previous = &(reader->previous);
+    if(recordType & TRACE_KEYFRAME){
+        if((bytes = takeTraceBytes(reader, 2+TRACE_NUM_REGISTERS+2+4+1)) == NULL){
+            return 0;
+        }
+        record->pc = (uint16_t)readLittleEndian(bytes, 2);
+        memcpy(record->registers, &(bytes[2]), TRACE_NUM_REGISTERS);
+        record->sp = (uint16_t)readLittleEndian(&(bytes[2+TRACE_NUM_REGISTERS]), 2);
+        record->cycles = readLittleEndian(&(bytes[2+TRACE_NUM_REGISTERS+2]), 4);
+        record->interruptsEnabled = bytes[2+TRACE_NUM_REGISTERS+2+4];
+    }else{
+        if(reader->position == 1){
+            logger("Trace chunk does not start with a keyframe\n");
+            return 0;
+        }
+
+        record->pc = getPredictedPC(previous);
+        if(recordType & TRACE_PC_DELTA){
+            if((bytes = takeTraceBytes(reader, 1)) == NULL){
+                return 0;
+            }
+            record->pc += (int8_t)bytes[0];
+        }else if(recordType & TRACE_PC_ABSOLUTE){
+            if((bytes = takeTraceBytes(reader, 2)) == NULL){
+                return 0;
+            }
+            record->pc = (uint16_t)readLittleEndian(bytes, 2);
+        }
+
+        if(recordType & TRACE_CYCLES_ABSOLUTE){
+            if((bytes = takeTraceBytes(reader, 4)) == NULL){
+                return 0;
+            }
+            record->cycles = readLittleEndian(bytes, 4);
+        }else{
+            if((bytes = takeTraceBytes(reader, 1)) == NULL){
+                return 0;
+            }
+            record->cycles = previous->cycles+bytes[0];
+        }
+
+        memcpy(record->registers, previous->registers, TRACE_NUM_REGISTERS);
+        if(recordType & TRACE_REGISTERS){
+            if((bytes = takeTraceBytes(reader, 1)) == NULL){
+                return 0;
+            }
+            uint8_t changedRegisters = bytes[0];
+            for(unsigned int registerNum = 0; registerNum < TRACE_NUM_REGISTERS; registerNum++){
+                if(changedRegisters & (1<<registerNum)){
+                    if((bytes = takeTraceBytes(reader, 1)) == NULL){
+                        return 0;
+                    }
+                    record->registers[registerNum] = bytes[0];
+                }
+            }
+        }
+
+        record->sp = previous->sp;
+        if(recordType & TRACE_STACK_POINTER){
+            if((bytes = takeTraceBytes(reader, 2)) == NULL){
+                return 0;
+            }
+            record->sp = (uint16_t)readLittleEndian(bytes, 2);
+        }
+
+        record->interruptsEnabled = previous->interruptsEnabled;
+        if(recordType & TRACE_INTERRUPT_ENABLE){
+            record->interruptsEnabled = !(previous->interruptsEnabled);
+        }
+    }
+
+    record->interrupt = (recordType & TRACE_INTERRUPT) != 0;
+    if(record->interrupt){
+        if((bytes = takeTraceBytes(reader, 1)) == NULL){
+            return 0;
+        }
+        record->interruptNum = bytes[0];
+        record->instructionSize = 0;
+    }else{
+        if((bytes = takeTraceBytes(reader, 1)) == NULL){
+            return 0;
+        }
+        record->instruction[0] = bytes[0];
+        record->instructionSize = (instructionSizes[bytes[0]] > 0) ? (uint8_t)instructionSizes[bytes[0]] : 1;
+        if(record->instructionSize > 1){
+            if((bytes = takeTraceBytes(reader, record->instructionSize-1)) == NULL){
+                return 0;
+            }
+            memcpy(&(record->instruction[1]), bytes, record->instructionSize-1);
+        }
+    }
+
+    *previous = *record;
+    return 1;
+}
+
+void destroyTraceReader(TraceReader *reader)
+{
+    if(reader == NULL){
+        return;
+    }
+
+    fclose(reader->file);
+    free(reader->chunk);
+    free(reader);
+}
+
+/**
+ * Fills in the parts of a record common to instructions and interrupts
+ */
+void fillTraceRecord(TraceRecord *record, const State8080 *cpu)
+{
+    record->pc = cpu->pc;
+    record->registers[0] = cpu->a;
+    record->registers[1] = cpu->b;
+    record->registers[2] = cpu->c;
+    record->registers[3] = cpu->d;
+    record->registers[4] = cpu->e;
+    record->registers[5] = cpu->h;
+    record->registers[6] = cpu->l;
+    memcpy(&(record->registers[7]), &(cpu->flags), 1);
+    record->sp = cpu->sp;
+    record->cycles = cpu->cyclesCompleted;
+    record->interruptsEnabled = cpu->interruptsEnabled;
+}
+
+/**
+ * Encodes a record into the chunk being filled, against the previous record
+ * @param tracer - The tracer
+ * @param record - The record
+ */
+void addTraceRecord(InstructionTracer *tracer, const TraceRecord *record)
+{
+    uint8_t *start = &(tracer->chunks[tracer->fillingChunk][tracer->chunkSizes[tracer->fillingChunk]]);
+    uint8_t *next = start+1;
+    const TraceRecord *previous = &(tracer->previous);
+    uint8_t recordType = 0;
+
+    if(tracer->needKeyframe){
+        recordType |= TRACE_KEYFRAME;
+        writeLittleEndian(next, record->pc, 2);
+        memcpy(&(next[2]), record->registers, TRACE_NUM_REGISTERS);
+        writeLittleEndian(&(next[2+TRACE_NUM_REGISTERS]), record->sp, 2);
+        writeLittleEndian(&(next[2+TRACE_NUM_REGISTERS+2]), record->cycles, 4);
+        next[2+TRACE_NUM_REGISTERS+2+4] = record->interruptsEnabled;
+        next += 2+TRACE_NUM_REGISTERS+2+4+1;
+        tracer->needKeyframe = false;
+    }else{
+        // The PC only needs storing after a jump, call or return
+        int pcDelta = (int)record->pc-(int)getPredictedPC(previous);
+        if(pcDelta >= -128 && pcDelta <= 127 && pcDelta != 0){
+            recordType |= TRACE_PC_DELTA;
+            *(next++) = (uint8_t)(int8_t)pcDelta;
+        }else if(pcDelta != 0){
+            recordType |= TRACE_PC_ABSOLUTE;
+            writeLittleEndian(next, record->pc, 2);
+            next += 2;
+        }
+
+        uint32_t cycleDelta = record->cycles-previous->cycles;
+        if(cycleDelta <= 0xff){
+            *(next++) = (uint8_t)cycleDelta;
+        }else{
+            recordType |= TRACE_CYCLES_ABSOLUTE;
+            writeLittleEndian(next, record->cycles, 4);
+            next += 4;
+        }
+
+        uint8_t changedRegisters = 0;
+        uint8_t *changedRegistersByte = next;
+        for(unsigned int registerNum = 0; registerNum < TRACE_NUM_REGISTERS; registerNum++){
+            if(record->registers[registerNum] != previous->registers[registerNum]){
+                if(changedRegisters == 0){
+                    next++;  // Leave room for the changed registers
+                }
+                changedRegisters |= (1<<registerNum);
+                *(next++) = record->registers[registerNum];
+            }
+        }
+        if(changedRegisters != 0){
+            recordType |= TRACE_REGISTERS;
+            *changedRegistersByte = changedRegisters;
+        }
+
+        if(record->sp != previous->sp){
+            recordType |= TRACE_STACK_POINTER;
+            writeLittleEndian(next, record->sp, 2);
+            next += 2;
+        }
+
+        if(record->interruptsEnabled != previous->interruptsEnabled){
+            recordType |= TRACE_INTERRUPT_ENABLE;
+        }
+    }
+
+    if(record->interrupt){
+        recordType |= TRACE_INTERRUPT;
+        *(next++) = record->interruptNum;
+    }else{
+        memcpy(next, record->instruction, record->instructionSize);
+        next += record->instructionSize;
+    }
+
+    *start = recordType;
+    tracer->chunkSizes[tracer->fillingChunk] += (uint32_t)(next-start);
+    tracer->previous = *record;
+    tracer->numRecords++;
+    if(tracer->chunkSizes[tracer->fillingChunk] > TRACE_CHUNK_SIZE-TRACE_MAX_RECORD_SIZE){
+        submitTraceChunk(tracer);
+    }
+}
+
+/**
+ * Hands the chunk being filled to the writer thread, and moves on to the next chunk once it has been written
+ * @param tracer - The tracer
+ */
+void submitTraceChunk(InstructionTracer *tracer)
+{
+    SDL_LockMutex(tracer->lock);
+    tracer->numFullChunks++;
+    SDL_CondSignal(tracer->chunkChanged);
+    // The emulator waits for the writer rather than losing records
+    while(tracer->numFullChunks == TRACE_NUM_CHUNKS){
+        SDL_CondWait(tracer->chunkChanged, tracer->lock);
+    }
+    SDL_UnlockMutex(tracer->lock);
+
+    tracer->fillingChunk = (tracer->fillingChunk+1) % TRACE_NUM_CHUNKS;
+    tracer->chunkSizes[tracer->fillingChunk] = 0;
+    tracer->needKeyframe = true;
+}
+
+/**
+ * Writes full chunks to the trace file until the tracer is stopped
+ * @param data - The tracer
+ * @return int - 0 once every chunk has been written
+ */
+int runTraceWriter(void *data)
+{
+    InstructionTracer *tracer = (InstructionTracer *)data;
+
+    while(true){
+        SDL_LockMutex(tracer->lock);
+        while(tracer->numFullChunks == 0 && !(tracer->stopping)){
+            SDL_CondWait(tracer->chunkChanged, tracer->lock);
+        }
+        if(tracer->numFullChunks == 0){
+            SDL_UnlockMutex(tracer->lock);
+            break;
+        }
+        SDL_UnlockMutex(tracer->lock);
+
+        // The emulator never touches a full chunk, so it is written without holding the lock
+        uint32_t chunkSize = tracer->chunkSizes[tracer->writingChunk];
+        uint8_t sizeBytes[4];
+        writeLittleEndian(sizeBytes, chunkSize, 4);
+        if(!(tracer->failed) && (fwrite(sizeBytes, 1, 4, tracer->file) != 4 ||
+                                 fwrite(tracer->chunks[tracer->writingChunk], 1, chunkSize, tracer->file) != chunkSize)){
+            tracer->failed = true;
+        }
+        tracer->numBytes += 4+chunkSize;
+        tracer->writingChunk = (tracer->writingChunk+1) % TRACE_NUM_CHUNKS;
+
+        SDL_LockMutex(tracer->lock);
+        tracer->numFullChunks--;
+        SDL_CondSignal(tracer->chunkChanged);
+        SDL_UnlockMutex(tracer->lock);
+    }
+
+    return 0;
+}
+
+/**
+ * @param previous - The previous record
+ * @return - Where the next record is expected to be: after the previous instruction, or at an interrupt's handler
+ */
+uint16_t getPredictedPC(const TraceRecord *previous)
+{
+    if(previous->interrupt){
+        return (uint16_t)(previous->interruptNum*8);
+    }
+    return (uint16_t)(previous->pc+previous->instructionSize);
+}
+
+/**
+ * @return - The next bytes of the chunk being read, or NULL if the chunk ends first
+ */
+const uint8_t *takeTraceBytes(TraceReader *reader, uint32_t numBytes)
+{
+    if(reader->chunkSize-reader->position < numBytes){
+        logger("Trace record runs past the end of its chunk\n");
+        return NULL;
+    }
+    const uint8_t *bytes = &(reader->chunk[reader->position]);
+    reader->position += numBytes;
+    return bytes;
+}
+
+/**
+ * Reads the next chunk of a trace
+ * @return int - 1 if a chunk was read, 0 at the end of the trace or if the chunk is damaged
+ */
+int readTraceChunk(TraceReader *reader)
+{
+    uint8_t sizeBytes[4];
+    if(fread(sizeBytes, 1, 4, reader->file) != 4){
+        return 0;
+    }
+    uint32_t chunkSize = readLittleEndian(sizeBytes, 4);
+    if(chunkSize == 0 || chunkSize > reader->maxChunkSize || fread(reader->chunk, 1, chunkSize, reader->file) != chunkSize){
+        logger("Trace file is damaged\n");
+        return 0;
+    }
+
+    reader->chunkSize = chunkSize;
+    reader->position = 0;
+    return 1;
+}
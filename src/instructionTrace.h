@@ -0,0 +1,150 @@
+/***********************************************************************************
+ *
+ * Header for binary instruction traces.
+ *
+ * A trace holds a record of the CPU state before every instruction and interrupt, in a
+ * compact binary form: the PC is stored only when it is not simply the end of the previous
+ * instruction, and registers, SP and the interrupt enable only when they changed. Records
+ * are packed into chunks in memory, each starting with a keyframe record holding the
+ * whole state, and full chunks are written to the file by a background thread so that
+ * tracing costs the emulator little more than filling memory. bin/trace_decoder prints
+ * a trace back out.
+ *
+ * File layout, little-endian:
+ * - Header: "8080TRCE", then the version and the chunk size, 4 bytes each
+ * - Chunks: the size of the chunk's records in bytes, 4 bytes, then the records
+ * Each record starts with a byte of TRACE_* bits saying what follows, in this order:
+ * - Keyframe: PC (2), A, B, C, D, E, H, L, flags, SP (2), cycles (4), interrupt enable (1)
+ * - Otherwise: PC as a 1 byte delta from the end of the previous instruction or 2 bytes,
+ *   if TRACE_PC_DELTA or TRACE_PC_ABSOLUTE, then cycles since the previous record as 1 byte,
+ *   or 4 bytes of absolute cycles if TRACE_CYCLES_ABSOLUTE, then a byte of changed
+ *   registers (bits 0-7 for A, B, C, D, E, H, L, flags) and their values if
+ *   TRACE_REGISTERS, then SP (2) if TRACE_STACK_POINTER
+ * - Interrupts: the interrupt number (1)
+ * - Instructions: the opcode and its operands (1-3)
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_INSTRUCTIONTRACE_H
+#define INTEL_8080_EMULATOR_INSTRUCTIONTRACE_H
+
+#include "cpuStructures.h"
+#include "sdl_sources/SDL.h"
+
+#define TRACE_MAGIC "8080TRCE"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 16
+#define TRACE_CHUNK_SIZE 65536  // Bytes of records per chunk
+#define TRACE_NUM_CHUNKS 16  // Chunks filled or being written at once
+#define TRACE_MAX_RECORD_SIZE 24
+#define TRACE_NUM_REGISTERS 8  // A, B, C, D, E, H, L and the flags
+// Bits of a record's first byte
+#define TRACE_PC_DELTA 0x01
+#define TRACE_PC_ABSOLUTE 0x02
+#define TRACE_REGISTERS 0x04
+#define TRACE_STACK_POINTER 0x08
+#define TRACE_CYCLES_ABSOLUTE 0x10
+#define TRACE_INTERRUPT 0x20
+#define TRACE_KEYFRAME 0x40
+#define TRACE_INTERRUPT_ENABLE 0x80  // Interrupt enable toggled
+
+/**
+ * CPU state before one instruction or interrupt
+ */
+typedef struct TraceRecord{
+    bool interrupt;  /**< Interrupt rather than instruction */
+    uint8_t interruptNum;
+    uint8_t instruction[3];  /**< Opcode and operands */
+    uint8_t instructionSize;
+    uint16_t pc;
+    uint8_t registers[TRACE_NUM_REGISTERS];  /**< A, B, C, D, E, H, L, then the flags as stored in save states */
+    uint16_t sp;
+    uint32_t cycles;
+    bool interruptsEnabled;
+} TraceRecord;
+
+/**
+ * Writes a trace as the CPU runs
+ */
+typedef struct InstructionTracer{
+    FILE *file;
+    uint8_t *chunks[TRACE_NUM_CHUNKS];
+    uint32_t chunkSizes[TRACE_NUM_CHUNKS];
+    uint32_t fillingChunk;  /**< Chunk records are being added to */
+    uint32_t writingChunk;  /**< Next chunk for the writer thread to write */
+    uint32_t numFullChunks;  /**< Chunks waiting to be written, guarded by lock */
+    bool stopping;  /**< No more chunks will be filled, guarded by lock */
+    bool failed;  /**< The file could not be written, set by the writer thread */
+    SDL_mutex *lock;
+    SDL_cond *chunkChanged;  /**< Signalled whenever a chunk is full or has been written */
+    SDL_Thread *writer;
+    TraceRecord previous;  /**< Last record added, what the next one is encoded against */
+    bool needKeyframe;  /**< Next record starts a chunk */
+    uint64_t numRecords;
+    uint64_t numBytes;
+} InstructionTracer;
+
+/**
+ * Reads a trace back, record by record
+ */
+typedef struct TraceReader{
+    FILE *file;
+    uint8_t *chunk;
+    uint32_t maxChunkSize;  /**< Largest chunk the trace may hold, from its header */
+    uint32_t chunkSize;
+    uint32_t position;  /**< Offset of the next record in the chunk */
+    TraceRecord previous;
+} TraceReader;
+
+/**
+ * Starts writing a trace
+ * @param path - Path of the trace file
+ * @return - pointer to the tracer, or NULL if the file could not be created
+ */
+InstructionTracer *initializeInstructionTracer(const char *path);
+
+/**
+ * Adds the instruction at the program counter, before it is executed
+ * @param tracer - The tracer
+ * @param cpu - The 8080 state
+ */
+void traceInstruction(InstructionTracer *tracer, const State8080 *cpu);
+
+/**
+ * Adds an interrupt, before it is generated. Nothing is added if interrupts are disabled.
+ * @param tracer - The tracer
+ * @param cpu - The 8080 state
+ * @param interruptNum - The interrupt about to be generated
+ */
+void traceInterrupt(InstructionTracer *tracer, const State8080 *cpu, uint8_t interruptNum);
+
+/**
+ * Writes out the rest of a trace and frees the tracer
+ * @param tracer - The tracer, may be NULL
+ */
+void destroyInstructionTracer(InstructionTracer *tracer);
+
+/**
+ * Opens a trace for reading.
+ * The instruction tables must already be set up, by creating a CPU with initializeCPU.
+ * @param path - Path of the trace file
+ * @return - pointer to the reader, or NULL if the file is not a trace
+ */
+TraceReader *initializeTraceReader(const char *path);
+
+/**
+ * Reads the next record of a trace
+ * @param reader - The reader
+ * @param record - Set to the record
+ * @return int - 1 if a record was read, 0 at the end of the trace or if the trace is damaged
+ */
+int readTraceRecord(TraceReader *reader, TraceRecord *record);
+
+/**
+ * Closes a trace
+ * @param reader - The reader, may be NULL
+ */
+void destroyTraceReader(TraceReader *reader);
+
+#endif //INTEL_8080_EMULATOR_INSTRUCTIONTRACE_H
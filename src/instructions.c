@@ -3,8 +3,8 @@
  * Capitalized names indicate a function that implements a full 8080 instruction's functionality
  * camelCase names indicate a function that implements a portion of an instruction's effect(s)
  *
- * By convention, only fully-implemented 8080 functions (Capitalized names) will update the program counter and
- * increase the number of clock cycles completed
+ * By convention, only fully-implemented 8080 functions (Capitalized names) will update the program counter.
+ * Clock cycles are charged by whoever runs the instruction, from the opcode specification (see opcodeSpec.h)
  *
  * @author Andrew Gunter
  */
@@ -36,7 +36,6 @@ void CALL(uint16_t address, State8080 *state)
     writeMem(sp-2, pcLow, state);
     state->sp -= 2;
     state->pc = address;
-    state->cyclesCompleted += 17;
 }
 
 /**
@@ -50,7 +49,6 @@ void INX_RP(uint8_t *highReg, uint8_t *lowReg, State8080 *state)
     *highReg = (uint8_t)(concatRegValue >> 8);
     *lowReg = (uint8_t)concatRegValue;
     state->pc += 1;
-    state->cyclesCompleted += 5;
 }
 
 /**
@@ -69,7 +67,6 @@ void PUSH_RP(uint8_t highReg, uint8_t lowReg, State8080 *state)
     state->sp = sp-2;
 
     state->pc += 1;
-    state->cyclesCompleted += 11;
 }
 
 /**
@@ -87,7 +84,6 @@ void POP_RP(uint8_t *highReg, uint8_t *lowReg, State8080 *state)
     state->sp = sp+2;
 
     state->pc += 1;
-    state->cyclesCompleted += 10;
 }
 
 /**
@@ -123,7 +119,6 @@ void DAD_RP(uint8_t highReg, uint8_t lowReg, State8080 *state)
     state->l = newValueL;
 
     state->pc += 1;
-    state->cyclesCompleted += 10;
 }
 
 /**
@@ -134,7 +129,6 @@ void DAD_RP(uint8_t highReg, uint8_t lowReg, State8080 *state)
 void JMP(uint16_t address, State8080 *state)
 {
     state->pc = address;
-    state->cyclesCompleted += 10;
 }
 
 /**
@@ -148,7 +142,6 @@ void XRA_R(uint8_t data, State8080 *state)
     xorWithAccumulator(data, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 4;
 }
 
 /**
@@ -162,7 +155,6 @@ void ANA_R(uint8_t data, State8080 *state)
     andWithAccumulator(data, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 1;
 }
 
 /**
@@ -177,7 +169,7 @@ void ANA_R(uint8_t data, State8080 *state)
 void RST(uint8_t restartNumber, State8080 *state)
 {
     if(restartNumber >= 0x08){
-        logger("Warning: Invalid interrupt attempted:\n");
+        LOG(LOG_WARNING, "Warning: Invalid interrupt attempted:\n");
     }
 
     if(state->interruptsEnabled){
@@ -193,7 +185,6 @@ void RST(uint8_t restartNumber, State8080 *state)
         writeMem(sp-2, pcLow, state);
         state->sp -= 2;
         state->pc = 8 * restartNumber;
-        state->cyclesCompleted += 11;
 
         // It is expected for interrupts to be disabled until end of ISR. Interrupts will be enabled at end of ISR
         state->interruptsEnabled = 0;
@@ -216,7 +207,6 @@ void RET(State8080 *state)
     state->pc = newValuePC;
 
     state->sp += 2;
-    state->cyclesCompleted += 10;
 }
 
 /**
@@ -230,7 +220,6 @@ void ORA_R(uint8_t data, State8080 *state)
     orWithAccumulator(data, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 4;
 }
 
 /**
@@ -249,7 +238,6 @@ void DCX_RP(uint8_t *highReg, uint8_t *lowReg, State8080 *state)
     *lowReg = (uint8_t)(pairValue & 0x00ff);
 
     state->pc += 1;
-    state->cyclesCompleted += 5;
 }
 
 /**
@@ -262,7 +250,6 @@ void MOV_R1_R2(uint8_t *destReg, uint8_t *sourceReg, State8080 *state)
     *destReg = *sourceReg;
 
     state->pc += 1;
-    state->cyclesCompleted += 5;
 }
 
 /**
@@ -275,13 +262,11 @@ void MVI_R(uint8_t *destReg, uint8_t value, State8080 *state)
     *destReg = value;
 
     state->pc += 2;
-    state->cyclesCompleted += 7;
 }
 
 void NOP(State8080 *state)
 {
     state->pc += 1;
-    state->cyclesCompleted += 4;
 }
 
 /**
@@ -296,7 +281,6 @@ void INR_R(uint8_t *reg, State8080 *state)
     checkStandardArithmeticFlags(*reg, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 5;
 }
 
 /**
@@ -311,7 +295,6 @@ void DCR_R(uint8_t *reg, State8080 *state)
     checkStandardArithmeticFlags(*reg, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 5;
 }
 
 /**
@@ -324,7 +307,6 @@ void MOV_R_M(uint8_t *destReg, State8080 *state)
     moveDataFromHLMemory(destReg, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 7;
 }
 
 /**
@@ -337,7 +319,6 @@ void MOV_M_R(uint8_t data, State8080 *state)
     moveDataToHLMemory(data, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 7;
 }
 
 /**
@@ -353,7 +334,6 @@ void ADD_R(uint8_t data, State8080 *state)
     checkStandardArithmeticFlags(state->a, state);
 
     state->pc += 1;
-    state->cyclesCompleted += 4;
 }
 
 /**
@@ -381,7 +361,6 @@ void CMP_R(uint8_t data, State8080 *state)
 {
     compareWithAccumulator(data, state);
     state->pc += 1;
-    state->cyclesCompleted += 4;
 }
 
 /**
@@ -394,7 +373,6 @@ void LXI_RP(uint8_t *highReg, uint8_t *lowReg, uint16_t orderedOperands, State80
     *highReg = (uint8_t)(orderedOperands>>8);
     *lowReg = (uint8_t)orderedOperands;
     state->pc += 3;
-    state->cyclesCompleted += 10;
 }
 
 /**
@@ -407,7 +385,6 @@ void SUB_R(uint8_t data, State8080 *state)
 {
     subFromAccumulator(data, state);
     state->pc += 1;
-    state->cyclesCompleted += 4;
 }
 
 /**
@@ -427,7 +404,6 @@ void SBB_R(uint8_t data, State8080 *state)
     }
 
     state->pc += 1;
-    state->cyclesCompleted += 4;
 }
 
 uint16_t compareWithAccumulator(uint8_t subtrahend, State8080 *state)
@@ -521,13 +497,17 @@ uint16_t getValueBC(State8080 *state)
 
 void writeMem(uint16_t address, uint8_t value, State8080 *state)
 {
+    #ifndef CPU_DIAG
     if(address >= ROM_LIMIT_8080){
         state->memory[address] = value;
     }else{
         state->memory[address] = value;
-        logger("Warning: ROM Overwrite!\n");
-        logger("Address 0x%04x; Value 0x%02x\n", address, value);
+        LOG(LOG_WARNING, "Warning: ROM Overwrite!\nAddress 0x%04x; Value 0x%02x\n", address, value);
     }
+    #else
+    // Diagnostic programs keep their data and stack below ROM_LIMIT_8080
+    state->memory[address] = value;
+    #endif
 }
 
 uint8_t readMem(uint16_t address, State8080 *state)
@@ -3,8 +3,8 @@
  * Capitalized names indicate a function that implements a full 8080 instruction's functionality
  * camelCase names indicate a function that implements a portion of an instruction's effect(s)
  *
- * By convention, only fully-implemented 8080 functions (Capitalized names) will update the program counter and
- * increase the number of clock cycles completed.
+ * By convention, only fully-implemented 8080 functions (Capitalized names) will update the program counter.
+ * Clock cycles are left to the caller, and come from the opcode specification (see opcodeSpec.h).
  *
  * @author Andrew Gunter
  */
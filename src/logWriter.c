@@ -0,0 +1,230 @@
+/***********************************************************************************
+ *
+ * Source for the background log writer
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "logWriter.h"
+
+#define LOG_RING_FREE 0
+#define LOG_RING_ACTIVE 1  // Owned by a running thread
+#define LOG_RING_FINISHED 2  // Its thread has exited, free once the writer has emptied it
+
+const char *logLevelNames[] = {"debug", "info", "warning", "error", "none"};
+
+// Rings stay allocated once the writer has been started, threads may still hold them after it stops
+LogRing *logRings[LOG_MAX_THREADS];
+SDL_TLSID logRingKey = 0;  // Each thread's ring
+SDL_atomic_t logSequenceNum;
+SDL_atomic_t numDroppedWithoutRing;  // Messages from threads that found every ring taken
+SDL_atomic_t logWriterStopping;
+SDL_Thread *logWriterThread = NULL;
+bool stopRegisteredAtExit = false;
+
+void queueLogMessage(LogLevel level, const char *format, va_list argList);
+LogRing *getThreadLogRing(void);
+void releaseLogRing(void *ring);
+int runLogWriter(void *data);
+int writeQueuedLogMessages(void);
+
+int startLogWriter(LogLevel level)
+{
+    logLevel = level;
+    if(logWriterThread != NULL){
+        return 1;
+    }
+
+    if(logRingKey == 0){
+        logRingKey = SDL_TLSCreate();
+        if(logRingKey == 0){
+            logger("Failed to start the log writer: %s\n", SDL_GetError());
+            return 0;
+        }
+        for(unsigned int ringNum = 0; ringNum < LOG_MAX_THREADS; ringNum++){
+            logRings[ringNum] = mallocSet(sizeof(LogRing));
+        }
+    }
+
+    SDL_AtomicSet(&logWriterStopping, 0);
+    logWriterThread = SDL_CreateThread(runLogWriter, "LogWriter", NULL);
+    if(logWriterThread == NULL){
+        logger("Failed to start the log writer: %s\n", SDL_GetError());
+        return 0;
+    }
+    logSink = queueLogMessage;
+
+    if(!stopRegisteredAtExit){
+        atexit(stopLogWriter);
+        stopRegisteredAtExit = true;
+    }
+    return 1;
+}
+
+void stopLogWriter(void)
+{
+    if(logWriterThread == NULL){
+        return;
+    }
+
+    // The writer empties the rings before it exits. Messages keep being queued until they are all written,
+    // so none is printed directly ahead of older ones still queued.
+    SDL_AtomicSet(&logWriterStopping, 1);
+    SDL_WaitThread(logWriterThread, NULL);
+    logWriterThread = NULL;
+    writeQueuedLogMessages();
+
+    // Messages logged from here on are printed immediately, after any queued while the sink was cleared
+    logSink = NULL;
+    writeQueuedLogMessages();
+}
+
+int findLogLevel(const char *name, LogLevel *level)
+{
+    for(unsigned int levelNum = LOG_DEBUG; levelNum <= LOG_NONE; levelNum++){
+        if(strcmp(name, logLevelNames[levelNum]) == 0){
+            *level = (LogLevel)levelNum;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Log sink formatting a message into the logging thread's ring, never blocks
+ * @param level - Importance of the message, already checked against the log level
+ * @param format - print format specifier
+ * @param argList - arguments to be printed
+ */
+void queueLogMessage(LogLevel level, const char *format, va_list argList)
+{
+    LogRing *ring = getThreadLogRing();
+    if(ring == NULL){
+        SDL_AtomicAdd(&numDroppedWithoutRing, 1);
+        return;
+    }
+
+    uint32_t writeIndex = (uint32_t)SDL_AtomicGet(&ring->writeIndex);
+    uint32_t readIndex = (uint32_t)SDL_AtomicGet(&ring->readIndex);
+    if(writeIndex-readIndex >= LOG_RING_CAPACITY){
+        SDL_AtomicAdd(&ring->numDropped, 1);
+        return;
+    }
+
+    uint32_t slot = writeIndex & (LOG_RING_CAPACITY-1);
+    char *message = ring->messages[slot];
+    int length = vsnprintf(message, LOG_MESSAGE_SIZE, format, argList);
+    if(length >= LOG_MESSAGE_SIZE){
+        strcpy(&(message[LOG_MESSAGE_SIZE-5]), "...\n");
+    }
+    ring->sequenceNums[slot] = (uint32_t)SDL_AtomicAdd(&logSequenceNum, 1);
+
+    // Publishes the message to the writer
+    SDL_AtomicSet(&ring->writeIndex, (int)(writeIndex+1));
+}
+
+/**
+ * Finds the calling thread's ring, claiming a free one the first time the thread logs
+ * @return - The thread's ring, or NULL if every ring is taken
+ */
+LogRing *getThreadLogRing(void)
+{
+    LogRing *ring = SDL_TLSGet(logRingKey);
+    if(ring != NULL){
+        return ring;
+    }
+
+    for(unsigned int ringNum = 0; ringNum < LOG_MAX_THREADS; ringNum++){
+        if(SDL_AtomicCAS(&logRings[ringNum]->state, LOG_RING_FREE, LOG_RING_ACTIVE)){
+            ring = logRings[ringNum];
+            SDL_TLSSet(logRingKey, ring, releaseLogRing);
+            return ring;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Called by SDL when a thread that claimed a ring exits
+ * @param ring - The thread's ring
+ */
+void releaseLogRing(void *ring)
+{
+    SDL_AtomicSet(&((LogRing *)ring)->state, LOG_RING_FINISHED);
+}
+
+/**
+ * Background thread writing out queued messages until the writer is stopped
+ * @param data - Unused
+ * @return int - 0
+ */
+int runLogWriter(void *data)
+{
+    (void)data;
+
+    while(!SDL_AtomicGet(&logWriterStopping)){
+        if(writeQueuedLogMessages() == 0){
+            SDL_Delay(LOG_WRITE_INTERVAL_MS);
+        }
+    }
+    writeQueuedLogMessages();
+
+    return 0;
+}
+
+/**
+ * Writes out every queued message, oldest first across all rings
+ * @return int - Number of messages written
+ */
+int writeQueuedLogMessages(void)
+{
+    int numWritten = 0;
+    while(1){
+        // The ring whose next message was logged first
+        LogRing *oldestRing = NULL;
+        uint32_t oldestSequenceNum = 0;
+        for(unsigned int ringNum = 0; ringNum < LOG_MAX_THREADS; ringNum++){
+            LogRing *ring = logRings[ringNum];
+            uint32_t readIndex = (uint32_t)SDL_AtomicGet(&ring->readIndex);
+            if((uint32_t)SDL_AtomicGet(&ring->writeIndex) == readIndex){
+                continue;
+            }
+            uint32_t sequenceNum = ring->sequenceNums[readIndex & (LOG_RING_CAPACITY-1)];
+            if(oldestRing == NULL || (int32_t)(sequenceNum-oldestSequenceNum) < 0){
+                oldestRing = ring;
+                oldestSequenceNum = sequenceNum;
+            }
+        }
+        if(oldestRing == NULL){
+            break;
+        }
+
+        uint32_t readIndex = (uint32_t)SDL_AtomicGet(&oldestRing->readIndex);
+        fputs(oldestRing->messages[readIndex & (LOG_RING_CAPACITY-1)], stdout);
+        SDL_AtomicSet(&oldestRing->readIndex, (int)(readIndex+1));
+        numWritten++;
+    }
+
+    unsigned int numDropped = (unsigned int)SDL_AtomicSet(&numDroppedWithoutRing, 0);
+    for(unsigned int ringNum = 0; ringNum < LOG_MAX_THREADS; ringNum++){
+        LogRing *ring = logRings[ringNum];
+        numDropped += (unsigned int)SDL_AtomicSet(&ring->numDropped, 0);
+
+        // Rings of exited threads are reused once emptied
+        if(SDL_AtomicGet(&ring->state) == LOG_RING_FINISHED
+           && SDL_AtomicGet(&ring->readIndex) == SDL_AtomicGet(&ring->writeIndex)){
+            SDL_AtomicSet(&ring->state, LOG_RING_FREE);
+        }
+    }
+    if(numDropped > 0){
+        printf("%u log messages dropped, the log rings were full\n", numDropped);
+        numWritten++;
+    }
+
+    if(numWritten > 0){
+        fflush(stdout);
+    }
+    return numWritten;
+}
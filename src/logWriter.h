@@ -0,0 +1,64 @@
+/***********************************************************************************
+ *
+ * Header for the background log writer.
+ *
+ * Once started, log messages are no longer printed by the thread logging them. Each
+ * thread formats its messages into its own single-producer/single-consumer lock-free
+ * ring, and a background thread drains the rings to stdout, in the order the messages
+ * were logged. A thread logging a message never waits on a lock or on the terminal; if
+ * its ring is full the message is dropped, and the number dropped is logged later.
+ * Messages below the log level are dropped before being formatted (see LOG() in helpers.h).
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_LOGWRITER_H
+#define INTEL_8080_EMULATOR_LOGWRITER_H
+
+#include "sdl_sources/SDL.h"
+#include "helpers.h"
+
+#define LOG_MESSAGE_SIZE 256  // Longer messages are cut short
+#define LOG_RING_CAPACITY 256  // Messages per ring, must be a power of 2
+#define LOG_MAX_THREADS 16  // Threads that may log at once, messages from any more are dropped
+#define LOG_WRITE_INTERVAL_MS 5  // How long the writer sleeps when there is nothing to write
+
+/**
+ * One thread's queue of formatted messages.
+ *
+ * readIndex is only advanced by the writer thread and writeIndex is only advanced by the
+ * thread owning the ring. Both are free-running counters, masked with (LOG_RING_CAPACITY-1)
+ * to index the ring.
+ */
+typedef struct LogRing{
+    char messages[LOG_RING_CAPACITY][LOG_MESSAGE_SIZE];
+    uint32_t sequenceNums[LOG_RING_CAPACITY];  /**< Order each message was logged in, across all threads */
+    SDL_atomic_t readIndex;
+    SDL_atomic_t writeIndex;
+    SDL_atomic_t state;  /**< LOG_RING_FREE, LOG_RING_ACTIVE or LOG_RING_FINISHED */
+    SDL_atomic_t numDropped;  /**< Messages dropped since the writer last checked */
+} LogRing;
+
+/**
+ * Starts the background log writer and sets the log level.
+ * Messages still queued are written when stopLogWriter is called, or at exit.
+ * @param level - Messages below this level are dropped
+ * @return int - 1 if the writer started, 0 if messages will still be printed immediately
+ */
+int startLogWriter(LogLevel level);
+
+/**
+ * Writes out every queued message and stops the background log writer.
+ * Messages are printed immediately again afterwards. Does nothing if the writer is not running.
+ */
+void stopLogWriter(void);
+
+/**
+ * Reads a log level name
+ * @param name - "debug", "info", "warning", "error" or "none"
+ * @param level - Set to the level named
+ * @return int - 1 if the name is a log level, 0 otherwise
+ */
+int findLogLevel(const char *name, LogLevel *level);
+
+#endif //INTEL_8080_EMULATOR_LOGWRITER_H
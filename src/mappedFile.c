@@ -0,0 +1,89 @@
+/***********************************************************************************
+ *
+ * Source for read-only memory mapping of files
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+int mapFile(const char *path, MappedFile *mappedFile)
+{
+    mappedFile->data = NULL;
+    mappedFile->size = 0;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        return 0;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0){
+        CloseHandle(file);
+        return 0;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);  // The mapping object keeps the file open
+    if(mapping == NULL){
+        return 0;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);  // The view keeps the mapping object alive
+    if(view == NULL){
+        return 0;
+    }
+
+    mappedFile->data = (const uint8_t *)view;
+    mappedFile->size = (size_t)fileSize.QuadPart;
+#else
+    int file = open(path, O_RDONLY);
+    if(file < 0){
+        return 0;
+    }
+
+    struct stat fileStatus;
+    if(fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0){
+        close(file);
+        return 0;
+    }
+
+    void *view = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);  // The mapping keeps its own reference to the file
+    if(view == MAP_FAILED){
+        return 0;
+    }
+
+    mappedFile->data = (const uint8_t *)view;
+    mappedFile->size = (size_t)fileStatus.st_size;
+#endif
+
+    return 1;
+}
+
+void unmapFile(MappedFile *mappedFile)
+{
+    if(mappedFile->data == NULL){
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile((LPCVOID)mappedFile->data);
+#else
+    munmap((void *)mappedFile->data, mappedFile->size);
+#endif
+
+    mappedFile->data = NULL;
+    mappedFile->size = 0;
+}
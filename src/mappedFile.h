@@ -0,0 +1,37 @@
+/***********************************************************************************
+ *
+ * Header for read-only memory mapping of files.
+ * Uses mmap on POSIX hosts and file mapping objects on Windows, so the contents are
+ * served straight from the host's page cache without being copied.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_MAPPEDFILE_H
+#define INTEL_8080_EMULATOR_MAPPEDFILE_H
+
+#include "cpuStructures.h"
+
+/**
+ * A file mapped read-only into memory
+ */
+typedef struct MappedFile{
+    const uint8_t *data;  /**< Start of the file contents */
+    size_t size;  /**< Size of the file, in bytes */
+} MappedFile;
+
+/**
+ * Maps an entire file read-only into memory.
+ * @param path - Path of the file to map
+ * @param mappedFile - Receives the mapping
+ * @return int - 1 if the file was mapped, 0 otherwise (including for empty files)
+ */
+int mapFile(const char *path, MappedFile *mappedFile);
+
+/**
+ * Releases a mapping made by mapFile
+ * @param mappedFile - The mapping to release
+ */
+void unmapFile(MappedFile *mappedFile);
+
+#endif //INTEL_8080_EMULATOR_MAPPEDFILE_H
@@ -0,0 +1,331 @@
+/***********************************************************************************
+ *
+ * Per instruction class CPU microbenchmarks.
+ *
+ * Each kernel is a short 8080 program exercising one class of instructions, such as
+ * register moves, memory accesses through HL or CALL/RET chains. Its body is unrolled
+ * KERNEL_UNROLL times and closed with a JMP back to the start, so the loop itself adds
+ * little. The kernels are assembled into ROM, so every CPU engine can run them, and each
+ * is run for a fixed number of instructions on each engine. The host time taken per
+ * emulated instruction shows which instruction classes an engine is slow at.
+ *
+ * Usage: microbench [--kernel NAME] [--instructions N] [--repeat N]
+ * --kernel NAME     Only run the named kernel
+ * --instructions N  Instructions emulated per timed run (default 5000000, at most 100000000)
+ * --repeat N        Timed runs of each kernel on each engine (default 5)
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "cpuEngines.h"
+#include "helpers.h"
+#include "sdl_sources/SDL.h"
+
+#define DEFAULT_MICROBENCH_INSTRUCTIONS 5000000
+#define MAX_MICROBENCH_INSTRUCTIONS 100000000  // Keeps a run's end within the engine's reach of the cycle count
+#define DEFAULT_MICROBENCH_REPEATS 5
+#define KERNEL_UNROLL 16  // Copies of a kernel's body per loop
+#define KERNEL_STACK_ADDRESS 0x2400  // Top of the stack, just below VRAM
+#define KERNEL_DATA_ADDRESS 0x2100  // Memory the kernels read and write
+
+/**
+ * Assembles 8080 code into a ROM image
+ */
+typedef struct KernelWriter{
+    uint8_t *rom;
+    uint16_t address;  /**< Address the next byte is written to */
+} KernelWriter;
+
+/**
+ * A microbenchmark program
+ */
+typedef struct Kernel{
+    const char *name;
+    const char *description;
+    void (*writeSetup)(KernelWriter *writer);  /**< Code run once before the loop, may be NULL */
+    void (*writeBody)(KernelWriter *writer);  /**< Code repeated in the loop */
+} Kernel;
+
+void writeByte(KernelWriter *writer, uint8_t value);
+void writeInstruction(KernelWriter *writer, uint8_t opcode, uint16_t operand, unsigned int size);
+void writeSetupRegisters(KernelWriter *writer);
+void writeRegisterMoves(KernelWriter *writer);
+void writeMemoryHL(KernelWriter *writer);
+void writeAluFlags(KernelWriter *writer);
+void writeRegisterPairs(KernelWriter *writer);
+void writeCallReturnChain(KernelWriter *writer);
+void writePushPop(KernelWriter *writer);
+void writeDecimalAdjust(KernelWriter *writer);
+void writeConditionalBranches(KernelWriter *writer);
+uint8_t *assembleKernel(const Kernel *kernel);
+double timeKernel(CpuEngine *engine, State8080 *cpu, uint64_t numInstructions);
+
+const Kernel kernels[] = {
+    {"reg_move", "MOV between registers", writeSetupRegisters, writeRegisterMoves},
+    {"mem_hl", "MOV, MVI, INR, DCR and ALU ops on memory at HL", writeSetupRegisters, writeMemoryHL},
+    {"alu_flags", "ALU ops on registers and immediates, with ADC, SBB and rotates using the carry", writeSetupRegisters, writeAluFlags},
+    {"reg_pair", "INX, DCX, DAD, XCHG, LHLD and SHLD", writeSetupRegisters, writeRegisterPairs},
+    {"call_ret", "CALL and RET, four calls deep", writeSetupRegisters, writeCallReturnChain},
+    {"push_pop", "PUSH and POP of every register pair", writeSetupRegisters, writePushPop},
+    {"daa", "BCD addition with ADI and DAA", writeSetupRegisters, writeDecimalAdjust},
+    {"branch", "Conditional jumps, taken and not taken", writeSetupRegisters, writeConditionalBranches}
+};
+#define NUM_KERNELS (sizeof(kernels)/sizeof(kernels[0]))
+
+int main(int argc, char **argv)
+{
+    const char *kernelName = NULL;
+    uint64_t numInstructions = DEFAULT_MICROBENCH_INSTRUCTIONS;
+    unsigned int numRepeats = DEFAULT_MICROBENCH_REPEATS;
+
+    for(int argNum = 1; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--kernel") == 0 && argNum+1 < argc){
+            argNum++;
+            kernelName = argv[argNum];
+        }else if(strcmp(argv[argNum], "--instructions") == 0 && argNum+1 < argc){
+            argNum++;
+            numInstructions = strtoull(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--repeat") == 0 && argNum+1 < argc){
+            argNum++;
+            numRepeats = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else{
+            logger("Usage: %s [--kernel NAME] [--instructions N] [--repeat N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if(numInstructions == 0 || numRepeats == 0){
+        logger("Number of instructions and of runs must be at least 1\n");
+        return 1;
+    }
+    if(numInstructions > MAX_MICROBENCH_INSTRUCTIONS){
+        logger("Number of instructions must be at most %d\n", MAX_MICROBENCH_INSTRUCTIONS);
+        return 1;
+    }
+
+    logger("ns per emulated instruction, mean (best) of %u runs of %llu instructions\n",
+           numRepeats, (unsigned long long)numInstructions);
+    logger("%-10s", "kernel");
+    for(unsigned int engineNum = 0; engineNum < NUM_CPU_ENGINES; engineNum++){
+        logger("  %20s", getCpuEngineName((enum CpuEngineType)engineNum));
+    }
+    logger("\n");
+
+    unsigned int numKernelsRun = 0;
+    for(unsigned int kernelNum = 0; kernelNum < NUM_KERNELS; kernelNum++){
+        const Kernel *kernel = &(kernels[kernelNum]);
+        if(kernelName != NULL && strcmp(kernelName, kernel->name) != 0){
+            continue;
+        }
+        uint8_t *romImage = assembleKernel(kernel);
+
+        logger("%-10s", kernel->name);
+        for(unsigned int engineNum = 0; engineNum < NUM_CPU_ENGINES; engineNum++){
+            // A fresh CPU and engine for every kernel, so nothing decoded for one kernel is reused by another
+            State8080 *cpu = initializeCPU(romImage);
+            CpuEngine *engine = initializeCpuEngine((enum CpuEngineType)engineNum);
+            prepareCpuEngine(engine, cpu->memory);  // The kernel is analyzed as the arcade's ROM would be
+            timeKernel(engine, cpu, numInstructions);  // Warm-up
+
+            double totalNanoseconds = 0;
+            double bestNanoseconds = 0;
+            for(unsigned int repeat = 0; repeat < numRepeats; repeat++){
+                double nanoseconds = timeKernel(engine, cpu, numInstructions)*1e9/(double)numInstructions;
+                totalNanoseconds += nanoseconds;
+                if(repeat == 0 || nanoseconds < bestNanoseconds){
+                    bestNanoseconds = nanoseconds;
+                }
+            }
+            logger("  %10.2f (%7.2f)", totalNanoseconds/numRepeats, bestNanoseconds);
+
+            destroyCpuEngine(engine);
+            destroyCPU(cpu);
+        }
+        logger("  %s\n", kernel->description);
+
+        free(romImage);
+        numKernelsRun++;
+    }
+
+    if(numKernelsRun == 0){
+        logger("Unknown kernel %s\n", kernelName);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Assembles a kernel at the start of a ROM image: its setup code, then its body unrolled and
+ * closed with a jump back to the start of the body
+ * @param kernel - The kernel
+ * @return - The ROM image, ROM_LIMIT_8080 bytes long
+ */
+uint8_t *assembleKernel(const Kernel *kernel)
+{
+    KernelWriter writer;
+    writer.rom = mallocSet(ROM_LIMIT_8080);
+    writer.address = 0x0000;
+
+    if(kernel->writeSetup != NULL){
+        kernel->writeSetup(&writer);
+    }
+    uint16_t loopAddress = writer.address;
+    for(unsigned int copy = 0; copy < KERNEL_UNROLL; copy++){
+        kernel->writeBody(&writer);
+    }
+    writeInstruction(&writer, 0xc3, loopAddress, 3);  // JMP loop
+
+    return writer.rom;
+}
+
+/**
+ * Runs a kernel from where it last stopped.
+ * A run end is set, as in runForCpuCycles, so the engine's dead flag handlers are timed. The run stops
+ * short of that end, leaving flags stale that no kernel instruction reads before overwriting them.
+ * @param engine - Engine executing the kernel
+ * @param cpu - CPU with the kernel in ROM
+ * @param numInstructions - Number of instructions to execute
+ * @return - Host time taken, in seconds
+ */
+double timeKernel(CpuEngine *engine, State8080 *cpu, uint64_t numInstructions)
+{
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    setCpuEngineRunEnd(engine, cpu->cyclesCompleted + (unsigned int)numInstructions*MAX_INSTRUCTION_CYCLES);
+    uint64_t instructionNum = 0;
+    while(instructionNum < numInstructions){
+        instructionNum += stepCpuEngine(engine, cpu);
+    }
+    clearCpuEngineRunEnd(engine);
+    return (double)(SDL_GetPerformanceCounter()-startTicks)/(double)SDL_GetPerformanceFrequency();
+}
+
+void writeByte(KernelWriter *writer, uint8_t value)
+{
+    if(writer->address >= ROM_LIMIT_8080){
+        logger("Kernel does not fit in ROM\n");
+        exit(1);
+    }
+    writer->rom[writer->address] = value;
+    writer->address++;
+}
+
+/**
+ * Writes an instruction
+ * @param writer - Where the instruction goes
+ * @param opcode - The opcode
+ * @param operand - Immediate data or address, ignored for single byte instructions
+ * @param size - Size of the instruction in bytes
+ */
+void writeInstruction(KernelWriter *writer, uint8_t opcode, uint16_t operand, unsigned int size)
+{
+    writeByte(writer, opcode);
+    if(size >= 2){
+        writeByte(writer, (uint8_t)operand);
+    }
+    if(size == 3){
+        writeByte(writer, (uint8_t)(operand>>8));
+    }
+}
+
+/**
+ * Points SP at the stack and HL at the kernel data, and gives the other registers distinct values
+ */
+void writeSetupRegisters(KernelWriter *writer)
+{
+    writeInstruction(writer, 0x31, KERNEL_STACK_ADDRESS, 3);  // LXI SP
+    writeInstruction(writer, 0x21, KERNEL_DATA_ADDRESS, 3);  // LXI H
+    writeInstruction(writer, 0x01, 0x1234, 3);  // LXI B
+    writeInstruction(writer, 0x11, 0x5678, 3);  // LXI D
+    writeInstruction(writer, 0x3e, 0x9a, 2);  // MVI A
+}
+
+void writeRegisterMoves(KernelWriter *writer)
+{
+    // MOV B,C  MOV C,D  MOV D,E  MOV E,A  MOV A,B  MOV C,A  MOV E,B  MOV A,D
+    const uint8_t opcodes[] = {0x41, 0x4a, 0x53, 0x5f, 0x78, 0x4f, 0x58, 0x7a};
+    for(unsigned int opNum = 0; opNum < sizeof(opcodes); opNum++){
+        writeInstruction(writer, opcodes[opNum], 0, 1);
+    }
+}
+
+void writeMemoryHL(KernelWriter *writer)
+{
+    writeInstruction(writer, 0x77, 0, 1);  // MOV M,A
+    writeInstruction(writer, 0x46, 0, 1);  // MOV B,M
+    writeInstruction(writer, 0x34, 0, 1);  // INR M
+    writeInstruction(writer, 0x86, 0, 1);  // ADD M
+    writeInstruction(writer, 0x35, 0, 1);  // DCR M
+    writeInstruction(writer, 0x36, 0x55, 2);  // MVI M
+    writeInstruction(writer, 0xbe, 0, 1);  // CMP M
+    writeInstruction(writer, 0x7e, 0, 1);  // MOV A,M
+}
+
+void writeAluFlags(KernelWriter *writer)
+{
+    // ADD B  ADC C  SUB D  SBB E  ANA H  XRA L  ORA B  CMP C
+    const uint8_t opcodes[] = {0x80, 0x89, 0x92, 0x9b, 0xa4, 0xad, 0xb0, 0xb9};
+    for(unsigned int opNum = 0; opNum < sizeof(opcodes); opNum++){
+        writeInstruction(writer, opcodes[opNum], 0, 1);
+    }
+    writeInstruction(writer, 0xc6, 0x35, 2);  // ADI
+    writeInstruction(writer, 0xde, 0x11, 2);  // SBI
+    writeInstruction(writer, 0x17, 0, 1);  // RAL
+    writeInstruction(writer, 0x1f, 0, 1);  // RAR
+}
+
+void writeRegisterPairs(KernelWriter *writer)
+{
+    writeInstruction(writer, 0x03, 0, 1);  // INX B
+    writeInstruction(writer, 0x1b, 0, 1);  // DCX D
+    writeInstruction(writer, 0x09, 0, 1);  // DAD B
+    writeInstruction(writer, 0x19, 0, 1);  // DAD D
+    writeInstruction(writer, 0xeb, 0, 1);  // XCHG
+    writeInstruction(writer, 0x22, KERNEL_DATA_ADDRESS, 3);  // SHLD
+    writeInstruction(writer, 0x2a, KERNEL_DATA_ADDRESS+2, 3);  // LHLD
+    writeInstruction(writer, 0x23, 0, 1);  // INX H
+}
+
+void writeCallReturnChain(KernelWriter *writer)
+{
+    // Each copy of the body has its own chain of subroutines, jumped over on the way into the chain
+    uint16_t firstSubroutine = writer->address+6;
+    writeInstruction(writer, 0xcd, firstSubroutine, 3);  // CALL
+    uint16_t nextBody = firstSubroutine+3*4+1;
+    writeInstruction(writer, 0xc3, nextBody, 3);  // JMP
+    for(unsigned int depth = 1; depth < 4; depth++){
+        writeInstruction(writer, 0xcd, writer->address+4, 3);  // CALL the next subroutine
+        writeInstruction(writer, 0xc9, 0, 1);  // RET
+    }
+    writeInstruction(writer, 0xc9, 0, 1);  // RET
+}
+
+void writePushPop(KernelWriter *writer)
+{
+    // PUSH B  PUSH D  PUSH H  PUSH PSW  POP PSW  POP H  POP D  POP B
+    const uint8_t opcodes[] = {0xc5, 0xd5, 0xe5, 0xf5, 0xf1, 0xe1, 0xd1, 0xc1};
+    for(unsigned int opNum = 0; opNum < sizeof(opcodes); opNum++){
+        writeInstruction(writer, opcodes[opNum], 0, 1);
+    }
+}
+
+void writeDecimalAdjust(KernelWriter *writer)
+{
+    const uint8_t addends[] = {0x19, 0x01, 0x58, 0x99};
+    for(unsigned int addendNum = 0; addendNum < sizeof(addends); addendNum++){
+        writeInstruction(writer, 0xc6, addends[addendNum], 2);  // ADI
+        writeInstruction(writer, 0x27, 0, 1);  // DAA
+    }
+}
+
+void writeConditionalBranches(KernelWriter *writer)
+{
+    // Every jump goes to the next instruction, so the path is the same whether it is taken or not
+    // JNZ  JZ  JNC  JC  JPO  JPE  JP  JM
+    const uint8_t opcodes[] = {0xc2, 0xca, 0xd2, 0xda, 0xe2, 0xea, 0xf2, 0xfa};
+    writeInstruction(writer, 0x05, 0, 1);  // DCR B
+    for(unsigned int opNum = 0; opNum < sizeof(opcodes); opNum++){
+        writeInstruction(writer, opcodes[opNum], writer->address+3, 3);
+        if(opNum == 3){
+            writeInstruction(writer, 0x07, 0, 1);  // RLC, so the carry changes too
+        }
+    }
+}
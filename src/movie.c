@@ -0,0 +1,287 @@
+/***********************************************************************************
+ *
+ * Source for recording and replaying input movies
+ * @Author: Andrew Gunter
+ *
+ * Layout (multi-byte values are little-endian):
+ *   0  Magic "SIMV"
+ *   4  Version (16 bits)
+ *   6  Reserved (16 bits, zero)
+ *   8  Number of frames (32 bits)
+ *  12  Keyframe interval in frames (32 bits)
+ *  16  File offset of the keyframe index (32 bits)
+ *  20  Segments, one per keyframe interval:
+ *        Keyframe, a save state captured before the segment's first frame
+ *        Runs covering the segment's frames, none crossing into the next segment:
+ *          Run length in frames (16 bits), input port 0, input port 1, input port 2
+ *      Keyframe index, until the end of the file:
+ *        Frame number (32 bits), file offset of the keyframe (32 bits)
+ *
+***********************************************************************************/
+
+#include "movie.h"
+
+const uint8_t movieMagic[4] = {'S', 'I', 'M', 'V'};
+
+void writeMovieRun(MovieRecorder *recorder);
+void writeMovieKeyframe(MovieRecorder *recorder, ArcadeState *arcade);
+void writeMovieWord(FILE *file, uint32_t value, unsigned int numBytes);
+
+MovieRecorder *initializeMovieRecorder(const char *path, uint32_t keyframeInterval)
+{
+    FILE *file = fopen(path, "wb");
+    if(file == NULL){
+        LOG(LOG_ERROR, "Failed to create movie file %s\n", path);
+        return NULL;
+    }
+
+    MovieRecorder *recorder = mallocSet(sizeof(MovieRecorder));
+    recorder->file = file;
+    recorder->keyframeInterval = (keyframeInterval > 0) ? keyframeInterval : DEFAULT_KEYFRAME_INTERVAL;
+
+    // Frame count and index offset are filled in once recording finishes
+    fwrite(movieMagic, 1, sizeof(movieMagic), file);
+    writeMovieWord(file, MOVIE_VERSION, 2);
+    writeMovieWord(file, 0, 2);
+    writeMovieWord(file, 0, 4);
+    writeMovieWord(file, recorder->keyframeInterval, 4);
+    writeMovieWord(file, 0, 4);
+    recorder->fileSize = MOVIE_HEADER_SIZE;
+
+    return recorder;
+}
+
+void recordMovieFrame(MovieRecorder *recorder, ArcadeState *arcade)
+{
+    uint8_t ports[MOVIE_NUM_PORTS] = {arcade->inputPort0, arcade->inputPort1, arcade->inputPort2};
+
+    if(recorder->numFrames % recorder->keyframeInterval == 0){
+        writeMovieRun(recorder);
+        writeMovieKeyframe(recorder, arcade);
+    }
+
+    // Extend the current run if the input has not changed
+    if(recorder->runLength > 0 && recorder->runLength < MOVIE_MAX_RUN_LENGTH &&
+       memcmp(ports, recorder->runPorts, MOVIE_NUM_PORTS) == 0){
+        recorder->runLength++;
+    }else{
+        writeMovieRun(recorder);
+        memcpy(recorder->runPorts, ports, MOVIE_NUM_PORTS);
+        recorder->runLength = 1;
+    }
+
+    recorder->numFrames++;
+}
+
+void destroyMovieRecorder(MovieRecorder *recorder)
+{
+    if(recorder == NULL){
+        return;
+    }
+
+    writeMovieRun(recorder);
+
+    uint32_t indexOffset = recorder->fileSize;
+    for(uint32_t keyframeNum = 0; keyframeNum < recorder->numKeyframes; keyframeNum++){
+        writeMovieWord(recorder->file, recorder->keyframes[keyframeNum].frame, 4);
+        writeMovieWord(recorder->file, recorder->keyframes[keyframeNum].offset, 4);
+    }
+
+    fseek(recorder->file, 8, SEEK_SET);
+    writeMovieWord(recorder->file, recorder->numFrames, 4);
+    fseek(recorder->file, 16, SEEK_SET);
+    writeMovieWord(recorder->file, indexOffset, 4);
+    if(fclose(recorder->file) != 0){
+        LOG(LOG_ERROR, "Failed to finish movie file!\n");
+    }
+    free(recorder->keyframes);
+    free(recorder);
+}
+
+MoviePlayer *initializeMoviePlayer(const char *path)
+{
+    MoviePlayer *player = mallocSet(sizeof(MoviePlayer));
+
+    if(mapFile(path, &(player->file)) == 0){
+        LOG(LOG_ERROR, "Failed to open movie file %s\n", path);
+        free(player);
+        return NULL;
+    }
+
+    const uint8_t *data = player->file.data;
+    size_t size = player->file.size;
+    if(size < MOVIE_HEADER_SIZE || memcmp(data, movieMagic, sizeof(movieMagic)) != 0 ||
+       readLittleEndian(&(data[4]), 2) != MOVIE_VERSION){
+        LOG(LOG_ERROR, "%s is not a version %d movie file\n", path, MOVIE_VERSION);
+        destroyMoviePlayer(player);
+        return NULL;
+    }
+
+    player->numFrames = readLittleEndian(&(data[8]), 4);
+    player->keyframeInterval = readLittleEndian(&(data[12]), 4);
+    uint32_t indexOffset = readLittleEndian(&(data[16]), 4);
+    if(player->keyframeInterval == 0 || indexOffset < MOVIE_HEADER_SIZE || indexOffset > size ||
+       (size-indexOffset) % MOVIE_INDEX_ENTRY_SIZE != 0){
+        LOG(LOG_ERROR, "Movie file %s is damaged or was not finished\n", path);
+        destroyMoviePlayer(player);
+        return NULL;
+    }
+
+    player->indexOffset = indexOffset;
+    player->index = &(data[indexOffset]);
+    player->numKeyframes = (uint32_t)((size-indexOffset)/MOVIE_INDEX_ENTRY_SIZE);
+    player->currentFrame = 0;
+    player->nextOffset = MOVIE_HEADER_SIZE;
+    player->framesLeftInRun = 0;
+
+    return player;
+}
+
+int playMovieFrame(MoviePlayer *player, ArcadeState *arcade)
+{
+    const uint8_t *data = player->file.data;
+
+    if(player->currentFrame >= player->numFrames){
+        return 0;
+    }
+
+    // Move on to the next run once this one is used up, stepping over a keyframe at the start of each segment
+    if(player->framesLeftInRun == 0){
+        if(player->currentFrame % player->keyframeInterval == 0){
+            player->nextOffset += SAVE_STATE_SIZE;
+        }
+        if(player->nextOffset + MOVIE_RUN_SIZE > player->indexOffset ||
+           readLittleEndian(&(data[player->nextOffset]), 2) == 0){
+            LOG(LOG_ERROR, "Movie file ends early, at frame %u of %u\n", player->currentFrame, player->numFrames);
+            player->numFrames = player->currentFrame;
+            return 0;
+        }
+        player->framesLeftInRun = (uint16_t)readLittleEndian(&(data[player->nextOffset]), 2);
+        player->runPorts = &(data[player->nextOffset+2]);
+        player->nextOffset += MOVIE_RUN_SIZE;
+    }
+
+    arcade->inputPort0 = player->runPorts[0];
+    arcade->inputPort1 = player->runPorts[1];
+    arcade->inputPort2 = player->runPorts[2];
+
+    player->framesLeftInRun--;
+    player->currentFrame++;
+
+    return 1;
+}
+
+int seekMovie(MoviePlayer *player, ArcadeState *arcade, uint32_t frame)
+{
+    if(frame > player->numFrames || player->numKeyframes == 0){
+        LOG(LOG_ERROR, "Cannot seek to frame %u of a %u frame movie\n", frame, player->numFrames);
+        return 0;
+    }
+
+    // Binary search for the last keyframe at or before the frame
+    uint32_t low = 0;
+    uint32_t high = player->numKeyframes;
+    while(high-low > 1){
+        uint32_t middle = low + (high-low)/2;
+        if(readLittleEndian(&(player->index[middle*MOVIE_INDEX_ENTRY_SIZE]), 4) <= frame){
+            low = middle;
+        }else{
+            high = middle;
+        }
+    }
+    MovieKeyframe keyframe;
+    if(getMovieKeyframe(player, low, &keyframe) == 0 || keyframe.frame > frame ||
+       loadState(arcade, getMovieKeyframeState(player, &keyframe), SAVE_STATE_SIZE) == 0){
+        LOG(LOG_ERROR, "Movie keyframe for frame %u is damaged\n", frame);
+        return 0;
+    }
+    // Playback steps over the keyframe itself before reading the segment's first run
+    player->currentFrame = keyframe.frame;
+    player->nextOffset = keyframe.offset;
+    player->framesLeftInRun = 0;
+
+    while(player->currentFrame < frame){
+        resetPortsIO(arcade);
+        if(playMovieFrame(player, arcade) == 0){
+            return 0;
+        }
+        runFrame(arcade);
+    }
+
+    return 1;
+}
+
+int getMovieKeyframe(MoviePlayer *player, uint32_t keyframeNum, MovieKeyframe *keyframe)
+{
+    if(keyframeNum >= player->numKeyframes){
+        return 0;
+    }
+
+    keyframe->frame = readLittleEndian(&(player->index[keyframeNum*MOVIE_INDEX_ENTRY_SIZE]), 4);
+    keyframe->offset = readLittleEndian(&(player->index[keyframeNum*MOVIE_INDEX_ENTRY_SIZE+4]), 4);
+
+    // Keyframes have to start a segment and lie wholly before the index
+    return keyframe->frame % player->keyframeInterval == 0 && keyframe->frame <= player->numFrames &&
+           keyframe->offset >= MOVIE_HEADER_SIZE && keyframe->offset + SAVE_STATE_SIZE <= player->indexOffset;
+}
+
+const uint8_t *getMovieKeyframeState(MoviePlayer *player, const MovieKeyframe *keyframe)
+{
+    return &(player->file.data[keyframe->offset]);
+}
+
+void destroyMoviePlayer(MoviePlayer *player)
+{
+    if(player == NULL){
+        return;
+    }
+
+    unmapFile(&(player->file));
+    free(player);
+}
+
+/**
+ * Writes the run currently being recorded, if there is one
+ */
+void writeMovieRun(MovieRecorder *recorder)
+{
+    if(recorder->runLength == 0){
+        return;
+    }
+
+    writeMovieWord(recorder->file, recorder->runLength, 2);
+    fwrite(recorder->runPorts, 1, MOVIE_NUM_PORTS, recorder->file);
+    recorder->fileSize += MOVIE_RUN_SIZE;
+    recorder->runLength = 0;
+}
+
+/**
+ * Writes a save state of the arcade and adds it to the keyframe index
+ */
+void writeMovieKeyframe(MovieRecorder *recorder, ArcadeState *arcade)
+{
+    if(recorder->numKeyframes == recorder->maxKeyframes){
+        recorder->maxKeyframes = (recorder->maxKeyframes > 0) ? 2*recorder->maxKeyframes : 64;
+        MovieKeyframe *keyframes = realloc(recorder->keyframes, recorder->maxKeyframes*sizeof(MovieKeyframe));
+        if(keyframes == NULL){
+            LOG(LOG_ERROR, "Failed to grow movie keyframe index!\n");
+            exit(1);
+        }
+        recorder->keyframes = keyframes;
+    }
+
+    recorder->keyframes[recorder->numKeyframes].frame = recorder->numFrames;
+    recorder->keyframes[recorder->numKeyframes].offset = recorder->fileSize;
+    recorder->numKeyframes++;
+
+    saveState(arcade, recorder->keyframeState, SAVE_STATE_SIZE);
+    fwrite(recorder->keyframeState, 1, SAVE_STATE_SIZE, recorder->file);
+    recorder->fileSize += SAVE_STATE_SIZE;
+}
+
+void writeMovieWord(FILE *file, uint32_t value, unsigned int numBytes)
+{
+    uint8_t bytes[4];
+    writeLittleEndian(bytes, value, numBytes);
+    fwrite(bytes, 1, numBytes, file);
+}
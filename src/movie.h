@@ -0,0 +1,138 @@
+/***********************************************************************************
+ *
+ * Header for recording and replaying input movies.
+ *
+ * A movie holds the bytes placed in input ports 0-2 for every frame, which, starting
+ * from power-on, is all that is needed to reproduce a session bit-exactly.
+ * Consecutive frames with identical input are stored as a single run.
+ * Every few seconds a full save state is stored as a keyframe, and an index of the
+ * keyframes is written at the end of the file, so that playback can seek to any frame
+ * by loading the nearest earlier keyframe and replaying only the frames after it.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_MOVIE_H
+#define INTEL_8080_EMULATOR_MOVIE_H
+
+#include "arcadeEnvironment.h"
+#include "mappedFile.h"
+#include "saveState.h"
+
+#define MOVIE_VERSION 2
+#define MOVIE_HEADER_SIZE 20
+#define MOVIE_NUM_PORTS 3  // Input ports 0-2, port 3 is driven by the shift register
+#define MOVIE_RUN_SIZE (2 + MOVIE_NUM_PORTS)
+#define MOVIE_MAX_RUN_LENGTH 0xffff
+#define MOVIE_INDEX_ENTRY_SIZE 8
+
+/**
+ * Location of one keyframe in a movie file
+ */
+typedef struct MovieKeyframe{
+    uint32_t frame;  /**< Number of frames played before the keyframe was captured */
+    uint32_t offset;  /**< File offset of the keyframe's save state */
+} MovieKeyframe;
+
+/**
+ * Writes a movie as frames are played
+ */
+typedef struct MovieRecorder{
+    FILE *file;
+    uint32_t numFrames;
+    uint32_t keyframeInterval;
+    uint32_t fileSize;  /**< Bytes written so far */
+    uint8_t runPorts[MOVIE_NUM_PORTS];  /**< Input of the run currently being recorded */
+    uint16_t runLength;  /**< Frames in the run currently being recorded, 0 if none */
+    uint8_t keyframeState[SAVE_STATE_SIZE];  /**< Scratch space for the keyframe being captured */
+    MovieKeyframe *keyframes;  /**< Index of the keyframes written so far */
+    uint32_t numKeyframes;
+    uint32_t maxKeyframes;
+} MovieRecorder;
+
+/**
+ * Reads a movie back, frame by frame
+ */
+typedef struct MoviePlayer{
+    MappedFile file;
+    uint32_t numFrames;
+    uint32_t keyframeInterval;
+    size_t indexOffset;  /**< Keyframes and runs end where the index begins */
+    const uint8_t *index;  /**< Keyframe index, inside the mapped file */
+    uint32_t numKeyframes;
+    uint32_t currentFrame;  /**< Number of frames already played */
+    size_t nextOffset;  /**< File offset of the next keyframe or run to be read */
+    const uint8_t *runPorts;  /**< Input of the run currently being played, inside the mapped file */
+    uint16_t framesLeftInRun;
+} MoviePlayer;
+
+/**
+ * Creates a movie file and prepares to record into it
+ * @param path - Path of the movie file, overwritten if it exists
+ * @param keyframeInterval - Frames between keyframes, 0 selects the default
+ * @return - pointer to the recorder, or NULL if the file could not be created
+ */
+MovieRecorder *initializeMovieRecorder(const char *path, uint32_t keyframeInterval);
+
+/**
+ * Records the input ports the arcade will use for the coming frame, along with a keyframe if one is due.
+ * Should be called once per frame, after the input ports are set and before the frame is emulated.
+ * @param recorder - The movie recorder
+ * @param arcade - The arcade state
+ */
+void recordMovieFrame(MovieRecorder *recorder, ArcadeState *arcade);
+
+/**
+ * Finishes the movie file, writing its keyframe index, and frees the recorder
+ * @param recorder - The movie recorder
+ */
+void destroyMovieRecorder(MovieRecorder *recorder);
+
+/**
+ * Opens a movie file for playback
+ * @param path - Path of the movie file
+ * @return - pointer to the player, or NULL if the file is missing or not a valid movie
+ */
+MoviePlayer *initializeMoviePlayer(const char *path);
+
+/**
+ * Sets the arcade's input ports to the movie's input for the coming frame
+ * @param player - The movie player
+ * @param arcade - The arcade state
+ * @return int - 1 if the ports were set, 0 if the movie has ended
+ */
+int playMovieFrame(MoviePlayer *player, ArcadeState *arcade);
+
+/**
+ * Moves the arcade to the state it was in after a given number of frames of the movie.
+ * The nearest earlier keyframe is loaded and the frames after it are emulated.
+ * @param player - The movie player
+ * @param arcade - The arcade state
+ * @param frame - Number of frames into the movie, no more than the movie's length
+ * @return int - 1 if the arcade was moved, 0 if the frame is out of range or the movie is damaged
+ */
+int seekMovie(MoviePlayer *player, ArcadeState *arcade, uint32_t frame);
+
+/**
+ * Looks up a keyframe in the movie's index
+ * @param player - The movie player
+ * @param keyframeNum - Position of the keyframe in the index, 0 is the keyframe at power-on
+ * @param keyframe - Filled with the keyframe's frame number and file offset
+ * @return int - 1 if the keyframe was found and lies within the file, 0 otherwise
+ */
+int getMovieKeyframe(MoviePlayer *player, uint32_t keyframeNum, MovieKeyframe *keyframe);
+
+/**
+ * @param player - The movie player
+ * @param keyframe - A keyframe returned by getMovieKeyframe
+ * @return - The keyframe's save state, SAVE_STATE_SIZE bytes inside the mapped file
+ */
+const uint8_t *getMovieKeyframeState(MoviePlayer *player, const MovieKeyframe *keyframe);
+
+/**
+ * Closes a movie file and frees the player
+ * @param player - The movie player
+ */
+void destroyMoviePlayer(MoviePlayer *player);
+
+#endif //INTEL_8080_EMULATOR_MOVIE_H
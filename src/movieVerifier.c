@@ -0,0 +1,208 @@
+/***********************************************************************************
+ *
+ * Source for verifying movies in parallel
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "movieVerifier.h"
+
+/**
+ * A worker thread and the arcade it emulates segments on
+ */
+typedef struct VerifierWorker{
+    SDL_Thread *thread;
+    ArcadeState *arcade;
+    MoviePlayer *player;  /**< The worker's own view of the movie, so play positions are not shared */
+    MovieVerification *verification;
+    SDL_atomic_t *nextSegment;  /**< Next segment not yet taken by any worker */
+    uint8_t state[SAVE_STATE_SIZE];  /**< Scratch space for the emulated state at the end of a segment */
+} VerifierWorker;
+
+int runVerifierWorker(void *data);
+void verifySegment(VerifierWorker *worker, MovieSegmentResult *segment);
+void destroyVerifierWorkers(VerifierWorker *workers, unsigned int numWorkers);
+
+MovieVerification *verifyMovie(const ArcadeConfig *config, const char *moviePath, unsigned int numThreads)
+{
+    MoviePlayer *player = initializeMoviePlayer(moviePath);
+    if(player == NULL){
+        return NULL;
+    }
+
+    MovieVerification *verification = mallocSet(sizeof(MovieVerification));
+
+    // Each segment runs from one keyframe to the next
+    MovieKeyframe keyframe;
+    MovieKeyframe nextKeyframe;
+    verification->numSegments = (player->numKeyframes > 1) ? player->numKeyframes-1 : 0;
+    verification->segments = mallocSet((verification->numSegments+1)*sizeof(MovieSegmentResult));
+    for(uint32_t segmentNum = 0; segmentNum < verification->numSegments; segmentNum++){
+        MovieSegmentResult *segment = &(verification->segments[segmentNum]);
+        if(getMovieKeyframe(player, segmentNum, &keyframe) == 0 ||
+           getMovieKeyframe(player, segmentNum+1, &nextKeyframe) == 0 || nextKeyframe.frame <= keyframe.frame){
+            logger("Movie file %s has a damaged keyframe index\n", moviePath);
+            destroyMoviePlayer(player);
+            destroyMovieVerification(verification);
+            return NULL;
+        }
+        segment->startFrame = keyframe.frame;
+        segment->endFrame = nextKeyframe.frame;
+        segment->expectedChecksum = crc32(0, getMovieKeyframeState(player, &nextKeyframe), SAVE_STATE_SIZE);
+        segment->firstDifference = -1;
+    }
+    verification->numUncheckedFrames = player->numFrames;
+    if(player->numKeyframes > 0 && getMovieKeyframe(player, player->numKeyframes-1, &keyframe) == 1){
+        verification->numUncheckedFrames = player->numFrames-keyframe.frame;
+    }
+    destroyMoviePlayer(player);
+
+    if(numThreads == 0){
+        numThreads = (unsigned int)SDL_GetCPUCount();
+    }
+    if(numThreads > verification->numSegments){
+        numThreads = verification->numSegments;
+    }
+    if(numThreads > MAX_VERIFIER_THREADS){
+        numThreads = MAX_VERIFIER_THREADS;
+    }
+    if(numThreads == 0){
+        numThreads = 1;
+    }
+    verification->numThreads = numThreads;
+
+    // Only the options affecting emulation are carried over, workers never record, trace or profile
+    ArcadeConfig workerConfig;
+    setHeadlessArcadeConfig(&workerConfig);
+    workerConfig.resourcePath = config->resourcePath;
+    workerConfig.engine = config->engine;
+    workerConfig.hookMode = config->hookMode;
+
+    // Arcades are created up front, as initializing a CPU is not safe to do from several threads at once
+    SDL_atomic_t nextSegment;
+    SDL_AtomicSet(&nextSegment, 0);
+    VerifierWorker *workers = mallocSet(numThreads*sizeof(VerifierWorker));
+    for(unsigned int workerNum = 0; workerNum < numThreads; workerNum++){
+        VerifierWorker *worker = &(workers[workerNum]);
+        worker->verification = verification;
+        worker->nextSegment = &nextSegment;
+        worker->arcade = initializeArcade(&workerConfig);
+        worker->player = initializeMoviePlayer(moviePath);
+        if(worker->arcade == NULL || worker->player == NULL){
+            destroyVerifierWorkers(workers, workerNum+1);
+            destroyMovieVerification(verification);
+            return NULL;
+        }
+    }
+
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int workerNum = 0; workerNum < numThreads; workerNum++){
+        workers[workerNum].thread = SDL_CreateThread(runVerifierWorker, "MovieVerifier", &(workers[workerNum]));
+        if(workers[workerNum].thread == NULL){
+            // The remaining workers pick up the segments this one would have taken
+            logger("Failed to start verifier thread! SDL Error: %s\n", SDL_GetError());
+        }
+    }
+    for(unsigned int workerNum = 0; workerNum < numThreads; workerNum++){
+        if(workers[workerNum].thread != NULL){
+            SDL_WaitThread(workers[workerNum].thread, NULL);
+        }
+    }
+    verification->seconds = (double)(SDL_GetPerformanceCounter()-startTicks)/(double)SDL_GetPerformanceFrequency();
+    destroyVerifierWorkers(workers, numThreads);
+
+    // Segments that could not be emulated to their end count as desyncs too
+    for(uint32_t segmentNum = 0; segmentNum < verification->numSegments; segmentNum++){
+        if(!(verification->segments[segmentNum].matched)){
+            verification->numDesyncs++;
+        }
+    }
+
+    return verification;
+}
+
+void destroyMovieVerification(MovieVerification *verification)
+{
+    if(verification == NULL){
+        return;
+    }
+
+    free(verification->segments);
+    free(verification);
+}
+
+/**
+ * Takes segments from the shared counter until none are left
+ * @param data - The worker
+ * @return int - always 0
+ */
+int runVerifierWorker(void *data)
+{
+    VerifierWorker *worker = data;
+    MovieVerification *verification = worker->verification;
+
+    while(1){
+        uint32_t segmentNum = (uint32_t)SDL_AtomicAdd(worker->nextSegment, 1);
+        if(segmentNum >= verification->numSegments){
+            break;
+        }
+        verifySegment(worker, &(verification->segments[segmentNum]));
+    }
+
+    return 0;
+}
+
+/**
+ * Emulates a segment from its keyframe and compares the result with the next keyframe
+ */
+void verifySegment(VerifierWorker *worker, MovieSegmentResult *segment)
+{
+    MoviePlayer *player = worker->player;
+    ArcadeState *arcade = worker->arcade;
+
+    if(seekMovie(player, arcade, segment->startFrame) == 0){
+        return;
+    }
+    while(player->currentFrame < segment->endFrame){
+        resetPortsIO(arcade);
+        if(playMovieFrame(player, arcade) == 0){
+            return;
+        }
+        runFrame(arcade);
+    }
+
+    // Keyframes are captured once the input for their frame has been set
+    resetPortsIO(arcade);
+    if(playMovieFrame(player, arcade) == 0){
+        return;
+    }
+    saveState(arcade, worker->state, SAVE_STATE_SIZE);
+    segment->actualChecksum = crc32(0, worker->state, SAVE_STATE_SIZE);
+    segment->verified = true;
+    segment->matched = (segment->actualChecksum == segment->expectedChecksum);
+
+    if(!(segment->matched)){
+        MovieKeyframe keyframe;
+        uint32_t keyframeNum = segment->endFrame/player->keyframeInterval;
+        if(getMovieKeyframe(player, keyframeNum, &keyframe) == 1){
+            const uint8_t *expectedState = getMovieKeyframeState(player, &keyframe);
+            for(int byteNum = 0; byteNum < SAVE_STATE_SIZE; byteNum++){
+                if(worker->state[byteNum] != expectedState[byteNum]){
+                    segment->firstDifference = byteNum;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void destroyVerifierWorkers(VerifierWorker *workers, unsigned int numWorkers)
+{
+    for(unsigned int workerNum = 0; workerNum < numWorkers; workerNum++){
+        destroyMoviePlayer(workers[workerNum].player);
+        if(workers[workerNum].arcade != NULL){
+            destroyArcade(workers[workerNum].arcade);
+        }
+    }
+    free(workers);
+}
@@ -0,0 +1,58 @@
+/***********************************************************************************
+ *
+ * Header for verifying movies in parallel.
+ *
+ * The keyframes of a movie split it into segments that can be re-emulated independently.
+ * Each segment is started from its keyframe and played up to the next keyframe, where the
+ * CRC-32 of the emulated state is compared against the CRC-32 of the recorded keyframe.
+ * Segments are handed out to worker threads, each with its own headless arcade, so
+ * verification time falls with the number of cores.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_MOVIEVERIFIER_H
+#define INTEL_8080_EMULATOR_MOVIEVERIFIER_H
+
+#include "movie.h"
+
+#define MAX_VERIFIER_THREADS 64
+
+/**
+ * Outcome of re-emulating one segment of a movie
+ */
+typedef struct MovieSegmentResult{
+    uint32_t startFrame;  /**< Frame of the keyframe the segment starts from */
+    uint32_t endFrame;  /**< Frame of the keyframe the segment is checked against */
+    uint32_t expectedChecksum;  /**< CRC-32 of the recorded keyframe at endFrame */
+    uint32_t actualChecksum;  /**< CRC-32 of the emulated state at endFrame */
+    int firstDifference;  /**< Offset of the first save state byte that differs from the keyframe, -1 if none */
+    bool verified;  /**< The segment was emulated to its end, whether or not it matched */
+    bool matched;
+} MovieSegmentResult;
+
+typedef struct MovieVerification{
+    MovieSegmentResult *segments;
+    uint32_t numSegments;
+    uint32_t numDesyncs;  /**< Segments that failed to match or could not be emulated */
+    uint32_t numUncheckedFrames;  /**< Frames after the last keyframe, which have nothing to be checked against */
+    unsigned int numThreads;
+    double seconds;  /**< Wall-clock time taken */
+} MovieVerification;
+
+/**
+ * Re-emulates every segment of a movie and checks it against the movie's keyframes
+ * @param config - Runtime options for the worker arcades, the ROM set in particular. Movie and display options are ignored.
+ * @param moviePath - Path of the movie file
+ * @param numThreads - Number of worker threads, 0 to use one per CPU core
+ * @return - pointer to the results, or NULL if the movie or the worker arcades could not be set up
+ */
+MovieVerification *verifyMovie(const ArcadeConfig *config, const char *moviePath, unsigned int numThreads);
+
+/**
+ * Frees the results of a verification
+ * @param verification - The verification results
+ */
+void destroyMovieVerification(MovieVerification *verification);
+
+#endif //INTEL_8080_EMULATOR_MOVIEVERIFIER_H
@@ -0,0 +1,317 @@
+/***********************************************************************************
+ *
+ * Specification of the 8080 opcodes, from which the instruction tables are generated.
+ *
+ * OPCODE_SPEC lists every opcode once, in order, as
+ * X(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler)
+ * mnemonic        Disassembly, naming the operand D8, D16 or adr, e.g. "LXI B;D16"
+ * size            Bytes, opcode included; 0 for opcodes the 8080 does not define, which run as one byte NOPs
+ * cycles          Clock cycles charged, for conditional instructions when the condition is met,
+ *                 and for RST when interrupts are enabled
+ * cyclesNotTaken  Clock cycles charged otherwise; RST does nothing at all with interrupts disabled
+ * flagsRead       Flags whose value before the instruction affects it
+ * flagsWritten    Flags the instruction sets
+ * quirks          How the reference engine departs from the datasheet: TIMING_QUIRK when it charges other cycles,
+ *                 RESULT_QUIRK when it computes another result
+ * handler         Predecoded engine handler, handle<handler> in cpuEngines.c; Fallback runs the reference engine,
+ *                 e.g. for ADC M, which adds one more than it should there
+ *
+ * Cycles and flags are those of the reference engine, which the golden runs are recorded with,
+ * not the datasheet's, and each entry that differs is marked in its quirks: ANA charges 1 cycle, ANI and ANA M 4,
+ * CZ 5 when not taken and HLT 4, ADC M adds a carry in even when carry is clear, and RST
+ * does nothing with interrupts disabled. Opcodes the 8080 does not define, RIM and SIM included, are taken to read
+ * every flag, so the ROM analysis keeps them all live.
+ * The tables below are built from the specification at compile time. The reference engine's switch in
+ * executeInstructionByOpcode is not, it stays written out by hand as the implementation the specification and the
+ * predecoded handlers are checked against.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_OPCODESPEC_H
+#define INTEL_8080_EMULATOR_OPCODESPEC_H
+
+#include "cpuStructures.h"
+
+#define NUM_OPCODES 256
+#define MAX_MNEMONIC_LENGTH 20
+// Flags, by their bit in ConditionCodes
+#define FLAG_ZERO 0x01
+#define FLAG_SIGN 0x02
+#define FLAG_PARITY 0x04
+#define FLAG_CARRY 0x08
+#define FLAG_AUXILIARY_CARRY 0x10
+#define ALL_FLAGS 0x1f
+#define FLAGS_EXCEPT_CARRY (FLAG_ZERO | FLAG_SIGN | FLAG_PARITY | FLAG_AUXILIARY_CARRY)
+#define NUM_FLAGS 5
+// Quirks, ways in which the reference engine departs from the datasheet
+#define TIMING_QUIRK 0x01
+#define RESULT_QUIRK 0x02
+
+#define OPCODE_SPEC(X) \
+    X(0x00, "NOP",         1,  4,  4, 0, 0, 0, Nop) \
+    X(0x01, "LXI B;D16",   3, 10, 10, 0, 0, 0, LoadPair) \
+    X(0x02, "STAX B",      1,  7,  7, 0, 0, 0, Fallback) \
+    X(0x03, "INX B",       1,  5,  5, 0, 0, 0, IncrementPair) \
+    X(0x04, "INR B",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Increment) \
+    X(0x05, "DCR B",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Decrement) \
+    X(0x06, "MVI B; D8",   2,  7,  7, 0, 0, 0, MoveImmediate) \
+    X(0x07, "RLC",         1,  4,  4, 0, FLAG_CARRY, 0, Fallback) \
+    X(0x08, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0x09, "DAD B",       1, 10, 10, 0, FLAG_CARRY, 0, AddPair) \
+    X(0x0a, "LDAX B",      1,  7,  7, 0, 0, 0, Fallback) \
+    X(0x0b, "DCX B",       1,  5,  5, 0, 0, 0, DecrementPair) \
+    X(0x0c, "INR C",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Increment) \
+    X(0x0d, "DCR C",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Decrement) \
+    X(0x0e, "MVI C;D8",    2,  7,  7, 0, 0, 0, MoveImmediate) \
+    X(0x0f, "RRC",         1,  4,  4, 0, FLAG_CARRY, 0, Fallback) \
+    X(0x10, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0x11, "LXI D;D16",   3, 10, 10, 0, 0, 0, LoadPair) \
+    X(0x12, "STAX D",      1,  7,  7, 0, 0, 0, Fallback) \
+    X(0x13, "INX D",       1,  5,  5, 0, 0, 0, IncrementPair) \
+    X(0x14, "INR D",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Increment) \
+    X(0x15, "DCR D",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Decrement) \
+    X(0x16, "MVI D; D8",   2,  7,  7, 0, 0, 0, MoveImmediate) \
+    X(0x17, "RAL",         1,  4,  4, FLAG_CARRY, FLAG_CARRY, 0, Fallback) \
+    X(0x18, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0x19, "DAD D",       1, 10, 10, 0, FLAG_CARRY, 0, AddPair) \
+    X(0x1a, "LDAX D",      1,  7,  7, 0, 0, 0, Fallback) \
+    X(0x1b, "DCX D",       1,  5,  5, 0, 0, 0, DecrementPair) \
+    X(0x1c, "INR E",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Increment) \
+    X(0x1d, "DCR E",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Decrement) \
+    X(0x1e, "MVI E;D8",    2,  7,  7, 0, 0, 0, MoveImmediate) \
+    X(0x1f, "RAR",         1,  4,  4, FLAG_CARRY, FLAG_CARRY, 0, Fallback) \
+    X(0x20, "RIM",         1,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0x21, "LXI H;D16",   3, 10, 10, 0, 0, 0, LoadPair) \
+    X(0x22, "SHLD adr",    3, 16, 16, 0, 0, 0, Fallback) \
+    X(0x23, "INX H",       1,  5,  5, 0, 0, 0, IncrementPair) \
+    X(0x24, "INR H",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Increment) \
+    X(0x25, "DCR H",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Decrement) \
+    X(0x26, "MVI H;D8",    2,  7,  7, 0, 0, 0, MoveImmediate) \
+    X(0x27, "DAA",         1,  4,  4, FLAG_CARRY|FLAG_AUXILIARY_CARRY, ALL_FLAGS, 0, DecimalAdjust) \
+    X(0x28, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0x29, "DAD H",       1, 10, 10, 0, FLAG_CARRY, 0, AddPair) \
+    X(0x2a, "LHLD adr",    3, 16, 16, 0, 0, 0, Fallback) \
+    X(0x2b, "DCX H",       1,  5,  5, 0, 0, 0, DecrementPair) \
+    X(0x2c, "INR L",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Increment) \
+    X(0x2d, "DCR L",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Decrement) \
+    X(0x2e, "MVI L; D8",   2,  7,  7, 0, 0, 0, MoveImmediate) \
+    X(0x2f, "CMA",         1,  4,  4, 0, 0, 0, Fallback) \
+    X(0x30, "SIM",         1,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0x31, "LXI SP; D16", 3, 10, 10, 0, 0, 0, Fallback) \
+    X(0x32, "STA adr",     3, 13, 13, 0, 0, 0, Fallback) \
+    X(0x33, "INX SP",      1,  5,  5, 0, 0, 0, Fallback) \
+    X(0x34, "INR M",       1, 10, 10, 0, FLAGS_EXCEPT_CARRY, 0, Fallback) \
+    X(0x35, "DCR M",       1, 10, 10, 0, FLAGS_EXCEPT_CARRY, 0, Fallback) \
+    X(0x36, "MVI M;D8",    2, 10, 10, 0, 0, 0, Fallback) \
+    X(0x37, "STC",         1,  4,  4, 0, FLAG_CARRY, 0, Fallback) \
+    X(0x38, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0x39, "DAD SP",      1, 10, 10, 0, FLAG_CARRY, 0, Fallback) \
+    X(0x3a, "LDA adr",     3, 13, 13, 0, 0, 0, Fallback) \
+    X(0x3b, "DCX SP",      1,  5,  5, 0, 0, 0, Fallback) \
+    X(0x3c, "INR A",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Increment) \
+    X(0x3d, "DCR A",       1,  5,  5, 0, FLAGS_EXCEPT_CARRY, 0, Decrement) \
+    X(0x3e, "MVI A;D8",    2,  7,  7, 0, 0, 0, MoveImmediate) \
+    X(0x3f, "CMC",         1,  4,  4, FLAG_CARRY, FLAG_CARRY, 0, Fallback) \
+    X(0x40, "MOV B;B",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x41, "MOV B;C",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x42, "MOV B;D",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x43, "MOV B;E",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x44, "MOV B;H",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x45, "MOV B;L",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x46, "MOV B;M",     1,  7,  7, 0, 0, 0, MoveFromMemory) \
+    X(0x47, "MOV B;A",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x48, "MOV C;B",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x49, "MOV C;C",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x4a, "MOV C;D",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x4b, "MOV C;E",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x4c, "MOV C;H",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x4d, "MOV C;L",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x4e, "MOV C;M",     1,  7,  7, 0, 0, 0, MoveFromMemory) \
+    X(0x4f, "MOV C;A",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x50, "MOV D;B",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x51, "MOV D;C",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x52, "MOV D;D",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x53, "MOV D;E",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x54, "MOV D;H",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x55, "MOV D;L",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x56, "MOV D;M",     1,  7,  7, 0, 0, 0, MoveFromMemory) \
+    X(0x57, "MOV D;A",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x58, "MOV E;B",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x59, "MOV E;C",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x5a, "MOV E;D",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x5b, "MOV E;E",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x5c, "MOV E;H",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x5d, "MOV E;L",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x5e, "MOV E;M",     1,  7,  7, 0, 0, 0, MoveFromMemory) \
+    X(0x5f, "MOV E;A",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x60, "MOV H;B",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x61, "MOV H;C",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x62, "MOV H;D",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x63, "MOV H;E",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x64, "MOV H;H",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x65, "MOV H;L",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x66, "MOV H;M",     1,  7,  7, 0, 0, 0, MoveFromMemory) \
+    X(0x67, "MOV H;A",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x68, "MOV L;B",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x69, "MOV L;C",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x6a, "MOV L;D",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x6b, "MOV L;E",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x6c, "MOV L;H",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x6d, "MOV L;L",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x6e, "MOV L;M",     1,  7,  7, 0, 0, 0, MoveFromMemory) \
+    X(0x6f, "MOV L;A",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x70, "MOV M;B",     1,  7,  7, 0, 0, 0, MoveToMemory) \
+    X(0x71, "MOV M;C",     1,  7,  7, 0, 0, 0, MoveToMemory) \
+    X(0x72, "MOV M;D",     1,  7,  7, 0, 0, 0, MoveToMemory) \
+    X(0x73, "MOV M;E",     1,  7,  7, 0, 0, 0, MoveToMemory) \
+    X(0x74, "MOV M;H",     1,  7,  7, 0, 0, 0, MoveToMemory) \
+    X(0x75, "MOV M;L",     1,  7,  7, 0, 0, 0, MoveToMemory) \
+    X(0x76, "HLT",         1,  4,  4, 0, 0, TIMING_QUIRK, Fallback) \
+    X(0x77, "MOV M;A",     1,  7,  7, 0, 0, 0, MoveToMemory) \
+    X(0x78, "MOV A;B",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x79, "MOV A;C",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x7a, "MOV A;D",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x7b, "MOV A;E",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x7c, "MOV A;H",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x7d, "MOV A;L",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x7e, "MOV A;M",     1,  7,  7, 0, 0, 0, MoveFromMemory) \
+    X(0x7f, "MOV A;A",     1,  5,  5, 0, 0, 0, MoveRegister) \
+    X(0x80, "ADD B",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x81, "ADD C",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x82, "ADD D",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x83, "ADD E",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x84, "ADD H",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x85, "ADD L",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x86, "ADD M",       1,  7,  7, 0, ALL_FLAGS, 0, AluMemory) \
+    X(0x87, "ADD A",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x88, "ADC B",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x89, "ADC C",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x8a, "ADC D",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x8b, "ADC E",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x8c, "ADC H",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x8d, "ADC L",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x8e, "ADC M",       1,  7,  7, FLAG_CARRY, ALL_FLAGS, RESULT_QUIRK, Fallback) \
+    X(0x8f, "ADC A",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x90, "SUB B",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x91, "SUB C",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x92, "SUB D",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x93, "SUB E",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x94, "SUB H",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x95, "SUB L",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x96, "SUB M",       1,  7,  7, 0, ALL_FLAGS, 0, AluMemory) \
+    X(0x97, "SUB A",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0x98, "SBB B",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x99, "SBB C",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x9a, "SBB D",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x9b, "SBB E",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x9c, "SBB H",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x9d, "SBB L",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0x9e, "SBB M",       1,  7,  7, FLAG_CARRY, ALL_FLAGS, 0, AluMemory) \
+    X(0x9f, "SBB A",       1,  4,  4, FLAG_CARRY, ALL_FLAGS, 0, AluRegister) \
+    X(0xa0, "ANA B",       1,  1,  1, 0, ALL_FLAGS, TIMING_QUIRK, AluRegister) \
+    X(0xa1, "ANA C",       1,  1,  1, 0, ALL_FLAGS, TIMING_QUIRK, AluRegister) \
+    X(0xa2, "ANA D",       1,  1,  1, 0, ALL_FLAGS, TIMING_QUIRK, AluRegister) \
+    X(0xa3, "ANA E",       1,  1,  1, 0, ALL_FLAGS, TIMING_QUIRK, AluRegister) \
+    X(0xa4, "ANA H",       1,  1,  1, 0, ALL_FLAGS, TIMING_QUIRK, AluRegister) \
+    X(0xa5, "ANA L",       1,  1,  1, 0, ALL_FLAGS, TIMING_QUIRK, AluRegister) \
+    X(0xa6, "ANA M",       1,  4,  4, 0, ALL_FLAGS, TIMING_QUIRK, AluMemory) \
+    X(0xa7, "ANA A",       1,  1,  1, 0, ALL_FLAGS, TIMING_QUIRK, AluRegister) \
+    X(0xa8, "XRA B",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xa9, "XRA C",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xaa, "XRA D",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xab, "XRA E",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xac, "XRA H",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xad, "XRA L",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xae, "XRA M",       1,  7,  7, 0, ALL_FLAGS, 0, AluMemory) \
+    X(0xaf, "XRA A",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb0, "ORA B",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb1, "ORA C",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb2, "ORA D",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb3, "ORA E",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb4, "ORA H",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb5, "ORA L",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb6, "ORA M",       1,  7,  7, 0, ALL_FLAGS, 0, AluMemory) \
+    X(0xb7, "ORA A",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb8, "CMP B",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xb9, "CMP C",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xba, "CMP D",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xbb, "CMP E",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xbc, "CMP H",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xbd, "CMP L",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xbe, "CMP M",       1,  7,  7, 0, ALL_FLAGS, 0, AluMemory) \
+    X(0xbf, "CMP A",       1,  4,  4, 0, ALL_FLAGS, 0, AluRegister) \
+    X(0xc0, "RNZ",         1, 11,  5, FLAG_ZERO, 0, 0, ConditionalReturn) \
+    X(0xc1, "POP B",       1, 10, 10, 0, 0, 0, Pop) \
+    X(0xc2, "JNZ adr",     3, 10, 10, FLAG_ZERO, 0, 0, ConditionalJump) \
+    X(0xc3, "JMP adr",     3, 10, 10, 0, 0, 0, Jump) \
+    X(0xc4, "CNZ adr",     3, 17, 11, FLAG_ZERO, 0, 0, ConditionalCall) \
+    X(0xc5, "PUSH B",      1, 11, 11, 0, 0, 0, Push) \
+    X(0xc6, "ADI D8",      2,  7,  7, 0, ALL_FLAGS, 0, AluImmediate) \
+    X(0xc7, "RST 0",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart) \
+    X(0xc8, "RZ",          1, 11,  5, FLAG_ZERO, 0, 0, ConditionalReturn) \
+    X(0xc9, "RET",         1, 10, 10, 0, 0, 0, Return) \
+    X(0xca, "JZ adr",      3, 10, 10, FLAG_ZERO, 0, 0, ConditionalJump) \
+    X(0xcb, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0xcc, "CZ adr",      3, 17,  5, FLAG_ZERO, 0, TIMING_QUIRK, ConditionalCall) \
+    X(0xcd, "CALL adr",    3, 17, 17, 0, 0, 0, Call) \
+    X(0xce, "ACI D8",      2,  7,  7, FLAG_CARRY, ALL_FLAGS, 0, AluImmediate) \
+    X(0xcf, "RST 1",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart) \
+    X(0xd0, "RNC",         1, 11,  5, FLAG_CARRY, 0, 0, ConditionalReturn) \
+    X(0xd1, "POP D",       1, 10, 10, 0, 0, 0, Pop) \
+    X(0xd2, "JNC adr",     3, 10, 10, FLAG_CARRY, 0, 0, ConditionalJump) \
+    X(0xd3, "OUT D8",      2, 10, 10, 0, 0, 0, Fallback) \
+    X(0xd4, "CNC adr",     3, 17, 11, FLAG_CARRY, 0, 0, ConditionalCall) \
+    X(0xd5, "PUSH D",      1, 11, 11, 0, 0, 0, Push) \
+    X(0xd6, "SUI D8",      2,  7,  7, 0, ALL_FLAGS, 0, AluImmediate) \
+    X(0xd7, "RST 2",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart) \
+    X(0xd8, "RC",          1, 11,  5, FLAG_CARRY, 0, 0, ConditionalReturn) \
+    X(0xd9, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0xda, "JC adr",      3, 10, 10, FLAG_CARRY, 0, 0, ConditionalJump) \
+    X(0xdb, "IN D8",       2, 10, 10, 0, 0, 0, Fallback) \
+    X(0xdc, "CC adr",      3, 17, 11, FLAG_CARRY, 0, 0, ConditionalCall) \
+    X(0xdd, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0xde, "SBI D8",      2,  7,  7, FLAG_CARRY, ALL_FLAGS, 0, AluImmediate) \
+    X(0xdf, "RST 3",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart) \
+    X(0xe0, "RPO",         1, 11,  5, FLAG_PARITY, 0, 0, ConditionalReturn) \
+    X(0xe1, "POP H",       1, 10, 10, 0, 0, 0, Pop) \
+    X(0xe2, "JPO adr",     3, 10, 10, FLAG_PARITY, 0, 0, ConditionalJump) \
+    X(0xe3, "XTHL",        1, 18, 18, 0, 0, 0, Fallback) \
+    X(0xe4, "CPO adr",     3, 17, 11, FLAG_PARITY, 0, 0, ConditionalCall) \
+    X(0xe5, "PUSH H",      1, 11, 11, 0, 0, 0, Push) \
+    X(0xe6, "ANI D8",      2,  4,  4, 0, ALL_FLAGS, TIMING_QUIRK, AluImmediate) \
+    X(0xe7, "RST 4",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart) \
+    X(0xe8, "RPE",         1, 11,  5, FLAG_PARITY, 0, 0, ConditionalReturn) \
+    X(0xe9, "PCHL",        1,  5,  5, 0, 0, 0, Fallback) \
+    X(0xea, "JPE adr",     3, 10, 10, FLAG_PARITY, 0, 0, ConditionalJump) \
+    X(0xeb, "XCHG",        1,  4,  4, 0, 0, 0, Fallback) \
+    X(0xec, "CPE adr",     3, 17, 11, FLAG_PARITY, 0, 0, ConditionalCall) \
+    X(0xed, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0xee, "XRI D8",      2,  7,  7, 0, ALL_FLAGS, 0, AluImmediate) \
+    X(0xef, "RST 5",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart) \
+    X(0xf0, "RP",          1, 11,  5, FLAG_SIGN, 0, 0, ConditionalReturn) \
+    X(0xf1, "POP PSW",     1, 10, 10, 0, ALL_FLAGS, 0, Fallback) \
+    X(0xf2, "JP adr",      3, 10, 10, FLAG_SIGN, 0, 0, ConditionalJump) \
+    X(0xf3, "DI",          1,  4,  4, 0, 0, 0, Fallback) \
+    X(0xf4, "CP adr",      3, 17, 11, FLAG_SIGN, 0, 0, ConditionalCall) \
+    X(0xf5, "PUSH PSW",    1, 11, 11, ALL_FLAGS, 0, 0, Fallback) \
+    X(0xf6, "ORI D8",      2,  7,  7, 0, ALL_FLAGS, 0, AluImmediate) \
+    X(0xf7, "RST 6",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart) \
+    X(0xf8, "RM",          1, 11,  5, FLAG_SIGN, 0, 0, ConditionalReturn) \
+    X(0xf9, "SPHL",        1,  5,  5, 0, 0, 0, Fallback) \
+    X(0xfa, "JM adr",      3, 10, 10, FLAG_SIGN, 0, 0, ConditionalJump) \
+    X(0xfb, "EI",          1,  4,  4, 0, 0, 0, Fallback) \
+    X(0xfc, "CM adr",      3, 17, 11, FLAG_SIGN, 0, 0, ConditionalCall) \
+    X(0xfd, "-",           0,  4,  4, ALL_FLAGS, 0, 0, Fallback) \
+    X(0xfe, "CPI D8",      2,  7,  7, 0, ALL_FLAGS, 0, AluImmediate) \
+    X(0xff, "RST 7",       1, 11,  0, 0, 0, RESULT_QUIRK|TIMING_QUIRK, Restart)
+
+extern const char instructions[NUM_OPCODES][MAX_MNEMONIC_LENGTH];  /**< Mnemonic of each opcode */
+extern const char instructionSizes[NUM_OPCODES];
+extern const uint8_t instructionCycles[NUM_OPCODES];
+extern const uint8_t instructionCyclesNotTaken[NUM_OPCODES];
+extern const uint8_t instructionFlagsRead[NUM_OPCODES];
+extern const uint8_t instructionFlagsWritten[NUM_OPCODES];
+extern const uint8_t instructionQuirks[NUM_OPCODES];
+
+#endif //INTEL_8080_EMULATOR_OPCODESPEC_H
@@ -0,0 +1,471 @@
+/***********************************************************************************
+ *
+ * Source for the execution profiler, only compiled in with CPU_PROFILE
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "profiler.h"
+
+#ifdef CPU_PROFILE
+
+#include "shell8080.h"
+#include "helpers.h"
+#include "symbolMap.h"
+#include "opcodeSpec.h"
+#include <math.h>
+
+#define PROFILE_ROOT_ROUTINE 0x10000
+#define PROFILE_MAX_DEPTH 256  // Deeper calls are attributed to the deepest frame kept
+#define INITIAL_CALL_NODES 1024
+
+/**
+ * Executions and cycles counted for one opcode or address
+ */
+typedef struct ProfileCounter{
+    uint64_t executions;
+    uint64_t cycles;
+} ProfileCounter;
+
+/**
+ * Cycles spent in one routine, as a whole
+ */
+typedef struct RoutineProfile{
+    uint64_t calls;
+    uint64_t inclusiveCycles;  /**< Including the routines it called */
+    uint64_t exclusiveCycles;  /**< Excluding the routines it called */
+    uint32_t activeFrames;  /**< Frames of the routine on the shadow stack, only the outermost counts inclusive cycles */
+} RoutineProfile;
+
+/**
+ * A node of the call tree, one per distinct call stack
+ */
+typedef struct CallNode{
+    uint32_t routine;  /**< Address of the routine, PROFILE_ROOT_ROUTINE for code outside of any call */
+    uint32_t parent;
+    uint32_t firstChild;  /**< 0 for none, as the root is never a child */
+    uint32_t nextSibling;
+    uint64_t cycles;  /**< Exclusive cycles spent with this call stack */
+} CallNode;
+
+/**
+ * A routine being run, on the shadow call stack
+ */
+typedef struct CallFrame{
+    uint32_t node;
+    uint16_t returnStackPointer;  /**< SP before the call, the frame has returned once SP is back up to it */
+    uint64_t startCycles;  /**< Total cycles when the routine was called */
+} CallFrame;
+
+/**
+ * Everything counted since profiling started
+ */
+typedef struct Profile{
+    ProfileCounter opcodes[256];
+    ProfileCounter addresses[MEMORY_SIZE_8080];
+    uint64_t totalCycles;  /**< Including interrupts */
+    RoutineProfile routines[MEMORY_SIZE_8080];
+    CallNode *nodes;
+    uint32_t numNodes;
+    uint32_t maxNodes;
+    CallFrame frames[PROFILE_MAX_DEPTH];
+    uint32_t depth;  /**< Frames on the shadow stack */
+    uint32_t currentNode;
+    SymbolMap *symbols;  /**< NULL if there is no symbol file */
+    uint8_t *memory;  /**< ROM being profiled, for disassembly */
+    bool started;
+} Profile;
+
+Profile profile;
+volatile sig_atomic_t profileRequested = 0;  // Set by the signal handler, the reports are written by the emulator thread
+
+void enterRoutine(uint16_t routine, uint16_t returnStackPointer);
+void leaveRoutines(uint16_t stackPointer);
+uint32_t findChildNode(uint32_t parent, uint32_t routine);
+int writeRoutineReport(double percentPerCycle);
+int writeFoldedStacks();
+void writeStackName(FILE *file, uint32_t node);
+const char *getRoutineName(uint32_t routine, char *buffer, size_t bufferSize);
+void writeProfileAtExit();
+void handleProfileSignal(int signalNum);
+int compareCounterCycles(const void *first, const void *second);
+void sortCounters(const ProfileCounter *counters, unsigned int numCounters, uint32_t *order);
+
+void initializeProfiler(const uint8_t *romImage)
+{
+    if(!profile.started){
+        profile.memory = mallocSet(MEMORY_SIZE_8080);
+        profile.maxNodes = INITIAL_CALL_NODES;
+        profile.nodes = mallocSet(profile.maxNodes*sizeof(CallNode));
+        profile.nodes[0].routine = PROFILE_ROOT_ROUTINE;
+        profile.numNodes = 1;
+        profile.symbols = loadSymbolMap(DEFAULT_SYMBOL_PATH);
+        atexit(writeProfileAtExit);
+        signal(PROFILE_SIGNAL, handleProfileSignal);
+        profile.started = true;
+    }
+    memcpy(profile.memory, romImage, ROM_LIMIT_8080);
+}
+
+void recordProfiledInstruction(uint16_t address, uint8_t opcode, uint16_t startStackPointer, unsigned int cycles,
+                               const State8080 *state)
+{
+    profile.opcodes[opcode].executions++;
+    profile.opcodes[opcode].cycles += cycles;
+    profile.addresses[address].executions++;
+    profile.addresses[address].cycles += cycles;
+
+    // A call's own cycles belong to the caller, a return's to the routine returning
+    profile.totalCycles += cycles;
+    profile.nodes[profile.currentNode].cycles += cycles;
+    if(profile.nodes[profile.currentNode].routine != PROFILE_ROOT_ROUTINE){
+        profile.routines[profile.nodes[profile.currentNode].routine].exclusiveCycles += cycles;
+    }
+    // CALL, Ccc and RST push the return address, and are only taken if they did
+    bool isCall = (opcode == 0xcd) || ((opcode & 0xc7) == 0xc4) || ((opcode & 0xc7) == 0xc7);
+    if(isCall && state->sp == (uint16_t)(startStackPointer-2)){
+        enterRoutine(state->pc, startStackPointer);
+    }else if(state->sp > startStackPointer){
+        leaveRoutines(state->sp);
+    }
+
+    if(profileRequested){
+        profileRequested = 0;
+        writeProfile();
+    }
+}
+
+void recordProfiledInterrupt(uint16_t startStackPointer, unsigned int cycles, const State8080 *state)
+{
+    if(state->sp != (uint16_t)(startStackPointer-2)){
+        return;  // Interrupts were disabled
+    }
+    enterRoutine(state->pc, startStackPointer);
+    profile.totalCycles += cycles;
+    profile.nodes[profile.currentNode].cycles += cycles;
+    profile.routines[state->pc].exclusiveCycles += cycles;
+}
+
+int writeProfile()
+{
+    uint32_t *order = mallocSet(MEMORY_SIZE_8080*sizeof(uint32_t));
+    uint64_t totalCycles = 0;
+    uint64_t maxAddressCycles = 0;
+    for(unsigned int opcode = 0; opcode < 256; opcode++){
+        totalCycles += profile.opcodes[opcode].cycles;
+    }
+    for(unsigned int address = 0; address < MEMORY_SIZE_8080; address++){
+        if(profile.addresses[address].cycles > maxAddressCycles){
+            maxAddressCycles = profile.addresses[address].cycles;
+        }
+    }
+    double percentPerCycle = (totalCycles > 0) ? 100.0/(double)totalCycles : 0;
+    int success = 1;
+
+    FILE *opcodeFile = fopen(PROFILE_OPCODES_FILE, "w");
+    if(opcodeFile == NULL){
+        logger("Failed to open %s for writing\n", PROFILE_OPCODES_FILE);
+        success = 0;
+    }else{
+        sortCounters(profile.opcodes, 256, order);
+        fprintf(opcodeFile, "%-6s  %-12s  %14s  %14s  %7s  %11s\n",
+                "opcode", "mnemonic", "executions", "cycles", "cycles%", "cycles/exec");
+        for(unsigned int rank = 0; rank < 256 && profile.opcodes[order[rank]].executions > 0; rank++){
+            const ProfileCounter *counter = &(profile.opcodes[order[rank]]);
+            fprintf(opcodeFile, "0x%02x    %-12s  %14llu  %14llu  %7.3f  %11.2f\n",
+                    order[rank], instructions[order[rank]],
+                    (unsigned long long)counter->executions, (unsigned long long)counter->cycles,
+                    (double)counter->cycles*percentPerCycle, (double)counter->cycles/(double)counter->executions);
+        }
+        fclose(opcodeFile);
+    }
+
+    FILE *addressFile = fopen(PROFILE_ADDRESSES_FILE, "w");
+    if(addressFile == NULL){
+        logger("Failed to open %s for writing\n", PROFILE_ADDRESSES_FILE);
+        success = 0;
+    }else{
+        sortCounters(profile.addresses, MEMORY_SIZE_8080, order);
+        State8080 rom = {0};
+        rom.memory = profile.memory;
+        char assembly[32];
+        char label[SYMBOL_NAME_LENGTH+8];
+        fprintf(addressFile, "%-7s  %14s  %14s  %7s  %-24s  %s\n",
+                "address", "executions", "cycles", "cycles%", "symbol", "instruction");
+        for(unsigned int rank = 0; rank < MEMORY_SIZE_8080 && profile.addresses[order[rank]].executions > 0; rank++){
+            const ProfileCounter *counter = &(profile.addresses[order[rank]]);
+            disassembleInstruction(&rom, (uint16_t)order[rank], assembly, sizeof(assembly));
+            formatSymbolAddress(profile.symbols, (uint16_t)order[rank], label, sizeof(label));
+            fprintf(addressFile, "0x%04x   %14llu  %14llu  %7.3f  %-24s  %s\n",
+                    order[rank], (unsigned long long)counter->executions, (unsigned long long)counter->cycles,
+                    (double)counter->cycles*percentPerCycle, label, assembly);
+        }
+        fclose(addressFile);
+    }
+
+    FILE *heatFile = fopen(PROFILE_HEAT_FILE, "wb");
+    if(heatFile == NULL){
+        logger("Failed to open %s for writing\n", PROFILE_HEAT_FILE);
+        success = 0;
+    }else{
+        // A log scale keeps the rarely run routines visible next to the hot loops
+        uint8_t *heat = (uint8_t *)order;
+        double scale = (maxAddressCycles > 0) ? 255.0/log1p((double)maxAddressCycles) : 0;
+        for(unsigned int address = 0; address < MEMORY_SIZE_8080; address++){
+            uint64_t cycles = profile.addresses[address].cycles;
+            heat[address] = (cycles == 0) ? 0 : (uint8_t)(1+(254.0/255.0)*scale*log1p((double)cycles));
+        }
+        if(fwrite(heat, 1, MEMORY_SIZE_8080, heatFile) != MEMORY_SIZE_8080){
+            logger("Failed to write %s\n", PROFILE_HEAT_FILE);
+            success = 0;
+        }
+        fclose(heatFile);
+    }
+
+    free(order);
+    if(writeRoutineReport((profile.totalCycles > 0) ? 100.0/(double)profile.totalCycles : 0) == 0){
+        success = 0;
+    }
+    if(writeFoldedStacks() == 0){
+        success = 0;
+    }
+    logger("Profile of %llu cycles written to %s, %s, %s, %s and %s\n", (unsigned long long)totalCycles,
+           PROFILE_OPCODES_FILE, PROFILE_ADDRESSES_FILE, PROFILE_HEAT_FILE, PROFILE_ROUTINES_FILE, PROFILE_STACKS_FILE);
+    return success;
+}
+
+/**
+ * Pushes a frame for a routine that was just called
+ * @param routine - Address of the routine
+ * @param returnStackPointer - SP before the call
+ */
+void enterRoutine(uint16_t routine, uint16_t returnStackPointer)
+{
+    profile.routines[routine].calls++;
+    if(profile.depth == PROFILE_MAX_DEPTH){
+        return;
+    }
+
+    CallFrame *frame = &(profile.frames[profile.depth]);
+    frame->node = findChildNode(profile.currentNode, routine);
+    frame->returnStackPointer = returnStackPointer;
+    frame->startCycles = profile.totalCycles;
+    profile.routines[routine].activeFrames++;
+    profile.currentNode = frame->node;
+    profile.depth++;
+}
+
+/**
+ * Pops the frames of every routine that has returned, whether through RET or by moving SP
+ * @param stackPointer - SP now
+ */
+void leaveRoutines(uint16_t stackPointer)
+{
+    while(profile.depth > 0 && stackPointer >= profile.frames[profile.depth-1].returnStackPointer){
+        profile.depth--;
+        CallFrame *frame = &(profile.frames[profile.depth]);
+        RoutineProfile *routine = &(profile.routines[profile.nodes[frame->node].routine]);
+        routine->activeFrames--;
+        if(routine->activeFrames == 0){
+            routine->inclusiveCycles += profile.totalCycles-frame->startCycles;
+        }
+        profile.currentNode = profile.nodes[frame->node].parent;
+    }
+}
+
+/**
+ * Finds the call tree node for a routine called from another node, adding it if it is the first such call
+ * @param parent - Node of the caller
+ * @param routine - Address of the routine called
+ * @return - Index of the node
+ */
+uint32_t findChildNode(uint32_t parent, uint32_t routine)
+{
+    uint32_t child = profile.nodes[parent].firstChild;
+    while(child != 0){
+        if(profile.nodes[child].routine == routine){
+            return child;
+        }
+        child = profile.nodes[child].nextSibling;
+    }
+
+    if(profile.numNodes == profile.maxNodes){
+        profile.maxNodes *= 2;
+        profile.nodes = realloc(profile.nodes, profile.maxNodes*sizeof(CallNode));
+        if(profile.nodes == NULL){
+            logger("Failed to grow the call tree\n");
+            exit(1);
+        }
+    }
+    child = profile.numNodes;
+    profile.numNodes++;
+    CallNode *node = &(profile.nodes[child]);
+    node->routine = routine;
+    node->parent = parent;
+    node->firstChild = 0;
+    node->nextSibling = profile.nodes[parent].firstChild;
+    node->cycles = 0;
+    profile.nodes[parent].firstChild = child;
+
+    return child;
+}
+
+/**
+ * Writes the calls, inclusive and exclusive cycles of every routine called, most inclusive cycles first
+ * @param percentPerCycle - Percentage of all cycles one cycle is
+ * @return int - 1 if the report was written, 0 otherwise
+ */
+int writeRoutineReport(double percentPerCycle)
+{
+    FILE *routineFile = fopen(PROFILE_ROUTINES_FILE, "w");
+    if(routineFile == NULL){
+        logger("Failed to open %s for writing\n", PROFILE_ROUTINES_FILE);
+        return 0;
+    }
+
+    // Routines still running have their cycles so far included, without changing the profile
+    ProfileCounter *inclusive = mallocSet(MEMORY_SIZE_8080*sizeof(ProfileCounter));
+    for(uint32_t routine = 0; routine < MEMORY_SIZE_8080; routine++){
+        inclusive[routine].executions = profile.routines[routine].calls;
+        inclusive[routine].cycles = profile.routines[routine].inclusiveCycles;
+    }
+    for(uint32_t frameNum = 0; frameNum < profile.depth; frameNum++){
+        const CallFrame *frame = &(profile.frames[frameNum]);
+        uint32_t routine = profile.nodes[frame->node].routine;
+        bool outermost = true;
+        for(uint32_t outerFrameNum = 0; outerFrameNum < frameNum; outerFrameNum++){
+            if(profile.nodes[profile.frames[outerFrameNum].node].routine == routine){
+                outermost = false;
+            }
+        }
+        if(outermost){
+            inclusive[routine].cycles += profile.totalCycles-frame->startCycles;
+        }
+    }
+
+    uint32_t *order = mallocSet(MEMORY_SIZE_8080*sizeof(uint32_t));
+    sortCounters(inclusive, MEMORY_SIZE_8080, order);
+    char name[SYMBOL_NAME_LENGTH+8];
+    fprintf(routineFile, "%-7s  %-24s  %12s  %14s  %8s  %14s  %8s\n",
+            "routine", "name", "calls", "inclusive", "incl%", "exclusive", "excl%");
+    for(uint32_t rank = 0; rank < MEMORY_SIZE_8080 && inclusive[order[rank]].executions > 0; rank++){
+        uint32_t routine = order[rank];
+        fprintf(routineFile, "0x%04x   %-24s  %12llu  %14llu  %8.3f  %14llu  %8.3f\n",
+                routine, getRoutineName(routine, name, sizeof(name)),
+                (unsigned long long)inclusive[routine].executions, (unsigned long long)inclusive[routine].cycles,
+                (double)inclusive[routine].cycles*percentPerCycle,
+                (unsigned long long)profile.routines[routine].exclusiveCycles,
+                (double)profile.routines[routine].exclusiveCycles*percentPerCycle);
+    }
+    fprintf(routineFile, "Outside of any call: %llu cycles (%.3f%%)\n", (unsigned long long)profile.nodes[0].cycles,
+            (double)profile.nodes[0].cycles*percentPerCycle);
+
+    free(order);
+    free(inclusive);
+    fclose(routineFile);
+    return 1;
+}
+
+/**
+ * Writes the cycles of every call stack as a line of semicolon separated routine names and a count
+ * @return int - 1 if the stacks were written, 0 otherwise
+ */
+int writeFoldedStacks()
+{
+    FILE *stackFile = fopen(PROFILE_STACKS_FILE, "w");
+    if(stackFile == NULL){
+        logger("Failed to open %s for writing\n", PROFILE_STACKS_FILE);
+        return 0;
+    }
+
+    // Children are always added after their parents, so every node can be written in index order
+    for(uint32_t node = 0; node < profile.numNodes; node++){
+        if(profile.nodes[node].cycles > 0){
+            writeStackName(stackFile, node);
+            fprintf(stackFile, " %llu\n", (unsigned long long)profile.nodes[node].cycles);
+        }
+    }
+
+    fclose(stackFile);
+    return 1;
+}
+
+/**
+ * Writes the names of the routines on a call stack, outermost first
+ */
+void writeStackName(FILE *file, uint32_t node)
+{
+    char name[SYMBOL_NAME_LENGTH+8];
+    if(node != 0){
+        writeStackName(file, profile.nodes[node].parent);
+        fputc(';', file);
+    }
+    fputs(getRoutineName(profile.nodes[node].routine, name, sizeof(name)), file);
+}
+
+/**
+ * @param routine - Address of the routine, or PROFILE_ROOT_ROUTINE
+ * @param buffer - Space for a generated name
+ * @param bufferSize - Size of the buffer
+ * @return - Name of the routine from the symbol file, or one made from its address
+ */
+const char *getRoutineName(uint32_t routine, char *buffer, size_t bufferSize)
+{
+    if(routine == PROFILE_ROOT_ROUTINE){
+        return "main";
+    }
+
+    // Only a symbol starting at the routine names it, a call into the middle of a symbol is most likely a routine without one
+    const RomSymbol *symbol = findSymbol(profile.symbols, (uint16_t)routine);
+    if(symbol != NULL && symbol->address == routine){
+        snprintf(buffer, bufferSize, "%s", symbol->name);
+    }else{
+        snprintf(buffer, bufferSize, "sub_%04x", routine);
+    }
+    return buffer;
+}
+
+void writeProfileAtExit()
+{
+    writeProfile();
+}
+
+/**
+ * Only flags the request, as files cannot be written safely from a signal handler
+ */
+void handleProfileSignal(int signalNum)
+{
+    profileRequested = 1;
+    signal(signalNum, handleProfileSignal);  // Some platforms reset the handler once it has run
+}
+
+// Counters being sorted by compareCounterCycles
+const ProfileCounter *sortedCounters;
+
+int compareCounterCycles(const void *first, const void *second)
+{
+    uint64_t firstCycles = sortedCounters[*(const uint32_t *)first].cycles;
+    uint64_t secondCycles = sortedCounters[*(const uint32_t *)second].cycles;
+    if(firstCycles != secondCycles){
+        return (firstCycles > secondCycles) ? -1 : 1;
+    }
+    // Ties keep numeric order
+    return (*(const uint32_t *)first < *(const uint32_t *)second) ? -1 : 1;
+}
+
+/**
+ * Orders counters by cycles, most first
+ * @param counters - The counters
+ * @param numCounters - Number of counters
+ * @param order - Set to the counter indexes in sorted order
+ */
+void sortCounters(const ProfileCounter *counters, unsigned int numCounters, uint32_t *order)
+{
+    for(uint32_t index = 0; index < numCounters; index++){
+        order[index] = index;
+    }
+    sortedCounters = counters;
+    qsort(order, numCounters, sizeof(uint32_t), compareCounterCycles);
+}
+
+#endif //CPU_PROFILE
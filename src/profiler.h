@@ -0,0 +1,107 @@
+/***********************************************************************************
+ *
+ * Header for the execution profiler.
+ *
+ * When the core is compiled with CPU_PROFILE defined, every instruction run through a
+ * CPU engine is counted, along with the cycles it took, both by opcode and by address.
+ * CALLs, RSTs and the RSTs of interrupts are also followed on a shadow call stack, which
+ * is unwound whenever SP rises back above a frame's return address, so that the cycles
+ * can be attributed to the guest routines they were spent in. The reports are written
+ * when the program exits, and whenever PROFILE_SIGNAL is received:
+ * - profile_opcodes.txt: executions and cycles of every opcode, most cycles first
+ * - profile_addresses.txt: executions and cycles at every address, most cycles first
+ * - profile_heat.bin: one byte per address of the 64 KB address space, 0 for never
+ *   executed and up to 255 for the most cycles, on a log scale
+ * - profile_routines.txt: calls, inclusive and exclusive cycles of every routine called,
+ *   most inclusive cycles first
+ * - profile_stacks.folded: cycles of every call stack, in the folded format read by
+ *   flame graph tools
+ * Routines are named from the symbol map at DEFAULT_SYMBOL_PATH, if there is one there.
+ * Interrupts are only counted in the call graph reports. Only one CPU should be run per
+ * profiled process.
+ * Without CPU_PROFILE the profiling macros compile to nothing.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_PROFILER_H
+#define INTEL_8080_EMULATOR_PROFILER_H
+
+#include "cpuStructures.h"
+
+#ifdef CPU_PROFILE
+
+#include <signal.h>
+
+// Windows has no user signals, Ctrl+Break is used there instead
+#ifdef SIGUSR1
+#define PROFILE_SIGNAL SIGUSR1
+#else
+#define PROFILE_SIGNAL SIGBREAK
+#endif
+#define PROFILE_OPCODES_FILE "profile_opcodes.txt"
+#define PROFILE_ADDRESSES_FILE "profile_addresses.txt"
+#define PROFILE_HEAT_FILE "profile_heat.bin"
+#define PROFILE_ROUTINES_FILE "profile_routines.txt"
+#define PROFILE_STACKS_FILE "profile_stacks.folded"
+
+/**
+ * Starts profiling, the reports are written at exit from then on.
+ * ROM is kept to disassemble the profiled addresses with, later calls replace it.
+ * @param romImage - ROM_LIMIT_8080 bytes of ROM being run
+ */
+void initializeProfiler(const uint8_t *romImage);
+
+/**
+ * Counts an executed instruction
+ * @param address - Address the instruction was executed at
+ * @param opcode - The instruction's opcode
+ * @param startStackPointer - SP before the instruction
+ * @param cycles - Cycles the instruction took
+ * @param state - The 8080 state after the instruction
+ */
+void recordProfiledInstruction(uint16_t address, uint8_t opcode, uint16_t startStackPointer, unsigned int cycles,
+                               const State8080 *state);
+
+/**
+ * Counts an interrupt in the call graph
+ * @param startStackPointer - SP before the interrupt
+ * @param cycles - Cycles the interrupt took
+ * @param state - The 8080 state after the interrupt
+ */
+void recordProfiledInterrupt(uint16_t startStackPointer, unsigned int cycles, const State8080 *state);
+
+/**
+ * Writes the profile reports to the working directory
+ * @return int - 1 if every report was written, 0 otherwise
+ */
+int writeProfile();
+
+// Placed around the execution of one instruction
+#define PROFILE_INSTRUCTION_START(state) \
+    uint16_t profiledAddress = (state)->pc; \
+    uint8_t profiledOpcode = (state)->memory[profiledAddress]; \
+    uint16_t profiledStackPointer = (state)->sp; \
+    unsigned int profiledStartCycles = (state)->cyclesCompleted;
+#define PROFILE_INSTRUCTION_END(state) \
+    recordProfiledInstruction(profiledAddress, profiledOpcode, profiledStackPointer, \
+                              (state)->cyclesCompleted-profiledStartCycles, state);
+// Placed around an interrupt
+#define PROFILE_INTERRUPT_START(state) \
+    uint16_t profiledStackPointer = (state)->sp; \
+    unsigned int profiledStartCycles = (state)->cyclesCompleted;
+#define PROFILE_INTERRUPT_END(state) \
+    recordProfiledInterrupt(profiledStackPointer, (state)->cyclesCompleted-profiledStartCycles, state);
+#define PROFILE_INITIALIZE(romImage) initializeProfiler(romImage);
+
+#else
+
+#define PROFILE_INSTRUCTION_START(state)
+#define PROFILE_INSTRUCTION_END(state)
+#define PROFILE_INTERRUPT_START(state)
+#define PROFILE_INTERRUPT_END(state)
+#define PROFILE_INITIALIZE(romImage)
+
+#endif //CPU_PROFILE
+
+#endif //INTEL_8080_EMULATOR_PROFILER_H
@@ -0,0 +1,159 @@
+/***********************************************************************************
+ *
+ * Golden frame-hash regression test.
+ *
+ * Runs the attract mode and a few recorded games headless for a fixed number of frames,
+ * taking a CRC-32 of work RAM and of VRAM every few frames, and compares them against
+ * the golden hashes checked in next to the movies. Any change to emulation shows up as the
+ * first checkpoint whose hashes differ.
+ *
+ * Usage: regression_test [--golden DIR] [--update] [--engine NAME]
+ * --golden DIR   Folder holding the movies and golden hash files (default "tests")
+ * --update       Rewrite the golden hash files from the current build instead of checking them
+ * --engine NAME  CPU engine to run the scenarios on (default "reference")
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "arcadeEnvironment.h"
+#include "movie.h"
+
+#define DEFAULT_GOLDEN_PATH "tests"
+#define WORK_RAM_START 0x2000
+#define WORK_RAM_SIZE 0x0400
+#define VRAM_START 0x2400
+#define VRAM_SIZE 0x1c00
+
+/**
+ * One run of the arcade whose hashes are checked
+ */
+typedef struct RegressionScenario{
+    const char *name;  /**< Names the golden hash file, "<name>.golden" */
+    const char *movieName;  /**< Movie supplying the input, or NULL to run with no input */
+    uint32_t numFrames;
+    uint32_t hashInterval;  /**< Frames between checkpoints */
+} RegressionScenario;
+
+const RegressionScenario regressionScenarios[] = {
+    {"attract", NULL, 7200, 60},
+    {"one_player", "one_player.mov", 7200, 60},
+    {"two_player", "two_player.mov", 7200, 60},
+    {"idle_death", "idle_death.mov", 5400, 60}
+};
+
+int runScenario(const RegressionScenario *scenario, const char *goldenPath, bool updating, enum CpuEngineType engine);
+
+int main(int argc, char **argv)
+{
+    const char *goldenPath = DEFAULT_GOLDEN_PATH;
+    bool updating = false;
+    enum CpuEngineType engine = ReferenceEngine;
+
+    for(int argNum = 1; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--golden") == 0 && argNum+1 < argc){
+            argNum++;
+            goldenPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--update") == 0){
+            updating = true;
+        }else if(strcmp(argv[argNum], "--engine") == 0 && argNum+1 < argc &&
+                 findCpuEngine(argv[argNum+1], &engine) == 1){
+            argNum++;
+        }else{
+            logger("Usage: %s [--golden DIR] [--update] [--engine NAME]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    unsigned int numScenarios = sizeof(regressionScenarios)/sizeof(regressionScenarios[0]);
+    unsigned int numFailures = 0;
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    for(unsigned int scenarioNum = 0; scenarioNum < numScenarios; scenarioNum++){
+        if(runScenario(&(regressionScenarios[scenarioNum]), goldenPath, updating, engine) == 0){
+            numFailures++;
+        }
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter()-startTicks)/(double)SDL_GetPerformanceFrequency();
+
+    printf("%u of %u scenarios passed in %.2f s\n", numScenarios-numFailures, numScenarios, seconds);
+    return (numFailures == 0) ? 0 : 1;
+}
+
+/**
+ * Runs a scenario and checks, or rewrites, its golden hashes
+ * @param scenario - The scenario to run
+ * @param goldenPath - Folder holding the movies and golden hash files
+ * @param updating - Write the hashes instead of checking them
+ * @param engine - CPU engine to run the scenario on
+ * @return int - 1 if every checkpoint matched or the golden file was written, 0 otherwise
+ */
+int runScenario(const RegressionScenario *scenario, const char *goldenPath, bool updating, enum CpuEngineType engine)
+{
+    char moviePath[RESOURCE_PATH_LENGTH];
+    char hashPath[RESOURCE_PATH_LENGTH];
+    snprintf(hashPath, sizeof(hashPath), "%s/%s.golden", goldenPath, scenario->name);
+
+    ArcadeConfig config;
+    setHeadlessArcadeConfig(&config);
+    config.engine = engine;
+    if(scenario->movieName != NULL){
+        snprintf(moviePath, sizeof(moviePath), "%s/%s", goldenPath, scenario->movieName);
+        config.playPath = moviePath;
+    }
+
+    FILE *hashFile = fopen(hashPath, updating ? "w" : "r");
+    if(hashFile == NULL){
+        printf("FAIL %s: cannot open %s\n", scenario->name, hashPath);
+        return 0;
+    }
+
+    ArcadeState *arcade = initializeArcade(&config);
+    if(arcade == NULL){
+        printf("FAIL %s: arcade could not be set up\n", scenario->name);
+        fclose(hashFile);
+        return 0;
+    }
+
+    int passed = 1;
+    uint8_t *memory = arcade->cpu->memory;
+    for(uint32_t frame = 1; frame <= scenario->numFrames && passed; frame++){
+        resetPortsIO(arcade);
+        if(arcade->moviePlayer != NULL && playMovieFrame(arcade->moviePlayer, arcade) == 0){
+            printf("FAIL %s: movie ended at frame %u\n", scenario->name, frame);
+            passed = 0;
+            break;
+        }
+        runFrame(arcade);
+
+        if(frame % scenario->hashInterval != 0){
+            continue;
+        }
+        uint32_t ramChecksum = crc32(0, &(memory[WORK_RAM_START]), WORK_RAM_SIZE);
+        uint32_t vramChecksum = crc32(0, &(memory[VRAM_START]), VRAM_SIZE);
+        if(updating){
+            fprintf(hashFile, "%u %08x %08x\n", frame, ramChecksum, vramChecksum);
+            continue;
+        }
+
+        unsigned int goldenFrame;
+        unsigned int goldenRamChecksum;
+        unsigned int goldenVramChecksum;
+        if(fscanf(hashFile, "%u %x %x", &goldenFrame, &goldenRamChecksum, &goldenVramChecksum) != 3 ||
+           goldenFrame != frame){
+            printf("FAIL %s: %s has no checkpoint for frame %u\n", scenario->name, hashPath, frame);
+            passed = 0;
+        }else if(ramChecksum != goldenRamChecksum || vramChecksum != goldenVramChecksum){
+            printf("FAIL %s: first mismatch at frame %u, RAM 0x%08x (golden 0x%08x), VRAM 0x%08x (golden 0x%08x)\n",
+                   scenario->name, frame, ramChecksum, goldenRamChecksum, vramChecksum, goldenVramChecksum);
+            passed = 0;
+        }
+    }
+
+    if(passed){
+        printf("%s %s: %u frames\n", updating ? "UPDATED" : "PASS", scenario->name, scenario->numFrames);
+    }
+
+    fclose(hashFile);
+    destroyArcade(arcade);
+
+    return passed;
+}
@@ -0,0 +1,138 @@
+/***********************************************************************************
+ *
+ * Plays a movie file back without a window or audio, as fast as the host allows.
+ * Prints the number of frames played, the speed, and a checksum of RAM at the end,
+ * so that two builds of the emulator can be checked against the same recorded session.
+ * With --seek, playback starts from the given frame, reached through the movie's nearest keyframe.
+ * With --verify, the movie is instead checked segment by segment against its own keyframes,
+ * on the given number of threads (0 for one per core), and every segment that desyncs is listed.
+ * Log messages are written by the background log writer while the movie plays.
+ *
+ * Usage: replay_player MOVIE [--seek FRAME | --verify THREADS] [--resources DIR]
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "arcadeEnvironment.h"
+#include "movie.h"
+#include "saveState.h"
+#include "movieVerifier.h"
+#include "logWriter.h"
+
+int verifyMovieSegments(const ArcadeConfig *config, const char *moviePath, unsigned int numThreads);
+
+int main(int argc, char **argv)
+{
+    if(argc < 2){
+        logger("Usage: %s MOVIE [--seek FRAME | --verify THREADS] [--resources DIR]\n", argv[0]);
+        return 1;
+    }
+
+    // Options of the player itself are taken out before the arcade options are read
+    char *arcadeArgv[argc];
+    int arcadeArgc = 1;
+    bool seeking = false;
+    uint32_t seekFrame = 0;
+    bool verifying = false;
+    unsigned int numThreads = 0;
+    arcadeArgv[0] = argv[0];
+    for(int argNum = 2; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--seek") == 0 && argNum+1 < argc){
+            argNum++;
+            seeking = true;
+            seekFrame = (uint32_t)strtoul(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--verify") == 0 && argNum+1 < argc){
+            argNum++;
+            verifying = true;
+            numThreads = (unsigned int)strtoul(argv[argNum], NULL, 10);
+        }else{
+            arcadeArgv[arcadeArgc] = argv[argNum];
+            arcadeArgc++;
+        }
+    }
+
+    ArcadeConfig config;
+    setHeadlessArcadeConfig(&config);
+    if(parseArcadeConfig(arcadeArgc, arcadeArgv, &config) == 0){
+        return 1;
+    }
+    startLogWriter(config.logLevel);
+    if(verifying){
+        return verifyMovieSegments(&config, argv[1], numThreads);
+    }
+    config.playPath = argv[1];
+
+    ArcadeState *arcade = initializeArcade(&config);
+    if(arcade == NULL){
+        return 1;
+    }
+
+    if(seeking){
+        uint64_t seekTicks = SDL_GetPerformanceCounter();
+        if(seekMovie(arcade->moviePlayer, arcade, seekFrame) == 0){
+            destroyArcade(arcade);
+            return 1;
+        }
+        double seekMilliseconds = (double)(SDL_GetPerformanceCounter()-seekTicks)*1000.0/(double)SDL_GetPerformanceFrequency();
+        printf("Seek to frame %u: %.2f ms\n", seekFrame, seekMilliseconds);
+    }
+
+    // Same per-frame sequence as the game loop, minus rendering and audio
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+    uint32_t numFrames = 0;
+    while(1){
+        resetPortsIO(arcade);
+        if(playMovieFrame(arcade->moviePlayer, arcade) == 0){
+            break;
+        }
+        runFrame(arcade);
+        numFrames++;
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter()-startTicks)/(double)SDL_GetPerformanceFrequency();
+    stopLogWriter();  // Messages from playback come before the results
+
+    uint32_t ramChecksum = crc32(0, &(arcade->cpu->memory[SAVE_STATE_RAM_START]), SAVE_STATE_RAM_SIZE);
+    printf("Frames: %u\n", numFrames);
+    printf("Time: %.3f s (%.0f frames per second, %.1fx real time)\n",
+           seconds, numFrames/seconds, numFrames/(seconds*FPS));
+    printf("RAM CRC-32: 0x%08x\n", ramChecksum);
+
+    destroyArcade(arcade);
+
+    return 0;
+}
+
+/**
+ * Verifies a movie against its keyframes and prints any segments that desync
+ * @return int - exit code, 0 if every segment matched
+ */
+int verifyMovieSegments(const ArcadeConfig *config, const char *moviePath, unsigned int numThreads)
+{
+    MovieVerification *verification = verifyMovie(config, moviePath, numThreads);
+    stopLogWriter();
+    if(verification == NULL){
+        return 1;
+    }
+
+    for(uint32_t segmentNum = 0; segmentNum < verification->numSegments; segmentNum++){
+        MovieSegmentResult *segment = &(verification->segments[segmentNum]);
+        if(!(segment->verified)){
+            printf("Segment %u (frames %u-%u): could not be emulated\n",
+                   segmentNum, segment->startFrame, segment->endFrame);
+        }else if(!(segment->matched)){
+            printf("Segment %u (frames %u-%u): DESYNC, state CRC-32 0x%08x, keyframe 0x%08x, first difference at save state byte %d\n",
+                   segmentNum, segment->startFrame, segment->endFrame,
+                   segment->actualChecksum, segment->expectedChecksum, segment->firstDifference);
+        }
+    }
+
+    uint32_t numFrames = verification->numSegments > 0 ? verification->segments[verification->numSegments-1].endFrame : 0;
+    printf("Segments: %u verified, %u desynced, %u trailing frames unchecked\n",
+           verification->numSegments, verification->numDesyncs, verification->numUncheckedFrames);
+    printf("Time: %.3f s on %u threads (%.0f frames per second)\n",
+           verification->seconds, verification->numThreads, numFrames/verification->seconds);
+
+    int exitCode = (verification->numDesyncs == 0) ? 0 : 1;
+    destroyMovieVerification(verification);
+    return exitCode;
+}
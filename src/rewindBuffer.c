@@ -0,0 +1,204 @@
+/***********************************************************************************
+ *
+ * Source for the rewind buffer
+ * @Author: Andrew Gunter
+ *
+ * Delta encoding, applied to (newer XOR older) save states:
+ *   0LLLLLLL LLLLLLLL         - Run of (L+1) zero bytes, up to 32768
+ *   1LLLLLLL [L+1 bytes]      - (L+1) literal bytes, up to 128
+ * Zero runs shorter than 3 bytes are folded into literals, which bounds the worst case
+ * at one extra byte per 128 bytes of input.
+ *
+***********************************************************************************/
+
+#include "rewindBuffer.h"
+
+#define MAX_ZERO_RUN 32768
+#define MAX_LITERAL_RUN 128
+#define MIN_ZERO_RUN 3
+
+uint32_t encodeDelta(const uint8_t *newer, const uint8_t *older, uint8_t *encoded);
+void applyDelta(const uint8_t *encoded, uint32_t encodedSize, uint8_t *state);
+void dropOldestRewindEntry(RewindBuffer *rewind);
+
+RewindBuffer *initializeRewindBuffer(unsigned int seconds)
+{
+    RewindBuffer *rewind = mallocSet(sizeof(RewindBuffer));
+
+    rewind->maxEntries = seconds*FPS;
+    if(rewind->maxEntries == 0){
+        rewind->maxEntries = 1;
+    }
+    rewind->entries = mallocSet(rewind->maxEntries*sizeof(RewindEntry));
+
+    // Always leave room for at least two worst-case deltas
+    rewind->ringSize = seconds*REWIND_BYTES_PER_SECOND;
+    if(rewind->ringSize < 2*REWIND_MAX_DELTA_SIZE){
+        rewind->ringSize = 2*REWIND_MAX_DELTA_SIZE;
+    }
+    rewind->ring = mallocSet(rewind->ringSize);
+
+    return rewind;
+}
+
+void destroyRewindBuffer(RewindBuffer *rewind)
+{
+    if(rewind == NULL){
+        return;
+    }
+
+    free(rewind->ring);
+    free(rewind->entries);
+    free(rewind);
+}
+
+void captureRewindFrame(RewindBuffer *rewind, ArcadeState *arcade)
+{
+    uint64_t startTicks = SDL_GetPerformanceCounter();
+
+    saveState(arcade, rewind->capturedState, SAVE_STATE_SIZE);
+
+    if(rewind->hasNewestState){
+        // The previous frame is stored as its difference from this one
+        uint32_t deltaSize = encodeDelta(rewind->capturedState, rewind->newestState, rewind->encodedDelta);
+
+        // Deltas are never split, so skip to the start of the ring if this one would run off the end
+        if(rewind->ringHead + deltaSize > rewind->ringSize){
+            rewind->ringHead = 0;
+        }
+
+        // Make room by dropping the oldest frames
+        while(rewind->numEntries > 0){
+            RewindEntry *oldest = &(rewind->entries[rewind->oldestEntry]);
+            bool overlapsOldest = (oldest->offset < rewind->ringHead + deltaSize) &&
+                                  (rewind->ringHead < oldest->offset + oldest->size);
+            if(rewind->numEntries == rewind->maxEntries || overlapsOldest){
+                dropOldestRewindEntry(rewind);
+            }else{
+                break;
+            }
+        }
+
+        unsigned int newEntry = (rewind->oldestEntry + rewind->numEntries) % rewind->maxEntries;
+        rewind->entries[newEntry].offset = rewind->ringHead;
+        rewind->entries[newEntry].size = deltaSize;
+        rewind->numEntries++;
+        memcpy(&(rewind->ring[rewind->ringHead]), rewind->encodedDelta, deltaSize);
+        rewind->ringHead += deltaSize;
+        rewind->compressedBytes += deltaSize;
+    }
+
+    memcpy(rewind->newestState, rewind->capturedState, SAVE_STATE_SIZE);
+    rewind->hasNewestState = true;
+
+    rewind->captureTicks += SDL_GetPerformanceCounter() - startTicks;
+    rewind->numCaptures++;
+}
+
+int rewindFrame(RewindBuffer *rewind, ArcadeState *arcade)
+{
+    if(rewind->numEntries == 0){
+        return 0;
+    }
+
+    // XOR-ing the newest delta into the newest state yields the frame before it
+    unsigned int newestEntryNum = (rewind->oldestEntry + rewind->numEntries - 1) % rewind->maxEntries;
+    RewindEntry *newestEntry = &(rewind->entries[newestEntryNum]);
+    applyDelta(&(rewind->ring[newestEntry->offset]), newestEntry->size, rewind->newestState);
+    loadState(arcade, rewind->newestState, SAVE_STATE_SIZE);
+
+    // The delta's space can be reused straight away
+    rewind->ringHead = newestEntry->offset;
+    rewind->numEntries--;
+
+    return 1;
+}
+
+unsigned int getRewindFrameCount(RewindBuffer *rewind)
+{
+    return rewind->numEntries;
+}
+
+double getRewindCaptureMicroseconds(RewindBuffer *rewind)
+{
+    if(rewind->numCaptures == 0){
+        return 0.0;
+    }
+
+    double totalMicroseconds = (double)rewind->captureTicks * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    return totalMicroseconds / (double)rewind->numCaptures;
+}
+
+/**
+ * Run-length encodes (newer XOR older)
+ * @param newer - Newer save state
+ * @param older - Older save state
+ * @param encoded - Destination, must hold REWIND_MAX_DELTA_SIZE bytes
+ * @return - Size of the encoded delta, in bytes
+ */
+uint32_t encodeDelta(const uint8_t *newer, const uint8_t *older, uint8_t *encoded)
+{
+    uint32_t encodedSize = 0;
+    uint32_t position = 0;
+
+    while(position < SAVE_STATE_SIZE){
+        // Measure the run of unchanged bytes starting here
+        uint32_t zeroRun = 0;
+        while(position+zeroRun < SAVE_STATE_SIZE && zeroRun < MAX_ZERO_RUN &&
+              newer[position+zeroRun] == older[position+zeroRun]){
+            zeroRun++;
+        }
+
+        if(zeroRun >= MIN_ZERO_RUN){
+            encoded[encodedSize++] = (uint8_t)((zeroRun-1) >> 8);
+            encoded[encodedSize++] = (uint8_t)(zeroRun-1);
+            position += zeroRun;
+            continue;
+        }
+
+        // Otherwise copy changed bytes until the next worthwhile zero run
+        uint32_t literalStart = encodedSize++;
+        uint32_t literalRun = 0;
+        while(position < SAVE_STATE_SIZE && literalRun < MAX_LITERAL_RUN){
+            if(position+MIN_ZERO_RUN <= SAVE_STATE_SIZE && literalRun > 0 &&
+               newer[position] == older[position] && newer[position+1] == older[position+1] &&
+               newer[position+2] == older[position+2]){
+                break;
+            }
+            encoded[encodedSize++] = newer[position] ^ older[position];
+            position++;
+            literalRun++;
+        }
+        encoded[literalStart] = (uint8_t)(0x80 | (literalRun-1));
+    }
+
+    return encodedSize;
+}
+
+/**
+ * XORs an encoded delta into a save state, turning it into the other state the delta was made from
+ */
+void applyDelta(const uint8_t *encoded, uint32_t encodedSize, uint8_t *state)
+{
+    uint32_t readPosition = 0;
+    uint32_t position = 0;
+
+    while(readPosition < encodedSize){
+        uint8_t token = encoded[readPosition++];
+        if(token & 0x80){
+            uint32_t literalRun = (uint32_t)(token & 0x7f) + 1;
+            for(uint32_t byteNum = 0; byteNum < literalRun; byteNum++){
+                state[position++] ^= encoded[readPosition++];
+            }
+        }else{
+            uint32_t zeroRun = (((uint32_t)token << 8) | encoded[readPosition++]) + 1;
+            position += zeroRun;
+        }
+    }
+}
+
+void dropOldestRewindEntry(RewindBuffer *rewind)
+{
+    rewind->oldestEntry = (rewind->oldestEntry + 1) % rewind->maxEntries;
+    rewind->numEntries--;
+}
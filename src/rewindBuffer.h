@@ -0,0 +1,90 @@
+/***********************************************************************************
+ *
+ * Header for the rewind buffer, which keeps the last few seconds of play.
+ *
+ * A save state is captured every frame, but only the newest one is kept in full.
+ * Every older frame is stored as the XOR of its save state with the next frame's,
+ * run-length encoded into a fixed-size byte ring. Since most of RAM and VRAM is
+ * unchanged from one frame to the next, the deltas are almost entirely zero runs.
+ * Rewinding a frame decodes the newest delta into the full state and loads it.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_REWINDBUFFER_H
+#define INTEL_8080_EMULATOR_REWINDBUFFER_H
+
+#include "saveState.h"
+
+#define REWIND_BYTES_PER_SECOND 32768  // Ring space reserved per second of history, about 540 bytes per frame
+#define REWIND_MAX_DELTA_SIZE (SAVE_STATE_SIZE + SAVE_STATE_SIZE/128 + 2)  // Worst case run-length encoding
+
+/**
+ * Location of one compressed delta in the byte ring
+ */
+typedef struct RewindEntry{
+    uint32_t offset;
+    uint32_t size;
+} RewindEntry;
+
+typedef struct RewindBuffer{
+    uint8_t newestState[SAVE_STATE_SIZE];  /**< Full save state of the newest captured frame */
+    uint8_t capturedState[SAVE_STATE_SIZE];  /**< Scratch space for the frame being captured */
+    uint8_t encodedDelta[REWIND_MAX_DELTA_SIZE];  /**< Scratch space for the delta being compressed */
+    bool hasNewestState;
+    uint8_t *ring;  /**< Compressed deltas, oldest to newest */
+    uint32_t ringSize;
+    uint32_t ringHead;  /**< Offset at which the next delta will be written */
+    RewindEntry *entries;  /**< Circular list of the deltas held in the ring */
+    unsigned int maxEntries;
+    unsigned int oldestEntry;
+    unsigned int numEntries;
+    // Capture cost measurement
+    uint64_t captureTicks;  /**< Total SDL performance counter ticks spent in captureRewindFrame */
+    uint64_t numCaptures;
+    uint64_t compressedBytes;  /**< Total size of all deltas captured */
+} RewindBuffer;
+
+/**
+ * Creates a rewind buffer
+ * @param seconds - Seconds of play to keep, at 60 frames per second
+ * @return - pointer to the rewind buffer
+ */
+RewindBuffer *initializeRewindBuffer(unsigned int seconds);
+
+/**
+ * Frees a rewind buffer
+ * @param rewind - The rewind buffer
+ */
+void destroyRewindBuffer(RewindBuffer *rewind);
+
+/**
+ * Records the arcade's current state as the newest frame.
+ * Should be called once per emulated frame. The oldest frames are dropped once the buffer is full.
+ * @param rewind - The rewind buffer
+ * @param arcade - The arcade state
+ */
+void captureRewindFrame(RewindBuffer *rewind, ArcadeState *arcade);
+
+/**
+ * Steps the arcade back to the frame before the newest captured frame.
+ * That frame becomes the newest, so capturing can continue from it.
+ * @param rewind - The rewind buffer
+ * @param arcade - The arcade state
+ * @return int - 1 if the arcade was rewound, 0 if there is no older frame left
+ */
+int rewindFrame(RewindBuffer *rewind, ArcadeState *arcade);
+
+/**
+ * @param rewind - The rewind buffer
+ * @return - Number of frames that can currently be rewound
+ */
+unsigned int getRewindFrameCount(RewindBuffer *rewind);
+
+/**
+ * @param rewind - The rewind buffer
+ * @return - Average time spent capturing a frame, in microseconds
+ */
+double getRewindCaptureMicroseconds(RewindBuffer *rewind);
+
+#endif //INTEL_8080_EMULATOR_REWINDBUFFER_H
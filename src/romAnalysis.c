@@ -0,0 +1,1117 @@
+/***********************************************************************************
+ *
+ * Source for static analysis of the 8080 ROM
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "romAnalysis.h"
+#include "helpers.h"
+
+#define STACK_DEPTH_FOLLOWED 16  // Register pairs pushed that an indirect jump's block is followed through
+#define MAX_PATH_BLOCKS 16  // Blocks followed on the way to an indirect jump, its own included
+#define MAX_PREDECESSORS 8  // Ways into a block looked at, more and the path to an indirect jump ends there
+#define MAX_LOOP_BLOCKS 64  // Blocks followed from a loop's head looking for the ways back to it
+
+// What is known about a register pair while following a block up to an indirect jump
+#define PAIR_UNKNOWN 0
+#define PAIR_CONSTANT 1
+#define PAIR_TABLE_ENTRY 2  // A word loaded from a table, value is the address of its first entry
+#define PAIR_INDEXED 3  // A table's address plus an unknown index, plus offset
+
+/**
+ * A register's value while following a block, as part of a pair value
+ */
+typedef struct AbstractByte{
+    uint8_t kind;  /**< Kind of the pair value the byte is from */
+    bool isHigh;  /**< The byte is the high byte of that value */
+    uint16_t value;  /**< As the pair's, but the address the byte was loaded from for a table entry */
+    int16_t offset;
+    int16_t stride;
+} AbstractByte;
+
+/**
+ * A register pair's value while following a block
+ */
+typedef struct AbstractPair{
+    uint8_t kind;
+    uint16_t value;  /**< The constant, or the table's address */
+    int16_t offset;  /**< Added to an indexed table's address */
+    int16_t stride;  /**< Bytes from one table entry to the next, 0 if not known */
+} AbstractPair;
+
+/**
+ * Registers and stack while following a block, registers by number as in opcodes
+ */
+typedef struct AbstractState{
+    AbstractByte registers[8];
+    AbstractPair stack[STACK_DEPTH_FOLLOWED];  /**< Top of the stack last */
+    uint32_t stackDepth;
+} AbstractState;
+
+void findCode(RomAnalysis *analysis, const uint8_t *memory, const uint16_t *entryPoints, uint32_t numEntryPoints);
+void setSuccessors(RomInstruction *instruction, const uint8_t *memory, uint16_t address, uint16_t *returnAddress);
+void addSuccessor(RomInstruction *instruction, uint32_t address);
+bool isUndefinedOpcode(uint8_t opcode);
+bool fallsThrough(const RomInstruction *instruction, const uint8_t *memory, uint16_t address);
+void findBlockStarts(RomAnalysis *analysis, const uint8_t *memory);
+uint16_t findLastInstruction(const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart);
+bool isCallOpcode(uint8_t opcode);
+void findBlockCopies(RomAnalysis *analysis, const uint8_t *memory);
+bool isBlockCopyLoop(const uint8_t *memory, uint32_t address);
+uint32_t resolveIndirectJumps(RomAnalysis *analysis, const uint8_t *memory, uint16_t *newEntryPoints);
+uint32_t resolveIndirectJump(RomAnalysis *analysis, const uint8_t *memory, const bool *covered, uint16_t blockStart,
+                             uint16_t jumpAddress, uint16_t *newEntryPoints);
+uint32_t findBlockPath(const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart, uint16_t *path);
+uint32_t findPredecessors(const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart, uint16_t *predecessors);
+void enterBlock(AbstractState *abstract, const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart);
+uint32_t followLoop(const RomAnalysis *analysis, const uint8_t *memory, uint16_t loopHead, int16_t *steps,
+                    bool *stepsKnown);
+uint32_t readTableWords(const RomAnalysis *analysis, const uint8_t *memory, const bool *covered, uint32_t address,
+                        uint16_t *words);
+void followInstruction(AbstractState *abstract, const uint8_t *memory, uint16_t address);
+AbstractPair getAbstractPair(const AbstractState *abstract, uint8_t highRegister);
+void setAbstractPair(AbstractState *abstract, uint8_t highRegister, AbstractPair pair);
+AbstractPair addAbstractPairs(AbstractPair first, AbstractPair second);
+bool isPlausibleCode(const RomAnalysis *analysis, const uint8_t *memory, const bool *covered, uint32_t address);
+void findLiveFlags(RomAnalysis *analysis);
+void findKillDistances(RomAnalysis *analysis);
+
+RomAnalysis *analyzeRom(const uint8_t *memory)
+{
+    return analyzeRomFrom(memory, NULL, 0);
+}
+
+RomAnalysis *analyzeRomFrom(const uint8_t *memory, const uint16_t *entryPoints, uint32_t numEntryPoints)
+{
+    RomAnalysis *analysis = mallocSet(sizeof(RomAnalysis));
+    const uint16_t vectors[3] = {0x0000, 0x0008, 0x0010};  // Reset and the two interrupts the cabinet raises
+    findCode(analysis, memory, vectors, 3);
+
+    // Code found through an indirect jump may hold more indirect jumps. The entry points given are
+    // only followed once the ROM has been analyzed without them, and only those not yet found.
+    uint16_t *newEntryPoints = mallocSet(ROM_LIMIT_8080*sizeof(uint16_t));
+    bool entryPointsFollowed = false;
+    while(1){
+        findBlockStarts(analysis, memory);
+        uint32_t numNewEntryPoints = resolveIndirectJumps(analysis, memory, newEntryPoints);
+        if(numNewEntryPoints > 0){
+            findCode(analysis, memory, newEntryPoints, numNewEntryPoints);
+        }else if(!entryPointsFollowed){
+            for(uint32_t entryNum = 0; entryNum < numEntryPoints; entryNum++){
+                if(entryPoints[entryNum] < ROM_LIMIT_8080 && !(analysis->instructions[entryPoints[entryNum]].isCode)){
+                    findCode(analysis, memory, &(entryPoints[entryNum]), 1);
+                }
+            }
+            entryPointsFollowed = true;
+        }else{
+            break;
+        }
+    }
+    free(newEntryPoints);
+
+    findLiveFlags(analysis);
+    findKillDistances(analysis);
+
+    return analysis;
+}
+
+void destroyRomAnalysis(RomAnalysis *analysis)
+{
+    free(analysis);
+}
+
+uint8_t getLiveFlags(const RomAnalysis *analysis, uint16_t address)
+{
+    if(address >= ROM_LIMIT_8080 || !(analysis->instructions[address].isCode)){
+        return ALL_FLAGS;
+    }
+
+    return analysis->instructions[address].liveFlagsIn;
+}
+
+uint32_t getBlockEnd(const RomAnalysis *analysis, const uint8_t *memory, uint16_t address)
+{
+    uint32_t blockEnd = address;
+    while(1){
+        const RomInstruction *instruction = &(analysis->instructions[blockEnd]);
+        uint16_t instructionAddress = (uint16_t)blockEnd;
+        blockEnd += instructionSizes[memory[instructionAddress]];
+        if(!fallsThrough(instruction, memory, instructionAddress) || analysis->instructions[blockEnd].isBlockStart){
+            return blockEnd;
+        }
+    }
+}
+
+void getOpcodeFlags(uint8_t opcode, uint8_t *flagsRead, uint8_t *flagsWritten)
+{
+    *flagsRead = instructionFlagsRead[opcode];
+    *flagsWritten = instructionFlagsWritten[opcode];
+}
+
+/**
+ * Follows every path from a set of entry points, marking the instructions reached
+ * and where each one continues. Instructions already found are not followed again.
+ * @param analysis - The analysis to fill in
+ * @param memory - The 8080 memory
+ * @param entryPoints - Addresses to start from
+ * @param numEntryPoints - Number of entry points
+ */
+void findCode(RomAnalysis *analysis, const uint8_t *memory, const uint16_t *entryPoints, uint32_t numEntryPoints)
+{
+    // Addresses still to be followed, each address is only ever added once
+    uint16_t *toVisit = mallocSet(ROM_LIMIT_8080*sizeof(uint16_t));
+    bool *queued = mallocSet(ROM_LIMIT_8080*sizeof(bool));
+    uint32_t numToVisit = 0;
+    for(uint32_t entryNum = 0; entryNum < numEntryPoints; entryNum++){
+        uint16_t address = entryPoints[entryNum];
+        if(address < ROM_LIMIT_8080 && !queued[address]){
+            analysis->instructions[address].isEntryPoint = true;
+            toVisit[numToVisit++] = address;
+            queued[address] = true;
+        }
+    }
+
+    while(numToVisit > 0){
+        uint16_t address = toVisit[--numToVisit];
+        RomInstruction *instruction = &(analysis->instructions[address]);
+        if(instruction->isCode){
+            continue;
+        }
+        instruction->isCode = true;
+        analysis->numInstructions++;
+        getOpcodeFlags(memory[address], &(instruction->flagsRead), &(instruction->flagsWritten));
+
+        uint16_t returnAddress = 0;
+        setSuccessors(instruction, memory, address, &returnAddress);
+
+        // Code after a call is reached when the call returns
+        uint16_t nextAddresses[3] = {instruction->successors[0], instruction->successors[1], returnAddress};
+        unsigned int numNext = instruction->numSuccessors;
+        if(returnAddress != 0){
+            if(instruction->numSuccessors > 0 && instruction->successors[0] != returnAddress){
+                analysis->instructions[instruction->successors[0]].isCallTarget = true;
+            }
+            analysis->instructions[returnAddress].isEntryPoint = true;
+            nextAddresses[numNext++] = returnAddress;
+        }
+        for(unsigned int nextNum = 0; nextNum < numNext; nextNum++){
+            if(!queued[nextAddresses[nextNum]]){
+                queued[nextAddresses[nextNum]] = true;
+                toVisit[numToVisit++] = nextAddresses[nextNum];
+            }
+        }
+    }
+
+    free(toVisit);
+    free(queued);
+}
+
+/**
+ * Finds where execution continues after an instruction.
+ * Calls continue at the routine called: the flags there are the flags after the call,
+ * while the return address is only reached through a RET, which is not followed.
+ * @param instruction - The instruction
+ * @param memory - The 8080 memory
+ * @param address - Address of the instruction
+ * @param returnAddress - Set to the address a call returns to, left at 0 for other instructions
+ */
+void setSuccessors(RomInstruction *instruction, const uint8_t *memory, uint16_t address, uint16_t *returnAddress)
+{
+    uint8_t opcode = memory[address];
+    uint32_t nextAddress = (uint32_t)address+instructionSizes[opcode];
+    uint16_t target = 0;
+    if(instructionSizes[opcode] == 3 && nextAddress <= ROM_LIMIT_8080){
+        target = (uint16_t)(memory[address+1] | (memory[address+2]<<8));
+    }
+
+    if(isUndefinedOpcode(opcode) || opcode == 0x76 || opcode == 0xc9 || opcode == 0xe9){
+        // HLT, RET and PCHL
+        instruction->unknownSuccessors = true;
+    }else if(opcode == 0xc3){
+        addSuccessor(instruction, target);
+    }else if(opcode == 0xcd){
+        addSuccessor(instruction, target);
+        if(nextAddress < ROM_LIMIT_8080){
+            *returnAddress = (uint16_t)nextAddress;
+        }
+    }else if((opcode & 0xc7) == 0xc2 || (opcode & 0xc7) == 0xc4){
+        // Conditional jumps and calls, a call not taken runs on like a jump not taken
+        addSuccessor(instruction, target);
+        addSuccessor(instruction, nextAddress);
+        if((opcode & 0xc7) == 0xc4 && nextAddress < ROM_LIMIT_8080){
+            *returnAddress = (uint16_t)nextAddress;
+        }
+    }else if((opcode & 0xc7) == 0xc0){
+        // Conditional return
+        addSuccessor(instruction, nextAddress);
+        instruction->unknownSuccessors = true;
+    }else if((opcode & 0xc7) == 0xc7){
+        // RST
+        addSuccessor(instruction, opcode & 0x38);
+        if(nextAddress < ROM_LIMIT_8080){
+            *returnAddress = (uint16_t)nextAddress;
+        }
+    }else{
+        addSuccessor(instruction, nextAddress);
+    }
+}
+
+/**
+ * Adds somewhere execution continues, addresses outside of ROM cannot be followed
+ * @param instruction - The instruction
+ * @param address - Where execution continues
+ */
+void addSuccessor(RomInstruction *instruction, uint32_t address)
+{
+    if(address >= ROM_LIMIT_8080){
+        instruction->unknownSuccessors = true;
+    }else{
+        instruction->successors[instruction->numSuccessors] = (uint16_t)address;
+        instruction->numSuccessors++;
+    }
+}
+
+/**
+ * @param opcode - An opcode
+ * @return - Whether the opcode is one the 8080 does not define
+ */
+bool isUndefinedOpcode(uint8_t opcode)
+{
+    return (opcode < 0x40 && (opcode & 0x07) == 0x00 && opcode != 0x00)
+           || opcode == 0xcb || opcode == 0xd9 || opcode == 0xdd || opcode == 0xed || opcode == 0xfd;
+}
+
+/**
+ * @param instruction - An instruction found to be code
+ * @param memory - The 8080 memory
+ * @param address - Address of the instruction
+ * @return - Whether the instruction always runs on to the next one, which is in ROM
+ */
+bool fallsThrough(const RomInstruction *instruction, const uint8_t *memory, uint16_t address)
+{
+    uint32_t nextAddress = (uint32_t)address+instructionSizes[memory[address]];
+    return !(instruction->unknownSuccessors) && instruction->numSuccessors == 1
+           && instruction->successors[0] == nextAddress;
+}
+
+/**
+ * Marks where basic blocks start: at entry points, at every successor of an instruction that
+ * branches, and wherever two instructions run on into the same address
+ * @param analysis - The analysis, with the code found
+ * @param memory - The 8080 memory
+ */
+void findBlockStarts(RomAnalysis *analysis, const uint8_t *memory)
+{
+    uint8_t *numRunningOn = mallocSet(ROM_LIMIT_8080);
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        analysis->instructions[address].isBlockStart = analysis->instructions[address].isEntryPoint;
+    }
+
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        const RomInstruction *instruction = &(analysis->instructions[address]);
+        if(!(instruction->isCode)){
+            continue;
+        }
+        if(fallsThrough(instruction, memory, (uint16_t)address)){
+            uint16_t nextAddress = instruction->successors[0];
+            numRunningOn[nextAddress]++;
+            if(numRunningOn[nextAddress] > 1){
+                analysis->instructions[nextAddress].isBlockStart = true;
+            }
+            continue;
+        }
+        for(uint8_t successorNum = 0; successorNum < instruction->numSuccessors; successorNum++){
+            analysis->instructions[instruction->successors[successorNum]].isBlockStart = true;
+        }
+    }
+
+    analysis->numBlocks = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        RomInstruction *instruction = &(analysis->instructions[address]);
+        instruction->isBlockStart = instruction->isBlockStart && instruction->isCode;
+        analysis->numBlocks += instruction->isBlockStart;
+    }
+
+    free(numRunningOn);
+}
+
+/**
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ * @param blockStart - Start of a block
+ * @return - Address of the block's last instruction
+ */
+uint16_t findLastInstruction(const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart)
+{
+    uint32_t lastAddress = blockStart;
+    uint32_t blockEnd = getBlockEnd(analysis, memory, blockStart);
+    while(lastAddress+instructionSizes[memory[lastAddress]] < blockEnd){
+        lastAddress += instructionSizes[memory[lastAddress]];
+    }
+
+    return (uint16_t)lastAddress;
+}
+
+/**
+ * @param opcode - An opcode
+ * @return - Whether the opcode is CALL, a conditional call or RST
+ */
+bool isCallOpcode(uint8_t opcode)
+{
+    return opcode == 0xcd || (opcode & 0xc7) == 0xc4 || (opcode & 0xc7) == 0xc7;
+}
+
+/**
+ * Finds the byte copy loops run with their source, destination and count all constant, such as the
+ * reset code filling RAM from ROM. Each block is followed on through jumps, calls and running on,
+ * for as long as it has only one way to continue, until it reaches a copy loop.
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ */
+void findBlockCopies(RomAnalysis *analysis, const uint8_t *memory)
+{
+    analysis->numBlockCopies = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080 && analysis->numBlockCopies < MAX_ROM_BLOCK_COPIES; address++){
+        if(!(analysis->instructions[address].isBlockStart)){
+            continue;
+        }
+
+        AbstractState abstract;
+        memset(&abstract, 0, sizeof(AbstractState));
+        uint16_t block = (uint16_t)address;
+        bool reachesCopy = false;
+        for(uint32_t blockNum = 0; blockNum < MAX_PATH_BLOCKS && !reachesCopy; blockNum++){
+            uint16_t lastAddress = findLastInstruction(analysis, memory, block);
+            for(uint32_t followed = block; followed <= lastAddress; followed += instructionSizes[memory[followed]]){
+                followInstruction(&abstract, memory, (uint16_t)followed);
+            }
+            const RomInstruction *last = &(analysis->instructions[lastAddress]);
+            if(last->unknownSuccessors || last->numSuccessors != 1){
+                break;
+            }
+            block = last->successors[0];
+            reachesCopy = isBlockCopyLoop(memory, block);
+        }
+        AbstractPair source = getAbstractPair(&abstract, 2);
+        AbstractPair destination = getAbstractPair(&abstract, 4);
+        const AbstractByte *count = &(abstract.registers[0]);
+        if(!reachesCopy || source.kind != PAIR_CONSTANT || destination.kind != PAIR_CONSTANT
+           || count->kind != PAIR_CONSTANT || count->isHigh){
+            continue;
+        }
+
+        RomBlockCopy copy;
+        copy.source = source.value;
+        copy.destination = destination.value;
+        copy.size = (count->value & 0xff) ? (count->value & 0xff) : 256;  // DCR B runs 256 times from 0
+        bool isNew = true;
+        for(uint32_t copyNum = 0; copyNum < analysis->numBlockCopies; copyNum++){
+            const RomBlockCopy *found = &(analysis->blockCopies[copyNum]);
+            isNew = isNew && (found->source != copy.source || found->destination != copy.destination || found->size != copy.size);
+        }
+        if(isNew && (uint32_t)copy.source+copy.size <= ROM_LIMIT_8080 && copy.destination >= ROM_LIMIT_8080
+           && (uint32_t)copy.destination+copy.size <= 0x10000){
+            analysis->blockCopies[analysis->numBlockCopies++] = copy;
+        }
+    }
+}
+
+/**
+ * @param memory - The 8080 memory
+ * @param address - An address in ROM
+ * @return - Whether a loop copying B bytes from DE on to HL starts there:
+ *           LDAX D, MOV M,A, INX H and INX D in either order, DCR B, then JNZ back to the LDAX D
+ */
+bool isBlockCopyLoop(const uint8_t *memory, uint32_t address)
+{
+    if(address+8 > ROM_LIMIT_8080){
+        return false;
+    }
+
+    const uint8_t *loop = &(memory[address]);
+    bool incrementsBoth = (loop[2] == 0x23 && loop[3] == 0x13) || (loop[2] == 0x13 && loop[3] == 0x23);
+    return loop[0] == 0x1a && loop[1] == 0x77 && incrementsBoth && loop[4] == 0x05 && loop[5] == 0xc2
+           && (uint32_t)(loop[6] | (loop[7]<<8)) == address;
+}
+
+/**
+ * Resolves every PCHL found so far, listing code they lead to that has not been found yet
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ * @param newEntryPoints - Set to the addresses of code not yet found, room for ROM_LIMIT_8080
+ * @return - Number of new entry points
+ */
+uint32_t resolveIndirectJumps(RomAnalysis *analysis, const uint8_t *memory, uint16_t *newEntryPoints)
+{
+    // Bytes of instructions found so far, a table entry must not point into the middle of one
+    bool *covered = mallocSet(ROM_LIMIT_8080*sizeof(bool));
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(analysis->instructions[address].isCode){
+            for(uint32_t byteNum = 0; byteNum < (uint32_t)instructionSizes[memory[address]] && address+byteNum < ROM_LIMIT_8080; byteNum++){
+                covered[address+byteNum] = true;
+            }
+        }
+    }
+
+    findBlockCopies(analysis, memory);
+    analysis->numIndirectJumps = 0;
+    uint32_t numNewEntryPoints = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(!(analysis->instructions[address].isBlockStart)){
+            continue;
+        }
+        uint16_t lastAddress = findLastInstruction(analysis, memory, (uint16_t)address);
+        if(memory[lastAddress] == 0xe9 && analysis->numIndirectJumps < MAX_ROM_INDIRECT_JUMPS){
+            numNewEntryPoints += resolveIndirectJump(analysis, memory, covered, (uint16_t)address, lastAddress,
+                                                     &(newEntryPoints[numNewEntryPoints]));
+        }
+    }
+
+    free(covered);
+    return numNewEntryPoints;
+}
+
+/**
+ * Follows the values of the register pairs through the block ending in a PCHL, and the blocks
+ * leading up to it, to find where it jumps
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ * @param covered - Bytes of every instruction found
+ * @param blockStart - Start of the block
+ * @param jumpAddress - Address of the PCHL ending the block
+ * @param newEntryPoints - Set to the addresses of code found that has not been found yet
+ * @return - Number of new entry points
+ */
+uint32_t resolveIndirectJump(RomAnalysis *analysis, const uint8_t *memory, const bool *covered, uint16_t blockStart,
+                             uint16_t jumpAddress, uint16_t *newEntryPoints)
+{
+    uint16_t path[MAX_PATH_BLOCKS];
+    uint32_t numPathBlocks = findBlockPath(analysis, memory, blockStart, path);
+    AbstractState abstract;
+    enterBlock(&abstract, analysis, memory, path[0]);
+    for(uint32_t pathNum = 0; pathNum < numPathBlocks; pathNum++){
+        uint32_t followedEnd = (pathNum == numPathBlocks-1) ? jumpAddress : getBlockEnd(analysis, memory, path[pathNum]);
+        for(uint32_t address = path[pathNum]; address < followedEnd; address += instructionSizes[memory[address]]){
+            followInstruction(&abstract, memory, (uint16_t)address);
+        }
+    }
+
+    RomIndirectJump *jump = &(analysis->indirectJumps[analysis->numIndirectJumps++]);
+    memset(jump, 0, sizeof(RomIndirectJump));
+    jump->address = jumpAddress;
+    uint16_t targets[MAX_JUMP_TABLE_ENTRIES+STACK_DEPTH_FOLLOWED];
+    uint32_t numTargets = 0;
+    AbstractPair hl = getAbstractPair(&abstract, 4);
+    if(hl.kind == PAIR_CONSTANT && isPlausibleCode(analysis, memory, covered, hl.value)){
+        jump->target = hl.value;
+        jump->numTargets = 1;
+        targets[numTargets++] = hl.value;
+    }else if(hl.kind == PAIR_TABLE_ENTRY && hl.stride >= 0){
+        jump->target = hl.value;
+        jump->isTable = true;
+        jump->stride = (hl.stride > 0) ? (uint16_t)hl.stride : 2;
+        // Entries are read until none of an entry's values points at code, the table runs into code,
+        // or its bytes are not known
+        bool entryFound = true;
+        for(uint32_t entryNum = 0; entryFound && numTargets < MAX_JUMP_TABLE_ENTRIES; entryNum++){
+            uint16_t values[MAX_ROM_BLOCK_COPIES];
+            uint32_t numValues = readTableWords(analysis, memory, covered, (uint32_t)hl.value+jump->stride*entryNum, values);
+            entryFound = false;
+            for(uint32_t valueNum = 0; valueNum < numValues && numTargets < MAX_JUMP_TABLE_ENTRIES; valueNum++){
+                if(isPlausibleCode(analysis, memory, covered, values[valueNum])){
+                    targets[numTargets++] = values[valueNum];
+                    entryFound = true;
+                }
+            }
+        }
+        jump->numTargets = (uint8_t)numTargets;
+    }
+
+    // Constant ROM addresses pushed on the way to the jump are where the code jumped to returns
+    for(uint32_t entryNum = 0; entryNum < abstract.stackDepth; entryNum++){
+        AbstractPair pushed = abstract.stack[entryNum];
+        if(pushed.kind == PAIR_CONSTANT && isPlausibleCode(analysis, memory, covered, pushed.value)){
+            targets[numTargets++] = pushed.value;
+        }
+    }
+
+    uint32_t numNewEntryPoints = 0;
+    for(uint32_t targetNum = 0; targetNum < numTargets; targetNum++){
+        if(!(analysis->instructions[targets[targetNum]].isCode)){
+            newEntryPoints[numNewEntryPoints++] = targets[targetNum];
+        }
+    }
+    return numNewEntryPoints;
+}
+
+/**
+ * Finds the blocks leading up to a block, going back for as long as there is only one way into the next
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ * @param blockStart - Start of the last block
+ * @param path - Set to the starts of the blocks, the last block's last, room for MAX_PATH_BLOCKS
+ * @return - Number of blocks in the path
+ */
+uint32_t findBlockPath(const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart, uint16_t *path)
+{
+    // Found backwards, from the last block
+    uint16_t reversedPath[MAX_PATH_BLOCKS];
+    uint32_t numPathBlocks = 0;
+    uint16_t current = blockStart;
+    while(1){
+        reversedPath[numPathBlocks++] = current;
+        uint16_t predecessors[MAX_PREDECESSORS];
+        if(numPathBlocks == MAX_PATH_BLOCKS || analysis->instructions[current].isEntryPoint
+           || findPredecessors(analysis, memory, current, predecessors) != 1){
+            break;
+        }
+        current = predecessors[0];
+    }
+
+    for(uint32_t pathNum = 0; pathNum < numPathBlocks; pathNum++){
+        path[pathNum] = reversedPath[numPathBlocks-1-pathNum];
+    }
+    return numPathBlocks;
+}
+
+/**
+ * Finds the blocks that jump, call or run on into a block, not counting the calls returning to it
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ * @param blockStart - Start of the block
+ * @param predecessors - Set to the starts of the blocks, room for MAX_PREDECESSORS
+ * @return - Number of blocks found, only the first MAX_PREDECESSORS are listed
+ */
+uint32_t findPredecessors(const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart, uint16_t *predecessors)
+{
+    uint32_t numPredecessors = 0;
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(!(analysis->instructions[address].isBlockStart)){
+            continue;
+        }
+        const RomInstruction *last = &(analysis->instructions[findLastInstruction(analysis, memory, (uint16_t)address)]);
+        for(uint8_t successorNum = 0; successorNum < last->numSuccessors; successorNum++){
+            if(last->successors[successorNum] == blockStart){
+                if(numPredecessors < MAX_PREDECESSORS){
+                    predecessors[numPredecessors] = (uint16_t)address;
+                }
+                numPredecessors++;
+                break;
+            }
+        }
+    }
+
+    return numPredecessors;
+}
+
+/**
+ * Sets the register pairs to their values on entering a block with several ways in, from the blocks
+ * leading into it, each followed on its own. A pair holding the same constant on every way in keeps it.
+ * At a loop's head, the blocks jumping back to it are not ways in; there a pair every way back steps by
+ * the same amount, that holds constants on the ways in that are all whole steps apart, is the base of
+ * a table whose entries are that far apart, starting at the lowest constant.
+ * @param abstract - Set to the registers, with nothing known but the pairs, and nothing on the stack
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ * @param blockStart - Start of the block
+ */
+void enterBlock(AbstractState *abstract, const RomAnalysis *analysis, const uint8_t *memory, uint16_t blockStart)
+{
+    memset(abstract, 0, sizeof(AbstractState));
+    uint16_t predecessors[MAX_PREDECESSORS];
+    uint32_t numPredecessors = findPredecessors(analysis, memory, blockStart, predecessors);
+    if(analysis->instructions[blockStart].isEntryPoint || numPredecessors == 0 || numPredecessors > MAX_PREDECESSORS){
+        return;
+    }
+    int16_t steps[3];
+    bool stepsKnown[3];
+    uint32_t loopEnd = followLoop(analysis, memory, blockStart, steps, stepsKnown);
+
+    for(uint8_t pairNum = 0; pairNum < 3; pairNum++){
+        uint8_t highRegister = (uint8_t)(2*pairNum);
+        int16_t step = (loopEnd != 0) ? steps[pairNum] : 0;
+        bool isKnown = (loopEnd == 0 || stepsKnown[pairNum]) && step >= 0;
+        uint32_t numWaysIn = 0;
+        uint16_t values[MAX_PREDECESSORS];
+        uint16_t lowest = 0xffff;
+        for(uint32_t predecessorNum = 0; predecessorNum < numPredecessors && isKnown; predecessorNum++){
+            uint16_t predecessor = predecessors[predecessorNum];
+            if(predecessor >= blockStart && predecessor < loopEnd){
+                continue;
+            }
+            AbstractState wayIn;
+            memset(&wayIn, 0, sizeof(AbstractState));
+            uint16_t lastAddress = findLastInstruction(analysis, memory, predecessor);
+            for(uint32_t address = predecessor; address <= lastAddress; address += instructionSizes[memory[address]]){
+                followInstruction(&wayIn, memory, (uint16_t)address);
+            }
+            AbstractPair pair = getAbstractPair(&wayIn, highRegister);
+            isKnown = pair.kind == PAIR_CONSTANT;
+            values[numWaysIn++] = pair.value;
+            lowest = (pair.value < lowest) ? pair.value : lowest;
+        }
+        for(uint32_t wayInNum = 0; wayInNum < numWaysIn && isKnown; wayInNum++){
+            uint16_t apart = (uint16_t)(values[wayInNum]-lowest);
+            isKnown = (step == 0) ? apart == 0 : apart % step == 0;
+        }
+
+        AbstractPair entered = {PAIR_UNKNOWN, 0, 0, 0};
+        if(isKnown && numWaysIn > 0){
+            entered.kind = (step == 0) ? PAIR_CONSTANT : PAIR_INDEXED;
+            entered.value = lowest;
+            entered.stride = step;
+        }
+        setAbstractPair(abstract, highRegister, entered);
+    }
+}
+
+/**
+ * Follows every path from a block that may be a loop's head, without following calls,
+ * to find how much each register pair changes by on the way back to it
+ * @param analysis - The analysis, with the code and blocks found
+ * @param memory - The 8080 memory
+ * @param loopHead - Start of the block
+ * @param steps - Set to each pair's change, B, D then H, where stepsKnown
+ * @param stepsKnown - Set to whether every way back found changes the pair by the same amount
+ * @return - One past the last block found jumping back to the head, 0 if there is none or
+ *           the paths could not all be followed
+ */
+uint32_t followLoop(const RomAnalysis *analysis, const uint8_t *memory, uint16_t loopHead, int16_t *steps,
+                    bool *stepsKnown)
+{
+    // Blocks still to be followed, with the registers on the way into each. Each pair starts as
+    // a table indexed from its own number, so that where its value goes can be told apart.
+    AbstractState *states = mallocSet(MAX_LOOP_BLOCKS*sizeof(AbstractState));
+    uint16_t blocks[MAX_LOOP_BLOCKS];
+    bool stepsFound[3] = {false, false, false};
+    for(uint8_t pairNum = 0; pairNum < 3; pairNum++){
+        AbstractPair indexed = {PAIR_INDEXED, pairNum, 0, 0};
+        setAbstractPair(&(states[0]), (uint8_t)(2*pairNum), indexed);
+        stepsKnown[pairNum] = true;
+    }
+    blocks[0] = loopHead;
+    uint32_t numPending = 1;
+    uint32_t numFollowed = 0;
+    uint32_t loopEnd = 0;
+    bool tooManyPaths = false;
+
+    while(numPending > 0 && !tooManyPaths){
+        numPending--;
+        AbstractState abstract = states[numPending];
+        uint16_t block = blocks[numPending];
+        uint16_t lastAddress = findLastInstruction(analysis, memory, block);
+        for(uint32_t address = block; address <= lastAddress; address += instructionSizes[memory[address]]){
+            followInstruction(&abstract, memory, (uint16_t)address);
+        }
+        if(isCallOpcode(memory[lastAddress])){
+            continue;
+        }
+
+        const RomInstruction *last = &(analysis->instructions[lastAddress]);
+        for(uint8_t successorNum = 0; successorNum < last->numSuccessors; successorNum++){
+            uint16_t successor = last->successors[successorNum];
+            if(successor != loopHead && (++numFollowed >= MAX_LOOP_BLOCKS || numPending == MAX_LOOP_BLOCKS)){
+                tooManyPaths = true;
+                break;
+            }else if(successor != loopHead){
+                states[numPending] = abstract;
+                blocks[numPending] = successor;
+                numPending++;
+                continue;
+            }
+
+            uint32_t blockEnd = getBlockEnd(analysis, memory, block);
+            loopEnd = (blockEnd > loopEnd) ? blockEnd : loopEnd;
+            for(uint8_t pairNum = 0; pairNum < 3; pairNum++){
+                AbstractPair pair = getAbstractPair(&abstract, (uint8_t)(2*pairNum));
+                bool sameStep = !stepsFound[pairNum] || pair.offset == steps[pairNum];
+                stepsKnown[pairNum] = stepsKnown[pairNum] && pair.kind == PAIR_INDEXED && pair.value == pairNum && sameStep;
+                steps[pairNum] = pair.offset;
+                stepsFound[pairNum] = true;
+            }
+        }
+    }
+
+    free(states);
+    return tooManyPaths ? 0 : loopEnd;
+}
+
+/**
+ * Reads a word of a jump table, from ROM, or from RAM as the block copies found fill it from ROM
+ * @param analysis - The analysis, with the block copies found
+ * @param memory - The 8080 memory
+ * @param covered - Bytes of every instruction found
+ * @param address - Address of the word
+ * @param words - Set to the values the word may have, one for ROM and one for each copy filling
+ *                RAM differently, room for MAX_ROM_BLOCK_COPIES
+ * @return - Number of values, 0 if the word's bytes are not known or are part of an instruction
+ */
+uint32_t readTableWords(const RomAnalysis *analysis, const uint8_t *memory, const bool *covered, uint32_t address,
+                        uint16_t *words)
+{
+    if(address+1 < ROM_LIMIT_8080){
+        if(covered[address] || covered[address+1]){
+            return 0;
+        }
+        words[0] = (uint16_t)(memory[address] | (memory[address+1]<<8));
+        return 1;
+    }
+
+    uint32_t numWords = 0;
+    for(uint32_t copyNum = 0; copyNum < analysis->numBlockCopies; copyNum++){
+        const RomBlockCopy *copy = &(analysis->blockCopies[copyNum]);
+        if(address < copy->destination || address+1 >= (uint32_t)copy->destination+copy->size){
+            continue;
+        }
+        uint32_t romAddress = copy->source+(address-copy->destination);
+        if(covered[romAddress] || covered[romAddress+1]){
+            continue;
+        }
+        uint16_t word = (uint16_t)(memory[romAddress] | (memory[romAddress+1]<<8));
+        bool isNew = true;
+        for(uint32_t wordNum = 0; wordNum < numWords; wordNum++){
+            isNew = isNew && words[wordNum] != word;
+        }
+        if(isNew){
+            words[numWords++] = word;
+        }
+    }
+
+    return numWords;
+}
+
+/**
+ * Updates the register pairs and stack for one instruction of a block. Only the ways of
+ * building addresses that jump tables are read with are followed, anything else writing a
+ * register leaves it unknown.
+ * @param abstract - Registers and stack before the instruction
+ * @param memory - The 8080 memory
+ * @param address - Address of the instruction
+ */
+void followInstruction(AbstractState *abstract, const uint8_t *memory, uint16_t address)
+{
+    uint8_t opcode = memory[address];
+    uint8_t destination = (opcode>>3) & 0x07;
+    uint8_t source = opcode & 0x07;
+    uint8_t pairRegister = (opcode>>3) & 0x06;  // B, D, H, or SP as 6
+    AbstractPair immediate = {PAIR_CONSTANT, 0, 0, 0};
+    if(instructionSizes[opcode] == 3 && address+2 < ROM_LIMIT_8080){
+        immediate.value = (uint16_t)(memory[address+1] | (memory[address+2]<<8));
+    }else if(instructionSizes[opcode] == 2 && address+1 < ROM_LIMIT_8080){
+        immediate.value = memory[address+1];
+    }
+    AbstractByte unknown;
+    memset(&unknown, 0, sizeof(AbstractByte));
+
+    if(opcode >= 0x40 && opcode < 0x80 && opcode != 0x76){
+        // MOV, from memory only through a pair whose value is known
+        if(destination == 6){
+            return;
+        }else if(source != 6){
+            abstract->registers[destination] = abstract->registers[source];
+            return;
+        }
+        AbstractPair hl = getAbstractPair(abstract, 4);
+        AbstractByte loaded = unknown;
+        if(hl.kind == PAIR_CONSTANT && hl.value < ROM_LIMIT_8080){
+            loaded.kind = PAIR_CONSTANT;
+            loaded.value = memory[hl.value];
+        }else if(hl.kind == PAIR_INDEXED){
+            // A byte of a table entry, paired up with the entry's other byte by where each was loaded from
+            loaded.kind = PAIR_TABLE_ENTRY;
+            loaded.value = (uint16_t)(hl.value+hl.offset);
+            loaded.stride = hl.stride;
+        }
+        abstract->registers[destination] = loaded;
+    }else if(opcode < 0x40 && (source == 0x06 || source == 0x04 || source == 0x05) && destination != 6){
+        // MVI, INR and DCR on registers
+        AbstractByte *reg = &(abstract->registers[destination]);
+        if(source == 0x06){
+            *reg = unknown;
+            reg->kind = PAIR_CONSTANT;
+            reg->value = immediate.value;
+        }else if(reg->kind == PAIR_CONSTANT && !(reg->isHigh)){
+            reg->value = (uint8_t)(reg->value+((source == 0x04) ? 1 : -1));
+        }else{
+            *reg = unknown;
+        }
+    }else if(opcode < 0x40 && (opcode & 0x0f) == 0x01 && pairRegister != 6){
+        setAbstractPair(abstract, pairRegister, immediate);  // LXI
+    }else if(opcode < 0x40 && ((opcode & 0x0f) == 0x03 || (opcode & 0x0f) == 0x0b) && pairRegister != 6){
+        // INX and DCX
+        AbstractPair pair = getAbstractPair(abstract, pairRegister);
+        int16_t step = ((opcode & 0x0f) == 0x03) ? 1 : -1;
+        if(pair.kind == PAIR_CONSTANT){
+            pair.value = (uint16_t)(pair.value+step);
+        }else if(pair.kind == PAIR_INDEXED){
+            pair.offset = (int16_t)(pair.offset+step);
+        }else{
+            pair.kind = PAIR_UNKNOWN;
+        }
+        setAbstractPair(abstract, pairRegister, pair);
+    }else if(opcode < 0x40 && (opcode & 0x0f) == 0x09){
+        // DAD, a pair with an unknown value added to a constant is taken to be an index
+        AbstractPair added = {PAIR_UNKNOWN, 0, 0, 0};
+        if(pairRegister != 6){
+            added = getAbstractPair(abstract, pairRegister);
+        }
+        setAbstractPair(abstract, 4, addAbstractPairs(getAbstractPair(abstract, 4), added));
+    }else if(opcode == 0x2a){
+        // LHLD
+        AbstractPair loaded = {PAIR_UNKNOWN, 0, 0, 0};
+        if(immediate.value+1 < ROM_LIMIT_8080){
+            loaded.kind = PAIR_CONSTANT;
+            loaded.value = (uint16_t)(memory[immediate.value] | (memory[immediate.value+1]<<8));
+        }
+        setAbstractPair(abstract, 4, loaded);
+    }else if(opcode == 0xeb){
+        // XCHG
+        AbstractPair de = getAbstractPair(abstract, 2);
+        setAbstractPair(abstract, 2, getAbstractPair(abstract, 4));
+        setAbstractPair(abstract, 4, de);
+    }else if(opcode == 0xe3){
+        // XTHL
+        AbstractPair hl = getAbstractPair(abstract, 4);
+        AbstractPair top = {PAIR_UNKNOWN, 0, 0, 0};
+        if(abstract->stackDepth > 0){
+            top = abstract->stack[abstract->stackDepth-1];
+            abstract->stack[abstract->stackDepth-1] = hl;
+        }
+        setAbstractPair(abstract, 4, top);
+    }else if((opcode & 0xcf) == 0xc5){
+        // PUSH, the oldest entry is dropped if the stack followed is full
+        AbstractPair pushed = {PAIR_UNKNOWN, 0, 0, 0};
+        if(pairRegister != 6){
+            pushed = getAbstractPair(abstract, pairRegister);
+        }
+        if(abstract->stackDepth == STACK_DEPTH_FOLLOWED){
+            memmove(&(abstract->stack[0]), &(abstract->stack[1]), (STACK_DEPTH_FOLLOWED-1)*sizeof(AbstractPair));
+            abstract->stackDepth--;
+        }
+        abstract->stack[abstract->stackDepth++] = pushed;
+    }else if((opcode & 0xcf) == 0xc1){
+        // POP
+        AbstractPair popped = {PAIR_UNKNOWN, 0, 0, 0};
+        if(abstract->stackDepth > 0){
+            popped = abstract->stack[--(abstract->stackDepth)];
+        }
+        if(pairRegister != 6){
+            setAbstractPair(abstract, pairRegister, popped);
+        }else{
+            abstract->registers[7] = unknown;
+        }
+    }else if(opcode == 0x31 || opcode == 0xf9){
+        abstract->stackDepth = 0;  // LXI SP and SPHL move to a stack nothing is known about
+    }else{
+        // Every other instruction writes no register but the accumulator
+        abstract->registers[7] = unknown;
+    }
+}
+
+/**
+ * @param abstract - Registers while following a block
+ * @param highRegister - Number of the pair's high register: B, D or H
+ * @return - The pair's value, unknown unless both of its registers hold the two halves of one value
+ */
+AbstractPair getAbstractPair(const AbstractState *abstract, uint8_t highRegister)
+{
+    const AbstractByte *high = &(abstract->registers[highRegister]);
+    const AbstractByte *low = &(abstract->registers[highRegister+1]);
+    AbstractPair pair = {PAIR_UNKNOWN, 0, 0, 0};
+
+    if(high->kind == PAIR_CONSTANT && low->kind == PAIR_CONSTANT && !(high->isHigh) && !(low->isHigh)){
+        // Two separately loaded bytes
+        pair.kind = PAIR_CONSTANT;
+        pair.value = (uint16_t)(((high->value & 0xff)<<8) | (low->value & 0xff));
+    }else if(high->kind == PAIR_TABLE_ENTRY && low->kind == PAIR_TABLE_ENTRY && high->value == low->value+1
+             && high->stride == low->stride){
+        // The two bytes of a table entry, the low one first
+        pair.kind = PAIR_TABLE_ENTRY;
+        pair.value = low->value;
+        pair.stride = low->stride;
+    }else if(high->kind == PAIR_INDEXED && low->kind == PAIR_INDEXED && high->isHigh && !(low->isHigh)
+             && high->value == low->value && high->offset == low->offset && high->stride == low->stride){
+        pair.kind = PAIR_INDEXED;
+        pair.value = high->value;
+        pair.offset = high->offset;
+        pair.stride = high->stride;
+    }
+
+    return pair;
+}
+
+/**
+ * Sets a register pair's value while following a block
+ * @param abstract - Registers while following a block
+ * @param highRegister - Number of the pair's high register: B, D or H
+ * @param pair - The value
+ */
+void setAbstractPair(AbstractState *abstract, uint8_t highRegister, AbstractPair pair)
+{
+    AbstractByte *high = &(abstract->registers[highRegister]);
+    AbstractByte *low = &(abstract->registers[highRegister+1]);
+    high->kind = pair.kind;
+    high->isHigh = true;
+    high->value = pair.value;
+    high->offset = pair.offset;
+    high->stride = pair.stride;
+    *low = *high;
+    low->isHigh = false;
+
+    // Constants are split into bytes, so either register can be used on its own
+    if(pair.kind == PAIR_CONSTANT){
+        high->isHigh = false;
+        high->value = (uint16_t)(pair.value>>8);
+        low->value = (uint16_t)(pair.value & 0xff);
+    }else if(pair.kind == PAIR_TABLE_ENTRY){
+        high->value = (uint16_t)(pair.value+1);
+    }
+}
+
+/**
+ * Adds two register pair values, as DAD does
+ * @return - The sum: a constant plus an unknown value is taken to be a table indexed by that value
+ */
+AbstractPair addAbstractPairs(AbstractPair first, AbstractPair second)
+{
+    AbstractPair sum = {PAIR_UNKNOWN, 0, 0, 0};
+
+    if(first.kind == PAIR_CONSTANT && second.kind == PAIR_CONSTANT){
+        sum.kind = PAIR_CONSTANT;
+        sum.value = (uint16_t)(first.value+second.value);
+    }else if(first.kind == PAIR_INDEXED && second.kind == PAIR_CONSTANT){
+        sum = first;
+        sum.offset = (int16_t)(first.offset+(int16_t)second.value);
+    }else if(first.kind == PAIR_CONSTANT && second.kind == PAIR_INDEXED){
+        sum = second;
+        sum.offset = (int16_t)(second.offset+(int16_t)first.value);
+    }else if(first.kind == PAIR_CONSTANT && second.kind != PAIR_CONSTANT){
+        sum.kind = PAIR_INDEXED;
+        sum.value = first.value;
+    }else if(second.kind == PAIR_CONSTANT && first.kind != PAIR_CONSTANT){
+        sum.kind = PAIR_INDEXED;
+        sum.value = second.value;
+    }
+
+    return sum;
+}
+
+/**
+ * @param analysis - The analysis, with the code found so far
+ * @param memory - The 8080 memory
+ * @param covered - Bytes of every instruction found
+ * @param address - An address an indirect jump may lead to
+ * @return - Whether an instruction could start there: in ROM, either the start of a block already or not
+ *           part of any instruction, and not an opcode the 8080 does not define
+ */
+bool isPlausibleCode(const RomAnalysis *analysis, const uint8_t *memory, const bool *covered, uint32_t address)
+{
+    if(address >= ROM_LIMIT_8080){
+        return false;
+    }else if(analysis->instructions[address].isCode){
+        return analysis->instructions[address].isBlockStart;
+    }
+
+    return !covered[address] && !isUndefinedOpcode(memory[address]);
+}
+
+/**
+ * Finds the flags live before and after every instruction, by repeating
+ * liveIn = read | (liveOut & ~written) and liveOut = the union of the successors' liveIn
+ * until nothing changes
+ * @param analysis - The analysis, with the code and its successors found
+ */
+void findLiveFlags(RomAnalysis *analysis)
+{
+    bool changed = true;
+    while(changed){
+        changed = false;
+        // Backwards through ROM, the direction flags flow in, so most of it settles in a few passes
+        for(int32_t address = ROM_LIMIT_8080-1; address >= 0; address--){
+            RomInstruction *instruction = &(analysis->instructions[address]);
+            if(!(instruction->isCode)){
+                continue;
+            }
+
+            uint8_t liveOut = instruction->unknownSuccessors ? ALL_FLAGS : 0;
+            for(uint8_t successorNum = 0; successorNum < instruction->numSuccessors; successorNum++){
+                liveOut |= analysis->instructions[instruction->successors[successorNum]].liveFlagsIn;
+            }
+            uint8_t liveIn = instruction->flagsRead | (liveOut & ~(instruction->flagsWritten));
+            if(liveOut != instruction->liveFlagsOut || liveIn != instruction->liveFlagsIn){
+                instruction->liveFlagsOut = liveOut;
+                instruction->liveFlagsIn = liveIn;
+                changed = true;
+            }
+        }
+    }
+}
+
+/**
+ * Finds, for each instruction writing dead flags, the most instructions any path takes to
+ * overwrite all of them. Found per flag as the longest path from each instruction up to one
+ * writing the flag, grown until nothing changes, with paths of FLAG_KILL_LIMIT or more
+ * instructions counting as never overwriting it.
+ * @param analysis - The analysis, with the live flags found
+ */
+void findKillDistances(RomAnalysis *analysis)
+{
+    uint8_t *distances = mallocSet(NUM_FLAGS*ROM_LIMIT_8080);  // Instructions up to and including the next write
+    for(unsigned int flagNum = 0; flagNum < NUM_FLAGS; flagNum++){
+        uint8_t flag = (uint8_t)(1<<flagNum);
+        uint8_t *flagDistances = &(distances[flagNum*ROM_LIMIT_8080]);
+        memset(flagDistances, 1, ROM_LIMIT_8080);
+
+        bool changed = true;
+        while(changed){
+            changed = false;
+            for(int32_t address = ROM_LIMIT_8080-1; address >= 0; address--){
+                const RomInstruction *instruction = &(analysis->instructions[address]);
+                if(!(instruction->isCode) || (instruction->flagsWritten & flag)){
+                    continue;
+                }
+
+                unsigned int distance = FLAG_KILL_LIMIT;
+                if(!(instruction->unknownSuccessors)){
+                    unsigned int longestSuccessor = 0;
+                    for(uint8_t successorNum = 0; successorNum < instruction->numSuccessors; successorNum++){
+                        unsigned int successorDistance = flagDistances[instruction->successors[successorNum]];
+                        if(successorDistance > longestSuccessor){
+                            longestSuccessor = successorDistance;
+                        }
+                    }
+                    distance = (longestSuccessor+1 < FLAG_KILL_LIMIT) ? longestSuccessor+1 : FLAG_KILL_LIMIT;
+                }
+                if(distance > flagDistances[address]){
+                    flagDistances[address] = (uint8_t)distance;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        RomInstruction *instruction = &(analysis->instructions[address]);
+        uint8_t deadFlags = instruction->flagsWritten & ~(instruction->liveFlagsOut);
+        if(!(instruction->isCode) || deadFlags == 0){
+            continue;
+        }
+
+        unsigned int killDistance = 0;
+        for(unsigned int flagNum = 0; flagNum < NUM_FLAGS; flagNum++){
+            if(!(deadFlags & (1<<flagNum))){
+                continue;
+            }
+            for(uint8_t successorNum = 0; successorNum < instruction->numSuccessors; successorNum++){
+                unsigned int distance = distances[flagNum*ROM_LIMIT_8080+instruction->successors[successorNum]];
+                if(distance > killDistance){
+                    killDistance = distance;
+                }
+            }
+        }
+        instruction->killDistance = (killDistance < FLAG_KILL_LIMIT) ? (uint8_t)killDistance : 0;
+    }
+
+    free(distances);
+}
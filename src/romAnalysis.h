@@ -0,0 +1,140 @@
+/***********************************************************************************
+ *
+ * Header for static analysis of the 8080 ROM.
+ *
+ * The ROM's control flow is recovered by following every path from the reset and
+ * interrupt vectors, and for each instruction reached, the flags it reads and writes
+ * are combined over the control flow graph into the flags that are live before and
+ * after it: those that some path goes on to read before overwriting them. Flags an
+ * instruction writes that are not live after it are dead, and may be left uncomputed.
+ *
+ * The instructions found are split into basic blocks. Each PCHL is resolved heuristically
+ * by following the values of the register pairs through its block, and through the blocks
+ * before it for as long as each is the only way into the next: a constant loaded into
+ * HL is a single target, and a word loaded through HL from a constant base plus an index is
+ * an entry of a jump table, whose entries are read for as long as they look like code.
+ * A pair entering a loop's head as constants that every way back steps by the same amount
+ * is such a base, with entries that far apart. Tables in RAM are read from the ROM bytes that
+ * block copies with constant source, destination and count fill them with, as the reset code
+ * does with the game's initial RAM; an entry different copies fill differently has each of
+ * their values. Constant ROM addresses left on the stack at a PCHL are taken to be return
+ * addresses. Code found this way is analyzed in turn, until no new code turns up.
+ *
+ * Control flow the analysis cannot follow (RET, PCHL, jumps out of ROM and opcodes the
+ * 8080 does not define) is assumed to read every flag, even where PCHL was resolved. Interrupts are not followed,
+ * as they may happen after any instruction; engines leaving dead flags uncomputed must
+ * make sure each is overwritten before an interrupt is taken (see killDistance).
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_ROMANALYSIS_H
+#define INTEL_8080_EMULATOR_ROMANALYSIS_H
+
+#include "cpuStructures.h"
+#include "opcodeSpec.h"
+
+#define MAX_INSTRUCTION_CYCLES 18  // XTHL, the slowest 8080 instruction
+#define FLAG_KILL_LIMIT 32  // Instructions followed looking for a dead flag to be overwritten
+#define MAX_ROM_INDIRECT_JUMPS 64
+#define MAX_JUMP_TABLE_ENTRIES 128
+#define MAX_ROM_BLOCK_COPIES 32
+
+/**
+ * What the analysis found out about one ROM address
+ */
+typedef struct RomInstruction{
+    bool isCode;  /**< An instruction starting here is reached from an entry point */
+    bool isEntryPoint;  /**< Reached other than through a successor: a vector, a call's return, or an indirect jump */
+    bool isCallTarget;  /**< Start of a routine called by CALL, a conditional call or RST */
+    bool isBlockStart;  /**< First instruction of a basic block */
+    bool unknownSuccessors;  /**< Execution may continue somewhere the analysis cannot follow */
+    uint8_t numSuccessors;
+    uint16_t successors[2];  /**< Addresses execution continues at, besides any unknown ones */
+    uint8_t flagsRead;
+    uint8_t flagsWritten;
+    uint8_t liveFlagsIn;  /**< Flags that may be read before being overwritten, from before this instruction */
+    uint8_t liveFlagsOut;  /**< Same, from after this instruction */
+    uint8_t killDistance;  /**< Most instructions, counting from the next one, until every dead flag this
+                                instruction writes has been overwritten; 0 if none are dead, or if some path
+                                takes FLAG_KILL_LIMIT instructions or more */
+} RomInstruction;
+
+/**
+ * What the analysis found out about a PCHL
+ */
+typedef struct RomIndirectJump{
+    uint16_t address;  /**< Address of the PCHL */
+    uint16_t target;  /**< The jump table, or the one address jumped to if isTable is false */
+    uint8_t numTargets;  /**< Addresses read from the table, 1 for a single target, 0 if unresolved */
+    bool isTable;
+    uint16_t stride;  /**< Bytes from one table entry to the next, more than 2 for a table of records */
+} RomIndirectJump;
+
+/**
+ * ROM bytes copied to RAM by a loop whose source, destination and count are all constant
+ */
+typedef struct RomBlockCopy{
+    uint16_t source;  /**< ROM address copied from */
+    uint16_t destination;  /**< RAM address copied to */
+    uint16_t size;  /**< Bytes copied, at most 256 */
+} RomBlockCopy;
+
+typedef struct RomAnalysis{
+    RomInstruction instructions[ROM_LIMIT_8080];
+    uint32_t numInstructions;  /**< Addresses found to be code */
+    uint32_t numBlocks;
+    RomIndirectJump indirectJumps[MAX_ROM_INDIRECT_JUMPS];  /**< Every PCHL found, in address order */
+    uint32_t numIndirectJumps;
+    RomBlockCopy blockCopies[MAX_ROM_BLOCK_COPIES];  /**< Every constant block copy found, each once */
+    uint32_t numBlockCopies;
+} RomAnalysis;
+
+/**
+ * Recovers the ROM's control flow and the flags live at each instruction
+ * @param memory - The 8080 memory, only ROM is read
+ * @return - pointer to the analysis
+ */
+RomAnalysis *analyzeRom(const uint8_t *memory);
+
+/**
+ * Analyzes the ROM starting from the given entry points as well as the vectors, e.g. addresses
+ * a hotness profile saw basic blocks entered at, which finds code reached only through jumps
+ * the analysis cannot resolve. Entry points the vectors already lead to are not marked as such.
+ * @param memory - The 8080 memory, only ROM is read
+ * @param entryPoints - Addresses of instructions known to run, those outside of ROM are skipped
+ * @param numEntryPoints - Number of entry points
+ * @return - pointer to the analysis
+ */
+RomAnalysis *analyzeRomFrom(const uint8_t *memory, const uint16_t *entryPoints, uint32_t numEntryPoints);
+
+/**
+ * @param analysis - The analysis
+ * @param memory - The 8080 memory the analysis was made of
+ * @param address - Address of an instruction found to be code
+ * @return - Address one past the last byte of the basic block starting at or running on through the address
+ */
+uint32_t getBlockEnd(const RomAnalysis *analysis, const uint8_t *memory, uint16_t address);
+
+/**
+ * Frees an analysis
+ * @param analysis - The analysis, may be NULL
+ */
+void destroyRomAnalysis(RomAnalysis *analysis);
+
+/**
+ * @param analysis - The analysis
+ * @param address - An address
+ * @return - Flags live before the instruction at the address, ALL_FLAGS if it is not known to be code
+ */
+uint8_t getLiveFlags(const RomAnalysis *analysis, uint16_t address);
+
+/**
+ * Finds the flags an opcode reads and writes, as the reference engine executes it, from the opcode specification
+ * @param opcode - The opcode
+ * @param flagsRead - Set to the flags whose value before the instruction affects it
+ * @param flagsWritten - Set to the flags the instruction sets
+ */
+void getOpcodeFlags(uint8_t opcode, uint8_t *flagsRead, uint8_t *flagsWritten);
+
+#endif //INTEL_8080_EMULATOR_ROMANALYSIS_H
@@ -0,0 +1,272 @@
+/***********************************************************************************
+ *
+ * Recovers the control flow graph of the ROM and writes it to a text file.
+ *
+ * The ROM is followed from the reset and interrupt vectors (see romAnalysis.h), and split
+ * into basic blocks. Every block is written with its size and where it continues, calls
+ * apart from jumps, followed by the routines called, the ROM copied to RAM by constant block
+ * copies, the PCHL jump tables resolved and those that could not be, and the regions of ROM
+ * never reached. Those are unknown rather than data: they hold data, or code only a jump the
+ * analysis cannot follow leads to. A hotness profile recorded with --hotness adds every address
+ * it saw a block entered at as an entry point, covering the jumps the analysis cannot resolve
+ * on its own.
+ *
+ * File layout, one item per line, addresses and sizes in hex, anything after a ';' a comment:
+ * entry ADDRESS                      Vector, return address or other way into the ROM
+ * block START SIZE -> SUCCESSOR...   A basic block and the blocks it continues at,
+ *                                    '?' where execution continues somewhere not known
+ * block START SIZE call TARGET -> RETURN   A block ending in a call
+ * routine ADDRESS                    Start of a routine that is called
+ * copy SOURCE DESTINATION SIZE       ROM bytes copied to RAM, which jump tables in RAM are read from
+ * table ADDRESS TARGETS JUMP STRIDE  Jump table read by the PCHL at JUMP, STRIDE bytes from one entry to the next
+ * target ADDRESS JUMP                Single address the PCHL at JUMP goes to
+ * unresolved JUMP                    PCHL whose targets were not found
+ * unknown START SIZE                 Bytes never reached, data or code alike
+ *
+ * Usage: rom_graph OUTPUT [--resources DIR] [--hotness FILE] [--symbols FILE]
+ * --resources DIR  Analyze the ROM set in DIR instead of the embedded ROM
+ * --hotness FILE   Hotness profile whose block entries are also entry points
+ * --symbols FILE   Symbol map to name the blocks and routines with, e.g. resources/invaders.sym
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "shell8080.h"
+#include "romAnalysis.h"
+#include "opcodeSpec.h"
+#include "romLoader.h"
+#include "embeddedAssets.h"
+#include "hotnessProfile.h"
+#include "symbolMap.h"
+#include "helpers.h"
+
+int writeRomGraph(const RomAnalysis *analysis, const uint8_t *rom, const SymbolMap *symbols, const char *path);
+void writeBlock(FILE *file, const RomAnalysis *analysis, const uint8_t *rom, uint16_t blockStart);
+void writeSymbolComment(FILE *file, const SymbolMap *symbols, uint16_t address);
+uint32_t countUnknownRegions(const RomAnalysis *analysis, const uint8_t *rom, FILE *file, uint32_t *numUnknownBytes);
+
+int main(int argc, char **argv)
+{
+    if(argc < 2){
+        logger("Usage: %s OUTPUT [--resources DIR] [--hotness FILE] [--symbols FILE]\n", argv[0]);
+        return 1;
+    }
+
+    const char *resourcePath = NULL;
+    const char *hotnessPath = NULL;
+    const char *symbolPath = NULL;
+    for(int argNum = 2; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--resources") == 0 && argNum+1 < argc){
+            argNum++;
+            resourcePath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--hotness") == 0 && argNum+1 < argc){
+            argNum++;
+            hotnessPath = argv[argNum];
+        }else if(strcmp(argv[argNum], "--symbols") == 0 && argNum+1 < argc){
+            argNum++;
+            symbolPath = argv[argNum];
+        }else{
+            logger("Usage: %s OUTPUT [--resources DIR] [--hotness FILE] [--symbols FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const uint8_t *rom = embeddedInvadersRom;
+    if(resourcePath != NULL && (rom = acquireRomSet(resourcePath)) == NULL){
+        logger("No good ROM set found in %s\n", resourcePath);
+        return 1;
+    }
+    SymbolMap *symbols = NULL;
+    if(symbolPath != NULL && (symbols = loadSymbolMap(symbolPath)) == NULL){
+        releaseRomSet(rom);
+        return 1;
+    }
+
+    // Every address the profile saw a block entered at is an instruction start
+    uint16_t *entryPoints = mallocSet(ROM_LIMIT_8080*sizeof(uint16_t));
+    uint32_t numEntryPoints = 0;
+    if(hotnessPath != NULL){
+        HotnessProfile *profile = loadHotnessProfile(hotnessPath, rom);
+        for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+            if(profile->counts[address].blockEntries > 0){
+                entryPoints[numEntryPoints++] = (uint16_t)address;
+            }
+        }
+        destroyHotnessProfile(profile);
+        logger("%u block entries taken from %s\n", numEntryPoints, hotnessPath);
+    }
+    RomAnalysis *analysis = analyzeRomFrom(rom, entryPoints, numEntryPoints);
+    free(entryPoints);
+
+    int successfulWrite = writeRomGraph(analysis, rom, symbols, argv[1]);
+    if(successfulWrite){
+        uint32_t numCallTargets = 0;
+        for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+            numCallTargets += analysis->instructions[address].isCallTarget;
+        }
+        uint32_t numResolved = 0;
+        for(uint32_t jumpNum = 0; jumpNum < analysis->numIndirectJumps; jumpNum++){
+            numResolved += (analysis->indirectJumps[jumpNum].numTargets > 0);
+        }
+        uint32_t numUnknownBytes = 0;
+        uint32_t numUnknownRegions = countUnknownRegions(analysis, rom, NULL, &numUnknownBytes);
+        logger("%u instructions in %u blocks, %u routines called, %u of %u indirect jumps resolved\n",
+               analysis->numInstructions, analysis->numBlocks, numCallTargets, numResolved, analysis->numIndirectJumps);
+        logger("%u bytes of ROM never reached, in %u regions\n", numUnknownBytes, numUnknownRegions);
+    }
+
+    destroyRomAnalysis(analysis);
+    destroySymbolMap(symbols);
+    releaseRomSet(rom);
+    return successfulWrite ? 0 : 1;
+}
+
+/**
+ * Writes the control flow graph file
+ * @param analysis - The analysis of the ROM
+ * @param rom - The ROM
+ * @param symbols - Symbol map to name blocks and routines with, or NULL
+ * @param path - File to write
+ * @return int - 1 on success, 0 if the file could not be written
+ */
+int writeRomGraph(const RomAnalysis *analysis, const uint8_t *rom, const SymbolMap *symbols, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if(file == NULL){
+        logger("Failed to create %s\n", path);
+        return 0;
+    }
+
+    fprintf(file, "; Control flow graph of a ROM with CRC-32 %08x, written by rom_graph\n", crc32(0, rom, ROM_LIMIT_8080));
+    fprintf(file, "; %u instructions in %u blocks\n", analysis->numInstructions, analysis->numBlocks);
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(analysis->instructions[address].isEntryPoint){
+            fprintf(file, "entry %04x\n", address);
+        }
+    }
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(analysis->instructions[address].isBlockStart){
+            writeBlock(file, analysis, rom, (uint16_t)address);
+            writeSymbolComment(file, symbols, (uint16_t)address);
+        }
+    }
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(analysis->instructions[address].isCallTarget){
+            fprintf(file, "routine %04x", address);
+            writeSymbolComment(file, symbols, (uint16_t)address);
+        }
+    }
+    for(uint32_t copyNum = 0; copyNum < analysis->numBlockCopies; copyNum++){
+        const RomBlockCopy *copy = &(analysis->blockCopies[copyNum]);
+        fprintf(file, "copy %04x %04x %x\n", copy->source, copy->destination, copy->size);
+    }
+    for(uint32_t jumpNum = 0; jumpNum < analysis->numIndirectJumps; jumpNum++){
+        const RomIndirectJump *jump = &(analysis->indirectJumps[jumpNum]);
+        if(jump->numTargets == 0){
+            fprintf(file, "unresolved %04x\n", jump->address);
+        }else if(jump->isTable){
+            fprintf(file, "table %04x %x %04x %x\n", jump->target, jump->numTargets, jump->address, jump->stride);
+        }else{
+            fprintf(file, "target %04x %04x\n", jump->target, jump->address);
+        }
+    }
+    uint32_t numUnknownBytes = 0;
+    countUnknownRegions(analysis, rom, file, &numUnknownBytes);
+
+    if(fclose(file) != 0){
+        logger("Failed to write %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Writes one block's line, without ending it
+ * @param file - The open graph file
+ * @param analysis - The analysis of the ROM
+ * @param rom - The ROM
+ * @param blockStart - Address of the block
+ */
+void writeBlock(FILE *file, const RomAnalysis *analysis, const uint8_t *rom, uint16_t blockStart)
+{
+    uint32_t blockEnd = getBlockEnd(analysis, rom, blockStart);
+    uint16_t lastAddress = blockStart;
+    while((uint32_t)lastAddress+instructionSizes[rom[lastAddress]] < blockEnd){
+        lastAddress += instructionSizes[rom[lastAddress]];
+    }
+    const RomInstruction *last = &(analysis->instructions[lastAddress]);
+    fprintf(file, "block %04x %x", blockStart, blockEnd-blockStart);
+
+    // A call continues at its return address once the routine returns, not at the routine
+    uint8_t opcode = rom[lastAddress];
+    bool isCall = opcode == 0xcd || (opcode & 0xc7) == 0xc4 || (opcode & 0xc7) == 0xc7;
+    if(isCall && blockEnd < ROM_LIMIT_8080){
+        uint32_t target = (opcode & 0xc7) == 0xc7 ? (uint32_t)(opcode & 0x38) : (uint32_t)(rom[lastAddress+1] | (rom[lastAddress+2]<<8));
+        fprintf(file, (target < ROM_LIMIT_8080) ? " call %04x -> %04x" : " call %04x? -> %04x", target, blockEnd);
+        return;
+    }
+
+    fprintf(file, " ->");
+    for(uint8_t successorNum = 0; successorNum < last->numSuccessors; successorNum++){
+        fprintf(file, " %04x", last->successors[successorNum]);
+    }
+    if(last->unknownSuccessors){
+        fprintf(file, " ?");
+    }
+}
+
+/**
+ * Ends a line, naming the address in a comment if a symbol covers it
+ * @param file - The open graph file
+ * @param symbols - Symbol map, or NULL
+ * @param address - The address
+ */
+void writeSymbolComment(FILE *file, const SymbolMap *symbols, uint16_t address)
+{
+    if(symbols != NULL && findSymbol(symbols, address) != NULL){
+        char label[SYMBOL_NAME_LENGTH+8];
+        formatSymbolAddress(symbols, address, label, sizeof(label));
+        fprintf(file, "  ; %s", label);
+    }
+    fprintf(file, "\n");
+}
+
+/**
+ * Finds the regions of ROM no instruction found covers
+ * @param analysis - The analysis of the ROM
+ * @param rom - The ROM
+ * @param file - The open graph file to write the regions to, or NULL
+ * @param numUnknownBytes - Set to the number of bytes in the regions
+ * @return - Number of regions
+ */
+uint32_t countUnknownRegions(const RomAnalysis *analysis, const uint8_t *rom, FILE *file, uint32_t *numUnknownBytes)
+{
+    bool *covered = mallocSet(ROM_LIMIT_8080*sizeof(bool));
+    for(uint32_t address = 0; address < ROM_LIMIT_8080; address++){
+        if(analysis->instructions[address].isCode){
+            for(uint32_t byteNum = 0; byteNum < (uint32_t)instructionSizes[rom[address]] && address+byteNum < ROM_LIMIT_8080; byteNum++){
+                covered[address+byteNum] = true;
+            }
+        }
+    }
+
+    uint32_t numRegions = 0;
+    *numUnknownBytes = 0;
+    uint32_t regionStart = 0;
+    for(uint32_t address = 0; address <= ROM_LIMIT_8080; address++){
+        bool isUnknown = address < ROM_LIMIT_8080 && !covered[address];
+        bool wasUnknown = address > 0 && !covered[address-1];
+        if(isUnknown && !wasUnknown){
+            regionStart = address;
+        }else if(!isUnknown && wasUnknown){
+            numRegions++;
+            *numUnknownBytes += address-regionStart;
+            if(file != NULL){
+                fprintf(file, "unknown %04x %x\n", regionStart, address-regionStart);
+            }
+        }
+    }
+
+    free(covered);
+    return numRegions;
+}
@@ -0,0 +1,253 @@
+/***********************************************************************************
+ *
+ * Source for native replacements of hot Space Invaders ROM routines.
+ * Each loop iteration is run just as the ROM code runs it, the same memory accesses in
+ * the same order, so that even a sprite drawn over the stack comes out the same.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "romHooks.h"
+#include "instructions.h"
+#include "alu8080.h"
+#include "opcodeSpec.h"
+
+// Bytes of one iteration of each loop, up to and including its JNZ, its cycles come from the opcode specification
+#define BLOCK_COPY_SIZE 8  // LDAX D, MOV M;A, INX H, INX D, DCR B, JNZ
+#define DRAW_SPRITE_SIZE 13  // PUSH B, LDAX D, MOV M;A, INX D, LXI B, DAD B, POP B, DCR B, JNZ
+#define CLEAR_SPRITE_SIZE 11  // PUSH B, MOV M;A, LXI B, DAD B, POP B, DCR B, JNZ
+#define CLEAR_SCREEN_SIZE 9  // MVI M, INX H, MOV A;H, CPI, JNZ
+#define SCREEN_END_HIGH_BYTE 0x40
+#define SPRITE_ROW_BYTES 0x20  // Added to HL after each byte of a sprite, to move to the next row of the rotated screen
+
+unsigned int runBlockCopy(State8080 *state, unsigned int cyclesLeft);
+unsigned int runDrawSimpleSprite(State8080 *state, unsigned int cyclesLeft);
+unsigned int runClearSmallSprite(State8080 *state, unsigned int cyclesLeft);
+unsigned int runClearScreen(State8080 *state, unsigned int cyclesLeft);
+void pushRowCount(State8080 *state);
+void addRow(State8080 *state);
+void popAndCountDown(State8080 *state);
+unsigned int countLoopCycles(const uint8_t *code, uint16_t loopSize, unsigned int *numInstructions);
+unsigned int finishLoop(State8080 *state, unsigned int cyclesLeft, unsigned int numIterations, unsigned int iterationCycles,
+                        unsigned int iterationInstructions, uint16_t loopSize, bool isLoopDone);
+
+const RomHook romHooks[NUM_ROM_HOOKS] = {
+    // BlockCopy: copies B bytes from DE to HL
+    {"BlockCopy", 0x1a32, {0x1a, 0x77, 0x23, 0x13, 0x05, 0xc2, 0x32, 0x1a, 0xc9}, 9, runBlockCopy},
+    // DrawSimpSprite: draws B rows of an unshifted sprite from DE at HL
+    {"DrawSimpSprite", 0x1439, {0xc5, 0x1a, 0x77, 0x13, 0x01, 0x20, 0x00, 0x09, 0xc1, 0x05, 0xc2, 0x39, 0x14, 0xc9}, 14,
+     runDrawSimpleSprite},
+    // ClearSmallSprite, after its XRA A: writes A to B rows at HL
+    {"ClearSmallSprite", 0x14cc, {0xc5, 0x77, 0x01, 0x20, 0x00, 0x09, 0xc1, 0x05, 0xc2, 0xcc, 0x14, 0xc9}, 12,
+     runClearSmallSprite},
+    // ClearScreen, after its LXI H: zeroes memory from HL up to the end of video RAM
+    {"ClearScreen", 0x1a5f, {0x36, 0x00, 0x23, 0x7c, 0xfe, 0x40, 0xc2, 0x5f, 0x1a, 0xc9}, 10, runClearScreen}
+};
+
+const char *romHookModeNames[NUM_ROM_HOOK_MODES] = {"off", "on", "verify"};
+
+const RomHook *findRomHook(const uint8_t *memory, uint16_t address)
+{
+    for(unsigned int hookNum = 0; hookNum < NUM_ROM_HOOKS; hookNum++){
+        const RomHook *hook = &(romHooks[hookNum]);
+        if(hook->address == address && memcmp(&(memory[address]), hook->code, hook->codeLength) == 0){
+            return hook;
+        }
+    }
+
+    return NULL;
+}
+
+const char *getRomHookModeName(enum RomHookMode mode)
+{
+    if((unsigned int)mode >= NUM_ROM_HOOK_MODES){
+        return "unknown";
+    }
+
+    return romHookModeNames[mode];
+}
+
+int findRomHookMode(const char *name, enum RomHookMode *mode)
+{
+    for(unsigned int modeNum = 0; modeNum < NUM_ROM_HOOK_MODES; modeNum++){
+        if(strcmp(name, romHookModeNames[modeNum]) == 0){
+            *mode = (enum RomHookMode)modeNum;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+unsigned int runBlockCopy(State8080 *state, unsigned int cyclesLeft)
+{
+    unsigned int iterationInstructions = 0;
+    unsigned int iterationCycles = countLoopCycles(&(state->memory[state->pc]), BLOCK_COPY_SIZE, &iterationInstructions);
+    unsigned int numIterations = 0;
+    bool isLoopDone = false;
+    while(!isLoopDone && (numIterations+1)*iterationCycles <= cyclesLeft){
+        uint16_t source = getValueDE(state);
+        uint16_t destination = getValueHL(state);
+        state->a = readMem(source, state);
+        writeMem(destination, state->a, state);
+        destination++;
+        source++;
+        state->h = (uint8_t)(destination>>8);
+        state->l = (uint8_t)destination;
+        state->d = (uint8_t)(source>>8);
+        state->e = (uint8_t)source;
+        aluDecrement(&(state->b), state);
+        isLoopDone = state->flags.zero;
+        numIterations++;
+    }
+
+    return finishLoop(state, cyclesLeft, numIterations, iterationCycles, iterationInstructions, BLOCK_COPY_SIZE, isLoopDone);
+}
+
+unsigned int runDrawSimpleSprite(State8080 *state, unsigned int cyclesLeft)
+{
+    unsigned int iterationInstructions = 0;
+    unsigned int iterationCycles = countLoopCycles(&(state->memory[state->pc]), DRAW_SPRITE_SIZE, &iterationInstructions);
+    unsigned int numIterations = 0;
+    bool isLoopDone = false;
+    while(!isLoopDone && (numIterations+1)*iterationCycles <= cyclesLeft){
+        uint16_t source = getValueDE(state);
+        pushRowCount(state);
+        state->a = readMem(source, state);
+        writeMem(getValueHL(state), state->a, state);
+        source++;
+        state->d = (uint8_t)(source>>8);
+        state->e = (uint8_t)source;
+        addRow(state);
+        popAndCountDown(state);
+        isLoopDone = state->flags.zero;
+        numIterations++;
+    }
+
+    return finishLoop(state, cyclesLeft, numIterations, iterationCycles, iterationInstructions, DRAW_SPRITE_SIZE, isLoopDone);
+}
+
+unsigned int runClearSmallSprite(State8080 *state, unsigned int cyclesLeft)
+{
+    unsigned int iterationInstructions = 0;
+    unsigned int iterationCycles = countLoopCycles(&(state->memory[state->pc]), CLEAR_SPRITE_SIZE, &iterationInstructions);
+    unsigned int numIterations = 0;
+    bool isLoopDone = false;
+    while(!isLoopDone && (numIterations+1)*iterationCycles <= cyclesLeft){
+        pushRowCount(state);
+        writeMem(getValueHL(state), state->a, state);
+        addRow(state);
+        popAndCountDown(state);
+        isLoopDone = state->flags.zero;
+        numIterations++;
+    }
+
+    return finishLoop(state, cyclesLeft, numIterations, iterationCycles, iterationInstructions, CLEAR_SPRITE_SIZE, isLoopDone);
+}
+
+unsigned int runClearScreen(State8080 *state, unsigned int cyclesLeft)
+{
+    unsigned int iterationInstructions = 0;
+    unsigned int iterationCycles = countLoopCycles(&(state->memory[state->pc]), CLEAR_SCREEN_SIZE, &iterationInstructions);
+    unsigned int numIterations = 0;
+    bool isLoopDone = false;
+    while(!isLoopDone && (numIterations+1)*iterationCycles <= cyclesLeft){
+        uint16_t destination = getValueHL(state);
+        writeMem(destination, 0x00, state);
+        destination++;
+        state->h = (uint8_t)(destination>>8);
+        state->l = (uint8_t)destination;
+        state->a = state->h;
+        aluCompare(SCREEN_END_HIGH_BYTE, state);
+        isLoopDone = state->flags.zero;
+        numIterations++;
+    }
+
+    return finishLoop(state, cyclesLeft, numIterations, iterationCycles, iterationInstructions, CLEAR_SCREEN_SIZE, isLoopDone);
+}
+
+/**
+ * Runs PUSH B, saving the row count while BC is used to move down a row
+ * @param state - The 8080 state
+ */
+void pushRowCount(State8080 *state)
+{
+    writeMem((uint16_t)(state->sp-1), state->b, state);
+    writeMem((uint16_t)(state->sp-2), state->c, state);
+    state->sp -= 2;
+}
+
+/**
+ * Runs LXI B,0020 then DAD B, moving HL on one row of the rotated screen
+ * @param state - The 8080 state
+ */
+void addRow(State8080 *state)
+{
+    state->b = 0x00;
+    state->c = SPRITE_ROW_BYTES;
+    uint32_t row = (uint32_t)getValueHL(state) + SPRITE_ROW_BYTES;
+    state->flags.carry = (row > 0xffff);
+    state->h = (uint8_t)(row>>8);
+    state->l = (uint8_t)row;
+}
+
+/**
+ * Runs POP B then DCR B, restoring the row count pushed at the start of the iteration and counting it down
+ * @param state - The 8080 state
+ */
+void popAndCountDown(State8080 *state)
+{
+    state->c = readMem(state->sp, state);
+    state->b = readMem((uint16_t)(state->sp+1), state);
+    state->sp += 2;
+    aluDecrement(&(state->b), state);
+}
+
+/**
+ * Adds up the cycles of a loop's instructions, each taken as it is while the loop goes on
+ * @param code - The loop's code
+ * @param loopSize - Bytes of code in the loop
+ * @param numInstructions - Set to the number of instructions in the loop
+ * @return - Cycles of one iteration
+ */
+unsigned int countLoopCycles(const uint8_t *code, uint16_t loopSize, unsigned int *numInstructions)
+{
+    unsigned int cycles = 0;
+    *numInstructions = 0;
+    for(uint16_t offset = 0; offset < loopSize; offset += instructionSizes[code[offset]]){
+        cycles += instructionCycles[code[offset]];
+        (*numInstructions)++;
+    }
+
+    return cycles;
+}
+
+/**
+ * Accounts for the iterations a native loop ran, then once the loop is done, runs its routine's RET if that fits too
+ * @param state - The 8080 state, with the program counter still at the start of the loop
+ * @param cyclesLeft - Cycles the routine was allowed to run
+ * @param numIterations - Whole iterations run
+ * @param iterationCycles - Cycles of one iteration
+ * @param iterationInstructions - Instructions in one iteration
+ * @param loopSize - Bytes of code in the loop, the RET follows
+ * @param isLoopDone - Whether the last iteration ran its JNZ without jumping
+ * @return - Number of ROM instructions run
+ */
+unsigned int finishLoop(State8080 *state, unsigned int cyclesLeft, unsigned int numIterations, unsigned int iterationCycles,
+                        unsigned int iterationInstructions, uint16_t loopSize, bool isLoopDone)
+{
+    unsigned int cyclesRun = numIterations*iterationCycles;
+    unsigned int numExecuted = numIterations*iterationInstructions;
+    state->cyclesCompleted += cyclesRun;
+    if(isLoopDone){
+        state->pc += loopSize;
+        unsigned int returnCycles = instructionCycles[state->memory[state->pc]];
+        if(cyclesRun+returnCycles <= cyclesLeft){
+            RET(state);
+            state->cyclesCompleted += returnCycles;
+            numExecuted++;
+        }
+    }
+
+    return numExecuted;
+}
@@ -0,0 +1,72 @@
+/***********************************************************************************
+ *
+ * Header for native replacements of hot Space Invaders ROM routines.
+ *
+ * Some ROM routines spend most of their time in short byte-by-byte loops: copying blocks,
+ * drawing and clearing unshifted sprites one row at a time, and clearing the screen. Each
+ * hook pairs the address of such a loop with a C function doing the same work directly,
+ * with the same memory writes, registers, flags and cycle count as the ROM code. A hook is
+ * only used where the ROM holds exactly the code it was written for.
+ *
+ * A native routine is given the cycles left before the CPU must stop, e.g. for an interrupt,
+ * and runs only as many whole loop iterations as fit, leaving the CPU at the loop's start
+ * (or after it) exactly as the ROM code would have. Whatever does not fit is left to the
+ * instructions themselves. The routines drawing shifted sprites go through the cabinet's
+ * shift register, which is outside the CPU, so they are not replaced.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_ROMHOOKS_H
+#define INTEL_8080_EMULATOR_ROMHOOKS_H
+
+#include "cpuStructures.h"
+
+#define NUM_ROM_HOOKS 4
+#define MAX_HOOK_CODE_LENGTH 16
+#define NUM_ROM_HOOK_MODES 3
+
+/**
+ * Whether native routines replace the ROM routines they were written for
+ */
+enum RomHookMode {HooksOff, HooksOn, HooksVerified};
+
+/**
+ * Runs a ROM routine natively
+ * @param state - The 8080 state, at the routine's address
+ * @param cyclesLeft - Cycles that may be run
+ * @return - Number of ROM instructions run, 0 if the state was left untouched as not even one loop iteration fits
+ */
+typedef unsigned int (*NativeRoutine)(State8080 *state, unsigned int cyclesLeft);
+
+typedef struct RomHook{
+    const char *name;
+    uint16_t address;
+    uint8_t code[MAX_HOOK_CODE_LENGTH];  /**< ROM code the routine replaces, from the address through its RET */
+    uint8_t codeLength;
+    NativeRoutine run;
+} RomHook;
+
+/**
+ * Finds the hook for an address
+ * @param memory - The 8080 memory, only ROM is read
+ * @param address - An address
+ * @return - The hook, or NULL if there is none or the ROM there is not the code it replaces
+ */
+const RomHook *findRomHook(const uint8_t *memory, uint16_t address);
+
+/**
+ * @param mode - A hook mode
+ * @return - Name of the mode, as used on the command line
+ */
+const char *getRomHookModeName(enum RomHookMode mode);
+
+/**
+ * Looks up a hook mode by name
+ * @param name - "off", "on" or "verify"
+ * @param mode - Set to the mode if found
+ * @return int - 1 if the name is known, 0 otherwise
+ */
+int findRomHookMode(const char *name, enum RomHookMode *mode);
+
+#endif //INTEL_8080_EMULATOR_ROMHOOKS_H
@@ -0,0 +1,155 @@
+/***********************************************************************************
+ *
+ * Source for loading and verifying Space Invaders ROM sets from disk
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "romLoader.h"
+#include "helpers.h"
+
+/**
+ * A ROM set currently loaded by the process
+ */
+typedef struct LoadedRomSet{
+    char resourcePath[ROM_PATH_LENGTH];
+    MappedFile mapping;  /**< Mapping of the single-file image, if that is how the set was found */
+    uint8_t *chipBuffer;  /**< Concatenated chips, if the set was found as separate chips */
+    const uint8_t *rom;  /**< Points into whichever of the above holds the set */
+    unsigned int references;
+} LoadedRomSet;
+
+// Chips in the order they appear in the address space, with the CRC-32 of a good dump of each
+const char *romChipNames[NUM_ROM_CHIPS] = {"invaders.h", "invaders.g", "invaders.f", "invaders.e"};
+const uint32_t romChipChecksums[NUM_ROM_CHIPS] = {0x734f5ad8, 0x6bfaca4a, 0x0ccead96, 0x14e538b0};
+
+LoadedRomSet loadedRomSets[MAX_LOADED_ROM_SETS];
+
+int loadRomSet(const char *resourcePath, LoadedRomSet *romSet);
+void unloadRomSet(LoadedRomSet *romSet);
+
+const uint8_t *acquireRomSet(const char *resourcePath)
+{
+    LoadedRomSet *freeSlot = NULL;
+
+    if(strlen(resourcePath) >= ROM_PATH_LENGTH){
+        logger("ROM path is too long: %s\n", resourcePath);
+        return NULL;
+    }
+
+    // Share the set if another arcade already loaded it
+    for(int setNum = 0; setNum < MAX_LOADED_ROM_SETS; setNum++){
+        LoadedRomSet *romSet = &(loadedRomSets[setNum]);
+        if(romSet->references > 0 && strcmp(romSet->resourcePath, resourcePath) == 0){
+            romSet->references++;
+            return romSet->rom;
+        }else if(romSet->references == 0 && freeSlot == NULL){
+            freeSlot = romSet;
+        }
+    }
+
+    if(freeSlot == NULL){
+        logger("Too many different ROM sets loaded at once!\n");
+        return NULL;
+    }
+
+    if(loadRomSet(resourcePath, freeSlot) == 0){
+        return NULL;
+    }
+
+    if(verifyRomSet(freeSlot->rom) == 0){
+        logger("ROM set in %s failed its checksum, it may be a bad dump\n", resourcePath);
+        unloadRomSet(freeSlot);
+        return NULL;
+    }
+
+    freeSlot->references = 1;
+    return freeSlot->rom;
+}
+
+void releaseRomSet(const uint8_t *rom)
+{
+    for(int setNum = 0; setNum < MAX_LOADED_ROM_SETS; setNum++){
+        LoadedRomSet *romSet = &(loadedRomSets[setNum]);
+        if(romSet->references > 0 && romSet->rom == rom){
+            romSet->references--;
+            if(romSet->references == 0){
+                unloadRomSet(romSet);
+            }
+            return;
+        }
+    }
+}
+
+int verifyRomSet(const uint8_t *rom)
+{
+    int romSetGood = 1;
+
+    for(int chipNum = 0; chipNum < NUM_ROM_CHIPS; chipNum++){
+        uint32_t checksum = crc32(0, &(rom[chipNum*ROM_CHIP_SIZE]), ROM_CHIP_SIZE);
+        if(checksum != romChipChecksums[chipNum]){
+            logger("Bad ROM chip %s: CRC-32 is 0x%08x, expected 0x%08x\n",
+                   romChipNames[chipNum], checksum, romChipChecksums[chipNum]);
+            romSetGood = 0;
+        }
+    }
+
+    return romSetGood;
+}
+
+/**
+ * Maps the single-file image from a folder, or failing that, gathers the separate chips
+ * @return int - 1 if a complete set was found, 0 otherwise
+ */
+int loadRomSet(const char *resourcePath, LoadedRomSet *romSet)
+{
+    char romPath[ROM_PATH_LENGTH+16];
+
+    strcpy(romSet->resourcePath, resourcePath);
+    romSet->chipBuffer = NULL;
+    romSet->rom = NULL;
+
+    // The single image can be used directly from the page cache
+    snprintf(romPath, sizeof(romPath), "%s/invaders", resourcePath);
+    if(mapFile(romPath, &(romSet->mapping)) == 1){
+        if(romSet->mapping.size != ROM_LIMIT_8080){
+            logger("%s is %u bytes, expected %u\n", romPath, (unsigned int)romSet->mapping.size, ROM_LIMIT_8080);
+            unmapFile(&(romSet->mapping));
+            return 0;
+        }
+        romSet->rom = romSet->mapping.data;
+        return 1;
+    }
+
+    // Separate chips have to be placed next to each other
+    romSet->chipBuffer = mallocSet(ROM_LIMIT_8080);
+    for(int chipNum = 0; chipNum < NUM_ROM_CHIPS; chipNum++){
+        MappedFile chip;
+        snprintf(romPath, sizeof(romPath), "%s/%s", resourcePath, romChipNames[chipNum]);
+        if(mapFile(romPath, &chip) == 0){
+            logger("Failed to open Space Invaders ROM in %s\n", resourcePath);
+            unloadRomSet(romSet);
+            return 0;
+        }
+        if(chip.size != ROM_CHIP_SIZE){
+            logger("%s is %u bytes, expected %u\n", romPath, (unsigned int)chip.size, ROM_CHIP_SIZE);
+            unmapFile(&chip);
+            unloadRomSet(romSet);
+            return 0;
+        }
+        memcpy(&(romSet->chipBuffer[chipNum*ROM_CHIP_SIZE]), chip.data, ROM_CHIP_SIZE);
+        unmapFile(&chip);
+    }
+    romSet->rom = romSet->chipBuffer;
+
+    return 1;
+}
+
+void unloadRomSet(LoadedRomSet *romSet)
+{
+    unmapFile(&(romSet->mapping));
+    free(romSet->chipBuffer);
+    romSet->chipBuffer = NULL;
+    romSet->rom = NULL;
+    romSet->references = 0;
+}
@@ -0,0 +1,51 @@
+/***********************************************************************************
+ *
+ * Header for loading and verifying Space Invaders ROM sets from disk.
+ *
+ * A ROM set is either a single 8 KB "invaders" image or the four 2 KB chips
+ * dumped by MAME (invaders.h, invaders.g, invaders.f, invaders.e).
+ * A single image is memory-mapped and used in place, split chips are joined into one heap
+ * buffer. Each set is loaded and verified once per process, and that one loaded set is shared
+ * by every arcade that asks for it. Each CPU still copies the ROM into its own 64 KB memory
+ * (see initializeCPU), so the sharing saves the loading and checking, not the 8 KB per CPU.
+ * These functions are not thread-safe and should be called from a single thread.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_ROMLOADER_H
+#define INTEL_8080_EMULATOR_ROMLOADER_H
+
+#include "cpuStructures.h"
+#include "mappedFile.h"
+
+#define ROM_CHIP_SIZE 0x0800
+#define NUM_ROM_CHIPS 4
+#define MAX_LOADED_ROM_SETS 4
+#define ROM_PATH_LENGTH 1024
+
+/**
+ * Returns the ROM set found in a folder, loading and verifying it if it is not already loaded.
+ * Every chip must match the CRC-32 of the known good dump, otherwise the set is rejected.
+ * Each successful call must be paired with a call to releaseRomSet.
+ * @param resourcePath - Folder containing the ROM set
+ * @return - pointer to ROM_LIMIT_8080 read-only bytes, or NULL if the set is missing or bad
+ */
+const uint8_t *acquireRomSet(const char *resourcePath);
+
+/**
+ * Gives up a reference to a ROM set returned by acquireRomSet.
+ * The set is unloaded once its last reference is released.
+ * Pointers that did not come from acquireRomSet are ignored.
+ * @param rom - The ROM set
+ */
+void releaseRomSet(const uint8_t *rom);
+
+/**
+ * Checks each chip of a ROM image against the CRC-32 of the known good dump
+ * @param rom - ROM_LIMIT_8080 bytes of ROM
+ * @return int - 1 if every chip matches, 0 otherwise
+ */
+int verifyRomSet(const uint8_t *rom);
+
+#endif //INTEL_8080_EMULATOR_ROMLOADER_H
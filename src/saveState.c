@@ -0,0 +1,118 @@
+/***********************************************************************************
+ *
+ * Source for capturing and restoring the state of a running arcade machine
+ * @Author: Andrew Gunter
+ *
+ * Layout (multi-byte values are little-endian):
+ *   0  Magic "SI80"
+ *   4  Version (16 bits)
+ *   6  Reserved (16 bits, zero)
+ *   8  Flags, as the raw ConditionCodes byte pushed by PUSH PSW
+ *   9  Registers A, B, C, D, E, H, L
+ *  16  SP (16 bits), PC (16 bits)
+ *  20  Cycles completed (32 bits)
+ *  24  Interrupts enabled
+ *  25  Shift register (16 bits)
+ *  27  Arcade input ports 0-3, output ports 2-6
+ *  36  CPU input buffers 0-7, output buffers 0-7
+ *  52  RAM and VRAM, 0x2000 - 0x3FFF
+ *
+***********************************************************************************/
+
+#include "saveState.h"
+
+const uint8_t saveStateMagic[4] = {'S', 'I', '8', '0'};
+
+size_t saveState(ArcadeState *arcade, uint8_t *buffer, size_t bufferSize)
+{
+    State8080 *cpu = arcade->cpu;
+    uint8_t *machine = &(buffer[SAVE_STATE_HEADER_SIZE]);
+
+    if(bufferSize < SAVE_STATE_SIZE){
+        return 0;
+    }
+
+    // Header
+    memcpy(buffer, saveStateMagic, sizeof(saveStateMagic));
+    writeLittleEndian(&(buffer[4]), SAVE_STATE_VERSION, 2);
+    writeLittleEndian(&(buffer[6]), 0, 2);
+
+    // CPU
+    memcpy(&(machine[0]), &(cpu->flags), 1);
+    machine[1] = cpu->a;
+    machine[2] = cpu->b;
+    machine[3] = cpu->c;
+    machine[4] = cpu->d;
+    machine[5] = cpu->e;
+    machine[6] = cpu->h;
+    machine[7] = cpu->l;
+    writeLittleEndian(&(machine[8]), cpu->sp, 2);
+    writeLittleEndian(&(machine[10]), cpu->pc, 2);
+    writeLittleEndian(&(machine[12]), cpu->cyclesCompleted, 4);
+    machine[16] = cpu->interruptsEnabled;
+
+    // Arcade hardware
+    writeLittleEndian(&(machine[17]), arcade->shiftRegister, 2);
+    machine[19] = arcade->inputPort0;
+    machine[20] = arcade->inputPort1;
+    machine[21] = arcade->inputPort2;
+    machine[22] = arcade->inputPort3;
+    machine[23] = arcade->outputPort2;
+    machine[24] = arcade->outputPort3;
+    machine[25] = arcade->outputPort4;
+    machine[26] = arcade->outputPort5;
+    machine[27] = arcade->outputPort6;
+    memcpy(&(machine[28]), cpu->inputBuffers, SAVE_STATE_NUM_PORTS);
+    memcpy(&(machine[28+SAVE_STATE_NUM_PORTS]), cpu->outputBuffers, SAVE_STATE_NUM_PORTS);
+
+    // Memory
+    memcpy(&(machine[SAVE_STATE_MACHINE_SIZE]), &(cpu->memory[SAVE_STATE_RAM_START]), SAVE_STATE_RAM_SIZE);
+
+    return SAVE_STATE_SIZE;
+}
+
+int loadState(ArcadeState *arcade, const uint8_t *buffer, size_t bufferSize)
+{
+    State8080 *cpu = arcade->cpu;
+    const uint8_t *machine = &(buffer[SAVE_STATE_HEADER_SIZE]);
+
+    if(bufferSize < SAVE_STATE_SIZE || memcmp(buffer, saveStateMagic, sizeof(saveStateMagic)) != 0){
+        return 0;
+    }
+    if(readLittleEndian(&(buffer[4]), 2) != SAVE_STATE_VERSION){
+        return 0;
+    }
+
+    // CPU
+    memcpy(&(cpu->flags), &(machine[0]), 1);
+    cpu->a = machine[1];
+    cpu->b = machine[2];
+    cpu->c = machine[3];
+    cpu->d = machine[4];
+    cpu->e = machine[5];
+    cpu->h = machine[6];
+    cpu->l = machine[7];
+    cpu->sp = (uint16_t)readLittleEndian(&(machine[8]), 2);
+    cpu->pc = (uint16_t)readLittleEndian(&(machine[10]), 2);
+    cpu->cyclesCompleted = readLittleEndian(&(machine[12]), 4);
+    cpu->interruptsEnabled = machine[16];
+
+    // Arcade hardware
+    arcade->shiftRegister = (uint16_t)readLittleEndian(&(machine[17]), 2);
+    arcade->inputPort0 = machine[19];
+    arcade->inputPort1 = machine[20];
+    arcade->inputPort2 = machine[21];
+    arcade->inputPort3 = machine[22];
+    arcade->outputPort2 = machine[23];
+    arcade->outputPort3 = machine[24];
+    arcade->outputPort4 = machine[25];
+    arcade->outputPort5 = machine[26];
+    arcade->outputPort6 = machine[27];
+    memcpy(cpu->inputBuffers, &(machine[28]), SAVE_STATE_NUM_PORTS);
+    memcpy(cpu->outputBuffers, &(machine[28+SAVE_STATE_NUM_PORTS]), SAVE_STATE_NUM_PORTS);
+
+    // Memory
+    memcpy(&(cpu->memory[SAVE_STATE_RAM_START]), &(machine[SAVE_STATE_MACHINE_SIZE]), SAVE_STATE_RAM_SIZE);
+
+    return 1;
+}
@@ -0,0 +1,45 @@
+/***********************************************************************************
+ *
+ * Header for capturing and restoring the state of a running arcade machine.
+ *
+ * A save state is a compact, versioned binary blob holding everything that affects
+ * emulation: CPU registers and flags, RAM (including VRAM), the shift register and
+ * the I/O port latches. ROM and host-side settings (colour profile, audio) are not saved.
+ * Neither function allocates memory.
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_SAVESTATE_H
+#define INTEL_8080_EMULATOR_SAVESTATE_H
+
+#include "arcadeEnvironment.h"
+
+#define SAVE_STATE_VERSION 1
+#define SAVE_STATE_RAM_START ROM_LIMIT_8080
+#define SAVE_STATE_RAM_SIZE 0x2000  // Work RAM and VRAM, 0x2000 - 0x3FFF
+#define SAVE_STATE_NUM_PORTS 8  // CPU I/O buffers saved, covers every port Space Invaders uses
+#define SAVE_STATE_HEADER_SIZE 8
+#define SAVE_STATE_MACHINE_SIZE 44
+#define SAVE_STATE_SIZE (SAVE_STATE_HEADER_SIZE + SAVE_STATE_MACHINE_SIZE + SAVE_STATE_RAM_SIZE)
+
+/**
+ * Writes the arcade's current state into a buffer
+ * @param arcade - The arcade state
+ * @param buffer - Destination for the save state
+ * @param bufferSize - Size of the buffer, in bytes, should be at least SAVE_STATE_SIZE
+ * @return - Number of bytes written, or 0 if the buffer is too small
+ */
+size_t saveState(ArcadeState *arcade, uint8_t *buffer, size_t bufferSize);
+
+/**
+ * Restores the arcade to a state previously written by saveState
+ * The arcade is left untouched if the save state is not valid.
+ * @param arcade - The arcade state
+ * @param buffer - The save state
+ * @param bufferSize - Size of the save state, in bytes
+ * @return int - 1 if the state was restored, 0 if the save state is invalid or from another version
+ */
+int loadState(ArcadeState *arcade, const uint8_t *buffer, size_t bufferSize);
+
+#endif //INTEL_8080_EMULATOR_SAVESTATE_H
@@ -6,34 +6,36 @@
 #include "../src/instructions.h"
 #include "../src/cpuStructures.h"
 #include "../src/helpers.h"
+#include "../src/profiler.h"
+#include "../src/opcodeSpec.h"
 
 #define DEBUG 0
 
-// Global variable definitions and function prototypes
-char instructions[256][20];
-char instructionSizes[256];
-char instructionFlags[256][20];
-char instructionFunctions[256][100];
-void initializeGlobals();
+// Instruction tables, generated from the opcode specification
+#define OPCODE_MNEMONIC(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) mnemonic,
+#define OPCODE_SIZE(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) size,
+#define OPCODE_CYCLES(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) cycles,
+#define OPCODE_CYCLES_NOT_TAKEN(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) cyclesNotTaken,
+#define OPCODE_FLAGS_READ(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) flagsRead,
+#define OPCODE_FLAGS_WRITTEN(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) flagsWritten,
+#define OPCODE_QUIRKS(opcode, mnemonic, size, cycles, cyclesNotTaken, flagsRead, flagsWritten, quirks, handler) quirks,
+const char instructions[NUM_OPCODES][MAX_MNEMONIC_LENGTH] = {OPCODE_SPEC(OPCODE_MNEMONIC)};
+const char instructionSizes[NUM_OPCODES] = {OPCODE_SPEC(OPCODE_SIZE)};
+const uint8_t instructionCycles[NUM_OPCODES] = {OPCODE_SPEC(OPCODE_CYCLES)};
+const uint8_t instructionCyclesNotTaken[NUM_OPCODES] = {OPCODE_SPEC(OPCODE_CYCLES_NOT_TAKEN)};
+const uint8_t instructionFlagsRead[NUM_OPCODES] = {OPCODE_SPEC(OPCODE_FLAGS_READ)};
+const uint8_t instructionFlagsWritten[NUM_OPCODES] = {OPCODE_SPEC(OPCODE_FLAGS_WRITTEN)};
+const uint8_t instructionQuirks[NUM_OPCODES] = {OPCODE_SPEC(OPCODE_QUIRKS)};
+
+// Function prototypes
 uint8_t *getRomBuffer(FILE *romFile);
 void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *state);
 void executeNextInstruction(State8080 *state);
 int numExec = 0;  // Counts number of executed instructions
 
 
-State8080 *initializeCPU()
+State8080 *initializeCPU(const uint8_t *romImage)
 {
-    uint8_t *romBuffer;  // Buffer for storing bytes read from Space Invaders ROM
-    initializeGlobals();
-
-    // Open Space Invaders ROM file as binary-read-only and store contents in a buffer
-    FILE *invadersFile = fopen("../resources/invaders", "rb");
-    if(invadersFile == NULL){
-        logger("Failed to open Space Invaders ROM.\n");
-        return NULL;
-    }
-    romBuffer = getRomBuffer(invadersFile);
-
     // Initialize an 8080 state variable
     State8080 *state = mallocSet(sizeof(State8080));
 
@@ -54,10 +56,10 @@ State8080 *initializeCPU()
     state->cyclesCompleted = 0;
     state->interruptsEnabled = 0;
 
-    // Place ROM buffer data into CPU memory
-    memcpy(state->memory, romBuffer, ROM_LIMIT_8080);
+    // Place ROM image into CPU memory
+    memcpy(state->memory, romImage, ROM_LIMIT_8080);
+    PROFILE_INITIALIZE(romImage)
 
-    free(romBuffer);
     return state;
 }
 
@@ -71,7 +73,12 @@ void destroyCPU(State8080 *state)
 
 void executeNextInstruction(State8080 *state)
 {
+    // Diagnostic programs are not confined to ROM like Space Invaders is
+    #ifndef CPU_DIAG
     if(state->pc < ROM_LIMIT_8080){
+    #else
+    if(1){
+    #endif
         uint8_t operation = 0;  // next instruction opcode
         uint8_t operands[2] = {0xff, 0xff};  // next instruction operands, default 0xff as it would standout more than 0x00
         unsigned int instructionSize = 0;
@@ -90,7 +97,7 @@ void executeNextInstruction(State8080 *state)
 
         executeInstructionByOpcode(operation, operands, state);
     }else{
-        logger("Error! Attempted to execute instruction outside of ROM!\n");
+        LOG(LOG_ERROR, "Error! Attempted to execute instruction outside of ROM!\n");
         exit(0);
     }
 }
@@ -104,6 +111,35 @@ uint8_t *getVideoRAM(State8080 *state)
     return vramContents;
 }
 
+unsigned int disassembleInstruction(const State8080 *state, uint16_t address, char *text, size_t textSize)
+{
+    uint8_t opcode = state->memory[address];
+    unsigned int instructionSize = (unsigned int)instructionSizes[opcode];
+    uint16_t operand = (uint16_t)(state->memory[(uint16_t)(address+1)]);
+    if(instructionSize == 3){
+        operand |= ((uint16_t)(state->memory[(uint16_t)(address+2)]))<<8;
+    }
+
+    // Mnemonics name their operand as D8, D16 or adr, e.g. "LXI B;D16"
+    const char *mnemonic = instructions[opcode];
+    const char *operandName = strstr(mnemonic, "D16");
+    if(operandName == NULL){
+        operandName = strstr(mnemonic, "adr");
+    }
+    if(operandName == NULL){
+        operandName = strstr(mnemonic, "D8");
+    }
+
+    if(operandName == NULL || instructionSize < 2){
+        snprintf(text, textSize, "%s", mnemonic);
+    }else{
+        snprintf(text, textSize, "%.*s$%0*x", (int)(operandName-mnemonic), mnemonic,
+                 (instructionSize == 3) ? 4 : 2, operand);
+    }
+
+    return (instructionSize > 0) ? instructionSize : 1;
+}
+
 void generateInterrupt(uint8_t interruptNum, State8080 *state)
 {
     if(interruptNum < 0x08){
@@ -120,33 +156,43 @@ void generateInterrupt(uint8_t interruptNum, State8080 *state)
             // Without this line, the instr pointed to by the current PC value will be skipped after the ISR is done.
             state->pc -= 1;
 
+            PROFILE_INTERRUPT_START(state)
             executeInstructionByOpcode(interruptOpcode, fakeOperands, state);
+            PROFILE_INTERRUPT_END(state)
         }
     }else{
-        logger("Warning: Invalid interrupt attempted!\n");
+        LOG(LOG_WARNING, "Warning: Invalid interrupt attempted!\n");
     }
 }
 
 /**
  * Returns a pointer to the stored binary derived from an input FILE
  * @param romFile - pointer to FILE whose data should be stored
- * @return - uint8_t pointer to stored contents
+ * @return - uint8_t pointer to stored contents, or NULL if the file could not be read
  */
 uint8_t *getRomBuffer(FILE *romFile)
 {
-    int romSizeInBytes = 0;
+    long romSizeInBytes = 0;
     uint8_t *romBuffer;
 
     // Get ROM size
     fseek(romFile, 0, SEEK_END);
     romSizeInBytes = ftell(romFile);
     fseek(romFile, 0, SEEK_SET);
+    if(romSizeInBytes <= 0){
+        LOG(LOG_ERROR, "Failed to get ROM size.\n");
+        return NULL;
+    }
 
     // Allocate memory for ROM
     romBuffer = mallocSet(romSizeInBytes);
 
     // Read ROM into buffer
-    fread(romBuffer, 1, romSizeInBytes, romFile);
+    if(fread(romBuffer, 1, romSizeInBytes, romFile) != (size_t)romSizeInBytes){
+        LOG(LOG_ERROR, "Failed to read ROM.\n");
+        free(romBuffer);
+        return NULL;
+    }
 
     return romBuffer;
 }
@@ -173,8 +219,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
     uint16_t targetAddress;
     uint16_t oldMemValue;
     uint16_t newMemValue;
+    bool conditionMet = true;  // Conditional instructions, and RST with interrupts disabled, charge cyclesNotTaken otherwise
 
-    if(DEBUG){
+    #if DEBUG
         logger("===\n");
         logger("%d:\n", numExec);
         logger("Operation: 0x%02x  %02x %02x\n", opcode, operands[0], operands[1]);
@@ -186,11 +233,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                state->flags.auxiliaryCarry, state->flags.carry);
         logger("Opcode: 0x%02x\n", opcode);
         logger("%s\n", instructions[opcode]);
-        logger("%d\n", instructionSizes[opcode]);
-        logger("%s\n", instructionFunctions[opcode]);
-        logger("%s\n\n", instructionFlags[opcode]);
+        logger("Size: %d, cycles: %u/%u\n", instructionSizes[opcode], instructionCycles[opcode], instructionCyclesNotTaken[opcode]);
+        logger("Flags read: 0x%02x, written: 0x%02x\n\n", instructionFlagsRead[opcode], instructionFlagsWritten[opcode]);
         logger("===\n");
-    }
+    #endif
 
     switch(opcode){
         case 0x00:
@@ -208,7 +254,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // memory[(B)(C)] = A
             moveDataToBCMemory(state->a, state);
             state->pc += 1;
-            state->cyclesCompleted += 7;
             break;
         case 0x03: 
             // INX B
@@ -246,7 +291,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 // A:0 = 0
             }
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x08: 
             // Unimplemented
@@ -264,7 +308,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             sourceAddress = getValueBC(state);
             state->a = readMem(sourceAddress, state);
             state->pc += 1;
-            state->cyclesCompleted += 7;
             break;
         case 0x0B: 
             //DCX B
@@ -303,7 +346,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 // A:7 = 0
             }
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x10: 
             // Unimplemented
@@ -320,7 +362,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // memory[(D)(E)] = A
             moveDataToDEMemory(state->a, state);
             state->pc += 1;
-            state->cyclesCompleted += 7;
             break;
         case 0x13: 
             // INX D
@@ -353,7 +394,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             state->a = (state->a)<<1;  // rotate accumulator
             state->a = (state->a) | tempCarry;  // A:0 = old CY
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x18: 
             // Unimplemented
@@ -371,7 +411,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             sourceAddress = getValueDE(state);
             state->a = readMem(sourceAddress, state);
             state->pc += 1;
-            state->cyclesCompleted += 7;
             break;
         case 0x1B:
             // DCX D
@@ -404,7 +443,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             state->a = (state->a)>>1;  // rotate Accumulator
             state->a = (state->a) | (tempCarry<<7);  // bit 7 = old carry
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x20: 
             // RIM
@@ -428,7 +466,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             writeMem(orderedOperands, state->l, state);
             writeMem(orderedOperands+1, state->h, state);
             state->pc += 3;
-            state->cyclesCompleted += 16;
             break;
         case 0x23: 
             // INX H
@@ -491,7 +528,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Do standard arithmetic instruction stuff
             checkStandardArithmeticFlags(state->a, state);
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x28: 
             // Unimplemented
@@ -510,7 +546,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             state->l = readMem(orderedOperands, state);
             state->h = readMem(orderedOperands+1, state);
             state->pc += 3;
-            state->cyclesCompleted += 16;
             break;
         case 0x2B:
             // DCX H
@@ -538,7 +573,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // A = !A
             state->a = ~(state->a);
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x30: 
             // SIM
@@ -552,7 +586,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Load Immediate into Stack Pointer
             state->sp = orderedOperands;
             state->pc += 3;
-            state->cyclesCompleted += 10;
             break;
         case 0x32: 
             // STA addr
@@ -560,14 +593,12 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // memory[address] = A
             writeMem(orderedOperands, state->a, state);
             state->pc += 3;
-            state->cyclesCompleted += 13;
             break;
         case 0x33:
             // INX SP
             // Increment Stack Pointer
             state->sp += 1;
             state->pc += 1;
-            state->cyclesCompleted += 5;
             break;
         case 0x34: 
             // INR M
@@ -581,7 +612,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             checkStandardArithmeticFlags(memoryByte, state);
             moveDataToHLMemory(memoryByte, state);
             state->pc += 1;
-            state->cyclesCompleted += 10;
             break;
         case 0x35:
             // DCR M
@@ -594,7 +624,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             writeMem(targetAddress, newMemValue, state);
             checkStandardArithmeticFlags(newMemValue, state);
             state->pc += 1;
-            state->cyclesCompleted += 10;
             break;
         case 0x36: 
             // MVI M; D8
@@ -602,14 +631,12 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // memory[(H)(L)] = D8
             moveDataToHLMemory(operands[0], state);
             state->pc += 2;
-            state->cyclesCompleted += 10;
             break;
         case 0x37: 
             // STC
             // Set Carry flag
             state->flags.carry = 1;
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x38: 
             // Unimplemented
@@ -627,14 +654,12 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // A = address
             state->a = readMem(orderedOperands, state);
             state->pc += 3;
-            state->cyclesCompleted += 13;
             break;
         case 0x3B: 
             // DCX SP
             // Decrement stack pointer
             state->sp -= 1;
             state->pc += 1;
-            state->cyclesCompleted += 5;
             break;
         case 0x3C: 
             // INR A
@@ -659,7 +684,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // CY = !CY
             state->flags.carry = ~(state->flags.carry);
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0x40:
             // MOV B, B
@@ -1009,7 +1033,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             state->a = addWithCheckCY(state->a, tempA, state);
             checkStandardArithmeticFlags(state->a, state);
             state->pc += 1;
-            state->cyclesCompleted += 7;
             break;
         case 0x87:
             // ADD A
@@ -1064,7 +1087,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 checkStandardArithmeticFlags(state->a, state);
             }
             state->pc += 1;
-            state->cyclesCompleted += 7;
             break;
         case 0x8F:
             // ADC A
@@ -1107,7 +1129,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // A = A - memory[(H)(L)]
             moveDataFromHLMemory(&memoryByte, state);
             SUB_R(memoryByte, state);
-            state->cyclesCompleted += 3;
             break;
         case 0x97:
             // SUB A
@@ -1150,7 +1171,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // A = A - (memory[(H)(L)] + CY)
             moveDataFromHLMemory(&memoryByte, state);
             SBB_R(memoryByte, state);
-            state->cyclesCompleted += 3;
             break;
         case 0x9F:
             // SBB A
@@ -1201,7 +1221,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy(reset),ac
             moveDataFromHLMemory(&memoryByte, state);
             ANA_R(memoryByte, state);
-            state->cyclesCompleted += 3;
             break;
         case 0xA7:
             // ANA A
@@ -1254,7 +1273,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy(reset),ac(reset)
             moveDataFromHLMemory(&memoryByte, state);
             XRA_R(memoryByte, state);
-            state->cyclesCompleted += 3;
             break;
         case 0xAF: 
             // XRA A
@@ -1300,7 +1318,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy(reset),ac(reset)
             moveDataFromHLMemory(&memoryByte, state);
             ORA_R(memoryByte, state);
-            state->cyclesCompleted += 3;
             break;
         case 0xB7:
             // ORA A
@@ -1344,7 +1361,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy,ac
             moveDataFromHLMemory(&subtrahend, state);
             CMP_R(subtrahend, state);
-            state->cyclesCompleted += 3;
             break;
         case 0xBF:
             // CMP A
@@ -1356,10 +1372,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Return if Not Zero
             if(!(state->flags.zero)){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xC1: 
@@ -1374,7 +1389,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
 			}else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
 			}
             break;
         case 0xC3: 
@@ -1389,7 +1404,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 11;
+                conditionMet = false;
             }
             break;
         case 0xC5: 
@@ -1406,10 +1421,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             state->a = addWithCheckCY(state->a, operands[0], state);
             checkStandardArithmeticFlags(state->a, state);
             state->pc += 2;
-            state->cyclesCompleted += 7;
             break;
         case 0xC7:
             // RST 0
+            conditionMet = state->interruptsEnabled;
             RST(0, state);
             break;
         case 0xC8:
@@ -1417,10 +1432,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Return if Zero
             if(state->flags.zero){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xC9: 
@@ -1435,7 +1449,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
             }
             break;
         case 0xCB: 
@@ -1449,34 +1463,12 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xCD:
             // CALL addr
-            #ifdef CPU_DIAG
-            // Code snippet taken from http://www.emulator101.com/full-8080-emulation.html
-            if(orderedOperands == 0x5){
-                if (state->c == 9){
-                    uint16_t offset = ((uint16_t)(state->d)<<8) | (state->e);
-                    char *str = (char*)(&(state->memory[offset+3]));  //skip the prefix bytes
-                    while (*str != '$'){
-                        logger("%c", *str++);
-                    }
-                    logger("\n");
-                }else if(state->c == 2){
-                    // saw this in the inspected code, never saw it called
-                    logger("print char routine called\n");
-                }
-            }else if (orderedOperands == 0){
-                exit(0);
-            }else{
-                CALL(orderedOperands, state);
-            }
-            #endif
-            #ifndef CPU_DIAG
             CALL(orderedOperands, state);
-            #endif
             break;
         case 0xCE: 
             // ACI d8
@@ -1485,10 +1477,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy,ac
             ADC_R(operands[0], state);
             state->pc += 1;
-            state->cyclesCompleted += 3;
             break;
         case 0xCF:
             // RST 1
+            conditionMet = state->interruptsEnabled;
             RST(1, state);
             break;
         case 0xD0:
@@ -1496,10 +1488,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Return if No Carry
             if(!(state->flags.carry)){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xD1: 
@@ -1515,7 +1506,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
             }
             break;
         case 0xD3: 
@@ -1526,7 +1517,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             portNumber = operands[0];
             state->outputBuffers[portNumber] = state->a;
             state->pc += 2;
-            state->cyclesCompleted += 10;
             break;
         case 0xD4: 
             // CNC adr
@@ -1535,7 +1525,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
 		    }else{
                 state->pc += 3;
-                state->cyclesCompleted += 11;
+                conditionMet = false;
 		    }
             break;
         case 0xD5: 
@@ -1550,10 +1540,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy,ac
             SUB_R(operands[0], state);
             state->pc += 1;
-            state->cyclesCompleted += 3;
             break;
         case 0xD7:
             // RST 2
+            conditionMet = state->interruptsEnabled;
             RST(2, state);
             break;
         case 0xD8: 
@@ -1561,10 +1551,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Return if Carry
             if(state->flags.carry){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xD9: 
@@ -1579,7 +1568,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
             }
             break;
         case 0xDB: 
@@ -1589,7 +1578,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             portNumber = operands[0];
             state->a = state->inputBuffers[portNumber];
             state->pc += 2;
-            state->cyclesCompleted += 10;
             break;
         case 0xDC: 
             // CC addr
@@ -1599,7 +1587,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 11;
+                conditionMet = false;
             }
             break;
         case 0xDD: 
@@ -1613,10 +1601,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy,ac
             SBB_R(operands[0], state);
             state->pc += 1;
-            state->cyclesCompleted += 3;
             break;
         case 0xDF:
             // RST 3
+            conditionMet = state->interruptsEnabled;
             RST(3, state);
             break;
         case 0xE0: 
@@ -1625,10 +1613,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // If PO, RET
             if(!(state->flags.parity)){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xE1: 
@@ -1644,7 +1631,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
             }
             break;
         case 0xE3:
@@ -1659,7 +1646,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             writeMem(state->sp, tempL, state);
             writeMem((state->sp)+1, tempH, state);
             state->pc += 1;
-            state-> cyclesCompleted += 18;
             break;
         case 0xE4: 
             // CPO addr
@@ -1669,7 +1655,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 11;
+                conditionMet = false;
             }
             break;
         case 0xE5: 
@@ -1684,10 +1670,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             //Flags: z,s,p,cy(reset),ac(reset)
             ANA_R(operands[0], state);
             state->pc += 1;
-            state->cyclesCompleted += 3;
             break;
         case 0xE7:
             // RST 4
+            conditionMet = state->interruptsEnabled;
             RST(4, state);
             break;
         case 0xE8: 
@@ -1696,10 +1682,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // if PE, RET
             if(state->flags.parity){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xE9:
@@ -1708,7 +1693,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // PCH = H
             // PCL = L
             state->pc = getValueHL(state);
-            state->cyclesCompleted += 5;
             break;
         case 0xEA: 
             // JPE addr
@@ -1718,7 +1702,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
             }
             break;
         case 0xEB: 
@@ -1735,7 +1719,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             state->e = tempL;
             
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0xEC:
             // CPE addr
@@ -1744,7 +1727,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 11;
+                conditionMet = false;
             }
             break;
         case 0xED: 
@@ -1758,10 +1741,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy(reset),ac(reset)
             XRA_R(operands[0], state);
             state->pc += 1;
-            state->cyclesCompleted += 3;
             break;
         case 0xEF:
             // RST 5
+            conditionMet = state->interruptsEnabled;
             RST(5, state);
             break;
         case 0xF0: 
@@ -1770,10 +1753,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // if Pos, RET
             if(!(state->flags.sign)){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xF1: 
@@ -1791,7 +1773,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
             }
             break;
         case 0xF3: 
@@ -1799,7 +1781,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Disable interrupts
             state->interruptsEnabled = 0;
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0xF4: 
             // CP addr
@@ -1809,7 +1790,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 11;
+                conditionMet = false;
             }
             break;
         case 0xF5: 
@@ -1825,10 +1806,10 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Flags: z,s,p,cy(reset),ac(reset)
             ORA_R(operands[0], state);
             state->pc += 1;
-            state->cyclesCompleted += 3;
             break;
         case 0xF7:
             // RST 6
+            conditionMet = state->interruptsEnabled;
             RST(6, state);
             break;
         case 0xF8: 
@@ -1837,10 +1818,9 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // If S, RET
             if(state->flags.sign){
                 RET(state);
-                state->cyclesCompleted += 1;
             }else{
                 state->pc += 1;
-                state->cyclesCompleted += 5;
+                conditionMet = false;
             }
             break;
         case 0xF9: 
@@ -1850,7 +1830,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // SP.lo = L
             state->sp = getValueHL(state);
             state->pc += 1;
-            state->cyclesCompleted += 5;
             break;
         case 0xFA: 
             // JM Addr
@@ -1860,7 +1839,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 JMP(orderedOperands, state);
             }else{
                 state->pc += 3;
-                state->cyclesCompleted += 10;
+                conditionMet = false;
             }
             break;
         case 0xFB: 
@@ -1868,7 +1847,6 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // Enable Interrupt
             state->interruptsEnabled = 1;
             state->pc += 1;
-            state->cyclesCompleted += 4;
             break;
         case 0xFC: 
             // CM addr
@@ -1878,7 +1856,7 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
                 CALL(orderedOperands, state);
             }else {
                 state->pc += 3;
-                state->cyclesCompleted += 11;
+                conditionMet = false;
             }
             break;
         case 0xFD: 
@@ -1894,1066 +1872,18 @@ void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *st
             // System manual does not explicitly state this, but programmer's manual does
             CMP_R(operands[0], state);
             state->pc += 1;
-            state->cyclesCompleted += 3;
             break;
         case 0xFF:
             // RST 7
+            conditionMet = state->interruptsEnabled;
             RST(7, state);
             break;
 	}
 
+	// Cycles are charged here for every instruction, the cases above only carry it out
+	state->cyclesCompleted += conditionMet ? instructionCycles[opcode] : instructionCyclesNotTaken[opcode];
+
+	#if DEBUG
 	numExec++;
+	#endif
 }
-
-/**
-* Initialize global variables.
-* 
-* Do this here because the initializations are about 1000 lines.
-* This could be done elsewhere, but it would clutter the top of the file.
-* Delegate initialization to a function so it can happily remain at the bottom of the file.
-*
-* @return void
-*/
-void initializeGlobals()
-{
-    char instructionsLocal[256][20] = {
-        "NOP",
-        "LXI B;D16",
-        "STAX B",
-        "INX B",
-        "INR B",
-        "DCR B",
-        "MVI B; D8",
-        "RLC",
-        "-",
-        "DAD B",
-        "LDAX B",
-        "DCX B",
-        "INR C",
-        "DCR C",
-        "MVI C;D8",
-        "RRC",
-        "-",
-        "LXI D;D16",
-        "STAX D",
-        "INX D",
-        "INR D",
-        "DCR D",
-        "MVI D; D8",
-        "RAL",
-        "-",
-        "DAD D",
-        "LDAX D",
-        "DCX D",
-        "INR E",
-        "DCR E",
-        "MVI E;D8",
-        "RAR",
-        "RIM",
-        "LXI H;D16",
-        "SHLD adr",
-        "INX H",
-        "INR H",
-        "DCR H",
-        "MVI H;D8",
-        "DAA",
-        "-",
-        "DAD H",
-        "LHLD adr",
-        "DCX H",
-        "INR L",
-        "DCR L",
-        "MVI L; D8",
-        "CMA",
-        "SIM",
-        "LXI SP; D16",
-        "STA adr",
-        "INX SP",
-        "INR M",
-        "DCR M",
-        "MVI M;D8",
-        "STC",
-        "-",
-        "DAD SP",
-        "LDA adr",
-        "DCX SP",
-        "INR A",
-        "DCR A",
-        "MVI A;D8",
-        "CMC",
-        "MOV B;B",
-        "MOV B;C",
-        "MOV B;D",
-        "MOV B;E",
-        "MOV B;H",
-        "MOV B;L",
-        "MOV B;M",
-        "MOV B;A",
-        "MOV C;B",
-        "MOV C;C",
-        "MOV C;D",
-        "MOV C;E",
-        "MOV C;H",
-        "MOV C;L",
-        "MOV C;M",
-        "MOV C;A",
-        "MOV D;B",
-        "MOV D;C",
-        "MOV D;D",
-        "MOV D;E",
-        "MOV D;H",
-        "MOV D;L",
-        "MOV D;M",
-        "MOV D;A",
-        "MOV E;B",
-        "MOV E;C",
-        "MOV E;D",
-        "MOV E;E",
-        "MOV E;H",
-        "MOV E;L",
-        "MOV E;M",
-        "MOV E;A",
-        "MOV H;B",
-        "MOV H;C",
-        "MOV H;D",
-        "MOV H;E",
-        "MOV H;H",
-        "MOV H;L",
-        "MOV H;M",
-        "MOV H;A",
-        "MOV L;B",
-        "MOV L;C",
-        "MOV L;D",
-        "MOV L;E",
-        "MOV L;H",
-        "MOV L;L",
-        "MOV L;M",
-        "MOV L;A",
-        "MOV M;B",
-        "MOV M;C",
-        "MOV M;D",
-        "MOV M;E",
-        "MOV M;H",
-        "MOV M;L",
-        "HLT",
-        "MOV M;A",
-        "MOV A;B",
-        "MOV A;C",
-        "MOV A;D",
-        "MOV A;E",
-        "MOV A;H",
-        "MOV A;L",
-        "MOV A;M",
-        "MOV A;A",
-        "ADD B",
-        "ADD C",
-        "ADD D",
-        "ADD E",
-        "ADD H",
-        "ADD L",
-        "ADD M",
-        "ADD A",
-        "ADC B",
-        "ADC C",
-        "ADC D",
-        "ADC E",
-        "ADC H",
-        "ADC L",
-        "ADC M",
-        "ADC A",
-        "SUB B",
-        "SUB C",
-        "SUB D",
-        "SUB E",
-        "SUB H",
-        "SUB L",
-        "SUB M",
-        "SUB A",
-        "SBB B",
-        "SBB C",
-        "SBB D",
-        "SBB E",
-        "SBB H",
-        "SBB L",
-        "SBB M",
-        "SBB A",
-        "ANA B",
-        "ANA C",
-        "ANA D",
-        "ANA E",
-        "ANA H",
-        "ANA L",
-        "ANA M",
-        "ANA A",
-        "XRA B",
-        "XRA C",
-        "XRA D",
-        "XRA E",
-        "XRA H",
-        "XRA L",
-        "XRA M",
-        "XRA A",
-        "ORA B",
-        "ORA C",
-        "ORA D",
-        "ORA E",
-        "ORA H",
-        "ORA L",
-        "ORA M",
-        "ORA A",
-        "CMP B",
-        "CMP C",
-        "CMP D",
-        "CMP E",
-        "CMP H",
-        "CMP L",
-        "CMP M",
-        "CMP A",
-        "RNZ",
-        "POP B",
-        "JNZ adr",
-        "JMP adr",
-        "CNZ adr",
-        "PUSH B",
-        "ADI D8",
-        "RST 0",
-        "RZ",
-        "RET",
-        "JZ adr",
-        "-",
-        "CZ adr",
-        "CALL adr",
-        "ACI D8",
-        "RST 1",
-        "RNC",
-        "POP D",
-        "JNC adr",
-        "OUT D8",
-        "CNC adr",
-        "PUSH D",
-        "SUI D8",
-        "RST 2",
-        "RC",
-        "-",
-        "JC adr",
-        "IN D8",
-        "CC adr",
-        "-",
-        "SBI D8",
-        "RST 3",
-        "RPO",
-        "POP H",
-        "JPO adr",
-        "XTHL",
-        "CPO adr",
-        "PUSH H",
-        "ANI D8",
-        "RST 4",
-        "RPE",
-        "PCHL",
-        "JPE adr",
-        "XCHG",
-        "CPE adr",
-        "-",
-        "XRI D8",
-        "RST 5",
-        "RP",
-        "POP PSW",
-        "JP adr",
-        "DI",
-        "CP adr",
-        "PUSH PSW",
-        "ORI D8",
-        "RST 6",
-        "RM",
-        "SPHL",
-        "JM adr",
-        "EI",
-        "CM adr",
-        "-",
-        "CPI D8",
-        "RST 7"
-    };
-
-    char instructionSizesLocal[256] = {
-        1,
-        3,
-        1,
-        1,
-        1,
-        1,
-        2,
-        1,
-        0,
-        1,
-        1,
-        1,
-        1,
-        1,
-        2,
-        1,
-        0,
-        3,
-        1,
-        1,
-        1,
-        1,
-        2,
-        1,
-        0,
-        1,
-        1,
-        1,
-        1,
-        1,
-        2,
-        1,
-        1,
-        3,
-        3,
-        1,
-        1,
-        1,
-        2,
-        1,
-        0,
-        1,
-        3,
-        1,
-        1,
-        1,
-        2,
-        1,
-        1,
-        3,
-        3,
-        1,
-        1,
-        1,
-        2,
-        1,
-        0,
-        1,
-        3,
-        1,
-        1,
-        1,
-        2,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        1,
-        3,
-        3,
-        3,
-        1,
-        2,
-        1,
-        1,
-        1,
-        3,
-        0,
-        3,
-        3,
-        2,
-        1,
-        1,
-        1,
-        3,
-        2,
-        3,
-        1,
-        2,
-        1,
-        1,
-        0,
-        3,
-        2,
-        3,
-        0,
-        2,
-        1,
-        1,
-        1,
-        3,
-        1,
-        3,
-        1,
-        2,
-        1,
-        1,
-        1,
-        3,
-        1,
-        3,
-        0,
-        2,
-        1,
-        1,
-        1,
-        3,
-        1,
-        3,
-        1,
-        2,
-        1,
-        1,
-        1,
-        3,
-        1,
-        3,
-        0,
-        2,
-        1
-    };
-
-    char instructionFlagsLocal[256][20] = {
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "CY",
-        "",
-        "CY",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "CY",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "CY",
-        "",
-        "CY",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "CY",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "",
-        "",
-        "CY",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "CY",
-        "",
-        "CY",
-        "",
-        "",
-        "Z; S; P; AC",
-        "Z; S; P; AC",
-        "",
-        "CY",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "",
-        "Z; S; P; CY; AC",
-        ""
-    };
-
-    char instructionFunctionsLocal[256][100] = {
-        "",
-        "B <- byte 3; C <- byte 2",
-        "(BC) <- A",
-        "BC <- BC+1",
-        "B <- B+1",
-        "B <- B-1",
-        "B <- byte 2",
-        "A = A << 1; bit 0 = prev bit 7; CY = prev bit 7",
-        "",
-        "HL = HL + BC",
-        "A <- (BC)",
-        "BC = BC-1",
-        "C <- C+1",
-        "C <-C-1",
-        "C <- byte 2",
-        "A = A >> 1; bit 7 = prev bit 0; CY = prev bit 0",
-        "",
-        "D <- byte 3; E <- byte 2",
-        "(DE) <- A",
-        "DE <- DE + 1",
-        "D <- D+1",
-        "D <- D-1",
-        "D <- byte 2",
-        "A = A << 1; bit 0 = prev CY; CY = prev bit 7",
-        "",
-        "HL = HL + DE",
-        "A <- (DE)",
-        "DE = DE-1",
-        "E <-E+1",
-        "E <- E-1",
-        "E <- byte 2",
-        "A = A >> 1; bit 7 = prev bit 7; CY = prev bit 0",
-        "special",
-        "H <- byte 3; L <- byte 2",
-        "(adr) <-L; (adr+1)<-H",
-        "HL <- HL + 1",
-        "H <- H+1",
-        "H <- H-1",
-        "H <- byte 2",
-        "special",
-        "",
-        "HL = HL + HL",
-        "L <- (adr); H<-(adr+1)",
-        "HL = HL-1",
-        "L <- L+1",
-        "L <- L-1",
-        "L <- byte 2",
-        "A <- !A",
-        "special",
-        "SP.hi <- byte 3; SP.lo <- byte 2",
-        "(adr) <- A",
-        "SP = SP + 1",
-        "(H)(L) <- (H)(L)+1",
-        "(H)(L) <- (H)(L)-1",
-        "(H)(L) <- byte 2",
-        "CY = 1",
-        "",
-        "HL = HL + SP",
-        "A <- (adr)",
-        "SP = SP-1",
-        "A <- A+1",
-        "A <- A-1",
-        "A <- byte 2",
-        "CY=!CY",
-        "B <- B",
-        "B <- C",
-        "B <- D",
-        "B <- E",
-        "B <- H",
-        "B <- L",
-        "B <- (H)(L)",
-        "B <- A",
-        "C <- B",
-        "C <- C",
-        "C <- D",
-        "C <- E",
-        "C <- H",
-        "C <- L",
-        "C <- (H)(L)",
-        "C <- A",
-        "D <- B",
-        "D <- C",
-        "D <- D",
-        "D <- E",
-        "D <- H",
-        "D <- L",
-        "D <- (H)(L)",
-        "D <- A",
-        "E <- B",
-        "E <- C",
-        "E <- D",
-        "E <- E",
-        "E <- H",
-        "E <- L",
-        "E <- (H)(L)",
-        "E <- A",
-        "H <- B",
-        "H <- C",
-        "H <- D",
-        "H <- E",
-        "H <- H",
-        "H <- L",
-        "H <- (H)(L)",
-        "H <- A",
-        "L <- B",
-        "L <- C",
-        "L <- D",
-        "L <- E",
-        "L <- H",
-        "L <- L",
-        "L <- (H)(L)",
-        "L <- A",
-        "(H)(L) <- B",
-        "(H)(L) <- C",
-        "(H)(L) <- D",
-        "(H)(L) <- E",
-        "(H)(L) <- H",
-        "(H)(L) <- L",
-        "special",
-        "(H)(L) <- A",
-        "A <- B",
-        "A <- C",
-        "A <- D",
-        "A <- E",
-        "A <- H",
-        "A <- L",
-        "A <- (H)(L)",
-        "A <- A",
-        "A <- A + B",
-        "A <- A + C",
-        "A <- A + D",
-        "A <- A + E",
-        "A <- A + H",
-        "A <- A + L",
-        "A <- A + (H)(L)",
-        "A <- A + A",
-        "A <- A + B + CY",
-        "A <- A + C + CY",
-        "A <- A + D + CY",
-        "A <- A + E + CY",
-        "A <- A + H + CY",
-        "A <- A + L + CY",
-        "A <- A + (H)(L) + CY",
-        "A <- A + A + CY",
-        "A <- A - B",
-        "A <- A - C",
-        "A <- A + D",
-        "A <- A - E",
-        "A <- A + H",
-        "A <- A - L",
-        "A <- A + (H)(L)",
-        "A <- A - A",
-        "A <- A - B - CY",
-        "A <- A - C - CY",
-        "A <- A - D - CY",
-        "A <- A - E - CY",
-        "A <- A - H - CY",
-        "A <- A - L - CY",
-        "A <- A - (H)(L) - CY",
-        "A <- A - A - CY",
-        "A <- A & B",
-        "A <- A & C",
-        "A <- A & D",
-        "A <- A & E",
-        "A <- A & H",
-        "A <- A & L",
-        "A <- A & (H)(L)",
-        "A <- A & A",
-        "A <- A ^ B",
-        "A <- A ^ C",
-        "A <- A ^ D",
-        "A <- A ^ E",
-        "A <- A ^ H",
-        "A <- A ^ L",
-        "A <- A ^ (H)(L)",
-        "A <- A ^ A",
-        "A <- A | B",
-        "A <- A | C",
-        "A <- A | D",
-        "A <- A | E",
-        "A <- A | H",
-        "A <- A | L",
-        "A <- A | (H)(L)",
-        "A <- A | A",
-        "A - B",
-        "A - C",
-        "A - D",
-        "A - E",
-        "A - H",
-        "A - L",
-        "A - (H)(L)",
-        "A - A",
-        "if NZ; RET",
-        "C <- (sp); B <- (sp+1); sp <- sp+2",
-        "if NZ; PC <- adr",
-        "PC <= adr",
-        "if NZ; CALL adr",
-        "(sp-2)<-C; (sp-1)<-B; sp <- sp - 2",
-        "A <- A + byte",
-        "CALL $0",
-        "if Z; RET",
-        "PC.lo <- (sp); PC.hi<-(sp+1); SP <- SP+2",
-        "if Z; PC <- adr",
-        "",
-        "if Z; CALL adr",
-        "(SP-1)<-PC.hi;(SP-2)<-PC.lo;SP<-SP-2;PC=adr",
-        "A <- A + data + CY",
-        "CALL $8",
-        "if NCY; RET",
-        "E <- (sp); D <- (sp+1); sp <- sp+2",
-        "if NCY; PC<-adr",
-        "special",
-        "if NCY; CALL adr",
-        "(sp-2)<-E; (sp-1)<-D; sp <- sp - 2",
-        "A <- A - data",
-        "CALL $10",
-        "if CY; RET",
-        "",
-        "if CY; PC<-adr",
-        "special",
-        "if CY; CALL adr",
-        "",
-        "A <- A - data - CY",
-        "CALL $18",
-        "if PO; RET",
-        "L <- (sp); H <- (sp+1); sp <- sp+2",
-        "if PO; PC <- adr",
-        "L <-> (SP); H <-> (SP+1) ",
-        "if PO; CALL adr",
-        "(sp-2)<-L; (sp-1)<-H; sp <- sp - 2",
-        "A <- A & data",
-        "CALL $20",
-        "if PE; RET",
-        "PC.hi <- H; PC.lo <- L",
-        "if PE; PC <- adr",
-        "H <-> D; L <-> E",
-        "if PE; CALL adr",
-        "",
-        "A <- A ^ data",
-        "CALL $28",
-        "if P; RET",
-        "flags <- (sp); A <- (sp+1); sp <- sp+2",
-        "if S=0; PC <- adr",
-        "special",
-        "if P; PC <- adr",
-        "(sp-2)<-flags; (sp-1)<-A; sp <- sp - 2",
-        "A <- A | data",
-        "CALL $30",
-        "if M; RET",
-        "SP=HL",
-        "if M; PC <- adr",
-        "special",
-        "if M; CALL adr",
-        "",
-        "A - data",
-        "CALL $38"
-    };
-
-    memcpy(instructions, instructionsLocal, 256*20);
-    memcpy(instructionSizes, instructionSizesLocal, 256);
-    memcpy(instructionFlags, instructionFlagsLocal, 256*20);
-    memcpy(instructionFunctions, instructionFunctionsLocal, 256*100);
-}
\ No newline at end of file
@@ -12,10 +12,11 @@
 
 /**
  * Returns a pointer to an emulated Intel 8080 cpu state
- * All of the cpu's registers and memory will be zeroed, except for ROM, which contains Space Invaders
+ * All of the cpu's registers and memory will be zeroed, except for ROM, which is copied from romImage
+ * @param romImage - ROM_LIMIT_8080 bytes to place at the start of memory
  * @return Initialized 8080 state pointer
  */
-State8080 *initializeCPU();
+State8080 *initializeCPU(const uint8_t *romImage);
 
 /**
  * Frees memory allocated for a State8080 struct
@@ -40,7 +41,7 @@ void generateInterrupt(uint8_t interruptNum, State8080 *state);
 /**
  * Returns a pointer to the stored binary derived from an input FILE
  * @param romFile - pointer to FILE whose data should be stored
- * @return - pointer to stored contents
+ * @return - pointer to stored contents, or NULL if the file could not be read
  */
 uint8_t *getRomBuffer(FILE *romFile);
 
@@ -51,4 +52,23 @@ uint8_t *getRomBuffer(FILE *romFile);
  */
 void executeNextInstruction(State8080 *state);
 
+/**
+ * Execute an instruction that has already been fetched
+ * The program counter must still point at the instruction.
+ * @param opcode - The instruction's opcode
+ * @param operands - The instruction's operand bytes, in the order they appear in memory
+ * @param state - The 8080 state
+ */
+void executeInstructionByOpcode(uint8_t opcode, uint8_t *operands, State8080 *state);
+
+/**
+ * Writes the assembly for the instruction at an address, e.g. "JMP $18d4"
+ * @param state - The 8080 state
+ * @param address - Address of the instruction
+ * @param text - Buffer for the assembly
+ * @param textSize - Size of the buffer
+ * @return - Size of the instruction in bytes
+ */
+unsigned int disassembleInstruction(const State8080 *state, uint16_t address, char *text, size_t textSize);
+
 #endif //INTEL_8080_EMULATOR_SHELL8080_H
@@ -0,0 +1,151 @@
+/***********************************************************************************
+ *
+ * Source for ROM symbol maps
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "symbolMap.h"
+#include "helpers.h"
+
+#define INITIAL_SYMBOLS 256
+
+int parseSymbolLine(char *line, RomSymbol *symbol);
+int compareSymbolAddresses(const void *first, const void *second);
+
+SymbolMap *loadSymbolMap(const char *path)
+{
+    FILE *symbolFile = fopen(path, "r");
+    if(symbolFile == NULL){
+        logger("Failed to open symbol file %s\n", path);
+        return NULL;
+    }
+
+    SymbolMap *map = mallocSet(sizeof(SymbolMap));
+    uint32_t maxSymbols = INITIAL_SYMBOLS;
+    map->symbols = mallocSet(maxSymbols*sizeof(RomSymbol));
+    char line[256];
+    unsigned int lineNum = 0;
+    while(fgets(line, sizeof(line), symbolFile) != NULL){
+        lineNum++;
+        if(map->numSymbols == maxSymbols){
+            maxSymbols *= 2;
+            RomSymbol *symbols = realloc(map->symbols, maxSymbols*sizeof(RomSymbol));
+            if(symbols == NULL){
+                logger("Failed to load symbol file %s\n", path);
+                fclose(symbolFile);
+                destroySymbolMap(map);
+                return NULL;
+            }
+            map->symbols = symbols;
+        }
+
+        int parsed = parseSymbolLine(line, &(map->symbols[map->numSymbols]));
+        if(parsed == 1){
+            map->numSymbols++;
+        }else if(parsed < 0){
+            logger("Skipping line %u of %s, expected an address, a name and an optional size\n", lineNum, path);
+        }
+    }
+    fclose(symbolFile);
+
+    // Symbols without a size run up to the next one, those with a size never run past it
+    qsort(map->symbols, map->numSymbols, sizeof(RomSymbol), compareSymbolAddresses);
+    for(uint32_t symbolNum = 0; symbolNum < map->numSymbols; symbolNum++){
+        RomSymbol *symbol = &(map->symbols[symbolNum]);
+        uint32_t nextAddress = (symbolNum+1 < map->numSymbols) ? map->symbols[symbolNum+1].address : ROM_LIMIT_8080;
+        if(nextAddress < symbol->address){
+            nextAddress = MEMORY_SIZE_8080;  // Past the end of ROM
+        }
+        if(symbol->end == 0 || symbol->end > nextAddress){
+            symbol->end = (nextAddress > symbol->address) ? nextAddress : (uint32_t)symbol->address+1;
+        }
+    }
+
+    return map;
+}
+
+void destroySymbolMap(SymbolMap *map)
+{
+    if(map == NULL){
+        return;
+    }
+
+    free(map->symbols);
+    free(map);
+}
+
+const RomSymbol *findSymbol(const SymbolMap *map, uint16_t address)
+{
+    if(map == NULL || map->numSymbols == 0){
+        return NULL;
+    }
+
+    // Last symbol starting at or before the address
+    uint32_t low = 0;
+    uint32_t high = map->numSymbols;
+    while(high-low > 1){
+        uint32_t middle = low+(high-low)/2;
+        if(map->symbols[middle].address <= address){
+            low = middle;
+        }else{
+            high = middle;
+        }
+    }
+
+    const RomSymbol *symbol = &(map->symbols[low]);
+    if(address < symbol->address || address >= symbol->end){
+        return NULL;
+    }
+    return symbol;
+}
+
+void formatSymbolAddress(const SymbolMap *map, uint16_t address, char *text, size_t textSize)
+{
+    const RomSymbol *symbol = findSymbol(map, address);
+    if(symbol == NULL){
+        snprintf(text, textSize, "$%04x", address);
+    }else if(symbol->address == address){
+        snprintf(text, textSize, "%s", symbol->name);
+    }else{
+        snprintf(text, textSize, "%s+0x%x", symbol->name, address-symbol->address);
+    }
+}
+
+/**
+ * Reads a symbol from a line of a symbol file
+ * @param line - The line, comments are cut off of it
+ * @param symbol - Set to the symbol, with an end of 0 if no size was given
+ * @return int - 1 if a symbol was read, 0 for a blank line, -1 if the line is malformed
+ */
+int parseSymbolLine(char *line, RomSymbol *symbol)
+{
+    char *comment = strchr(line, ';');
+    if(comment != NULL){
+        *comment = '\0';
+    }
+
+    unsigned int address = 0;
+    unsigned int size = 0;
+    char name[SYMBOL_NAME_LENGTH];
+    int numFields = sscanf(line, "%x %47s %x", &address, name, &size);
+    if(numFields <= 0){
+        return 0;
+    }
+    if(numFields < 2 || address >= MEMORY_SIZE_8080 || (numFields == 3 && size == 0)){
+        return -1;
+    }
+
+    symbol->address = (uint16_t)address;
+    symbol->end = (numFields == 3) ? address+size : 0;
+    if(symbol->end > MEMORY_SIZE_8080){
+        symbol->end = MEMORY_SIZE_8080;
+    }
+    snprintf(symbol->name, sizeof(symbol->name), "%s", name);
+    return 1;
+}
+
+int compareSymbolAddresses(const void *first, const void *second)
+{
+    return (int)((const RomSymbol *)first)->address-(int)((const RomSymbol *)second)->address;
+}
@@ -0,0 +1,69 @@
+/***********************************************************************************
+ *
+ * Header for ROM symbol maps.
+ *
+ * A symbol file names routines of a ROM, one per line: an address in hex, a name, and
+ * optionally a size in hex. Anything after a ';' is a comment. A symbol without a size
+ * runs up to the next symbol, or to the end of ROM. The symbols are kept sorted by
+ * address, so the symbol covering any address is found by binary search. A map is never
+ * changed once loaded, so one map can be shared by any number of arcades and threads.
+ * resources/invaders.sym names the Space Invaders routines documented at
+ * http://computerarcheology.com/Arcade/SpaceInvaders/
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#ifndef INTEL_8080_EMULATOR_SYMBOLMAP_H
+#define INTEL_8080_EMULATOR_SYMBOLMAP_H
+
+#include "cpuStructures.h"
+
+#define SYMBOL_NAME_LENGTH 48
+#define DEFAULT_SYMBOL_PATH "resources/invaders.sym"
+
+/**
+ * A named range of ROM
+ */
+typedef struct RomSymbol{
+    uint16_t address;
+    uint32_t end;  /**< One past the last address covered */
+    char name[SYMBOL_NAME_LENGTH];
+} RomSymbol;
+
+typedef struct SymbolMap{
+    RomSymbol *symbols;  /**< Sorted by address */
+    uint32_t numSymbols;
+} SymbolMap;
+
+/**
+ * Loads a symbol file
+ * @param path - Path of the symbol file
+ * @return - pointer to the map, or NULL if the file could not be read
+ */
+SymbolMap *loadSymbolMap(const char *path);
+
+/**
+ * Frees a symbol map
+ * @param map - The map, may be NULL
+ */
+void destroySymbolMap(SymbolMap *map);
+
+/**
+ * Finds the symbol covering an address
+ * @param map - The map, may be NULL
+ * @param address - The address
+ * @return - The symbol, or NULL if no symbol covers the address
+ */
+const RomSymbol *findSymbol(const SymbolMap *map, uint16_t address);
+
+/**
+ * Writes an address relative to the symbol covering it, e.g. "BlockCopy+0x3",
+ * or "$1a35" if there is none
+ * @param map - The map, may be NULL
+ * @param address - The address
+ * @param text - Buffer for the text
+ * @param textSize - Size of the buffer
+ */
+void formatSymbolAddress(const SymbolMap *map, uint16_t address, char *text, size_t textSize);
+
+#endif //INTEL_8080_EMULATOR_SYMBOLMAP_H
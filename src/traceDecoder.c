@@ -0,0 +1,115 @@
+/***********************************************************************************
+ *
+ * Prints a binary instruction trace, as written with --trace, one line per record.
+ *
+ * Each line shows the cycle count, the address, the instruction disassembled and the
+ * registers, SP, flags and interrupt enable before the instruction ran. Interrupts are
+ * shown where they were taken. With --symbols, addresses are also shown relative to the
+ * routine they are in.
+ *
+ * Usage: trace_decoder TRACE [--skip N] [--count N] [--symbols FILE]
+ * --skip N        Records to skip before printing
+ * --count N       Records to print, all of them by default
+ * --symbols FILE  Symbol map to label addresses with, e.g. resources/invaders.sym
+ * @Author: Andrew Gunter
+ *
+***********************************************************************************/
+
+#include "shell8080.h"
+#include "helpers.h"
+#include "instructionTrace.h"
+#include "symbolMap.h"
+
+void printTraceRecord(const TraceRecord *record, State8080 *scratch, const SymbolMap *symbols);
+
+int main(int argc, char **argv)
+{
+    if(argc < 2){
+        logger("Usage: %s TRACE [--skip N] [--count N] [--symbols FILE]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t numSkipped = 0;
+    uint64_t numToPrint = UINT64_MAX;
+    const char *symbolPath = NULL;
+    for(int argNum = 2; argNum < argc; argNum++){
+        if(strcmp(argv[argNum], "--skip") == 0 && argNum+1 < argc){
+            argNum++;
+            numSkipped = strtoull(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--count") == 0 && argNum+1 < argc){
+            argNum++;
+            numToPrint = strtoull(argv[argNum], NULL, 10);
+        }else if(strcmp(argv[argNum], "--symbols") == 0 && argNum+1 < argc){
+            argNum++;
+            symbolPath = argv[argNum];
+        }else{
+            logger("Usage: %s TRACE [--skip N] [--count N] [--symbols FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Instructions are disassembled from a scratch CPU's memory
+    uint8_t *emptyRom = mallocSet(ROM_LIMIT_8080);
+    State8080 *scratch = initializeCPU(emptyRom);
+    free(emptyRom);
+    SymbolMap *symbols = NULL;
+    if(symbolPath != NULL && (symbols = loadSymbolMap(symbolPath)) == NULL){
+        destroyCPU(scratch);
+        return 1;
+    }
+    TraceReader *reader = initializeTraceReader(argv[1]);
+    if(reader == NULL){
+        destroySymbolMap(symbols);
+        destroyCPU(scratch);
+        return 1;
+    }
+
+    TraceRecord record;
+    uint64_t numRecords = 0;
+    uint64_t numPrinted = 0;
+    while(numPrinted < numToPrint && readTraceRecord(reader, &record) == 1){
+        if(numRecords >= numSkipped){
+            printTraceRecord(&record, scratch, symbols);
+            numPrinted++;
+        }
+        numRecords++;
+    }
+    logger("%llu records read, %llu printed\n", (unsigned long long)numRecords, (unsigned long long)numPrinted);
+
+    destroyTraceReader(reader);
+    destroySymbolMap(symbols);
+    destroyCPU(scratch);
+    return 0;
+}
+
+/**
+ * Prints one record
+ * @param record - The record
+ * @param scratch - CPU whose memory the instruction is placed in to disassemble it
+ * @param symbols - Symbol map to label the address with, or NULL
+ */
+void printTraceRecord(const TraceRecord *record, State8080 *scratch, const SymbolMap *symbols)
+{
+    char text[32];
+    if(record->interrupt){
+        snprintf(text, sizeof(text), "interrupt %u", record->interruptNum);
+    }else{
+        for(uint8_t byteNum = 0; byteNum < record->instructionSize; byteNum++){
+            scratch->memory[(uint16_t)(record->pc+byteNum)] = record->instruction[byteNum];
+        }
+        disassembleInstruction(scratch, record->pc, text, sizeof(text));
+    }
+
+    ConditionCodes flags;
+    memcpy(&flags, &(record->registers[7]), 1);
+    printf("%10u  %04x  ", record->cycles, record->pc);
+    if(symbols != NULL){
+        char label[SYMBOL_NAME_LENGTH+8];
+        formatSymbolAddress(symbols, record->pc, label, sizeof(label));
+        printf("%-24s  ", label);
+    }
+    printf("%-16s  A %02x B %02x C %02x D %02x E %02x H %02x L %02x SP %04x  z%u s%u p%u cy%u ac%u  IE %u\n",
+           text, record->registers[0], record->registers[1], record->registers[2], record->registers[3],
+           record->registers[4], record->registers[5], record->registers[6], record->sp,
+           flags.zero, flags.sign, flags.parity, flags.carry, flags.auxiliaryCarry, record->interruptsEnabled);
+}